@@ -16,18 +16,38 @@ class Texture2D {
    public:
       Texture2D() = default;
       Texture2D(const uint8_t* data, const TextureSpecs& specs);
+      ~Texture2D();
 
-      void Bind() const;
-      void UnBind() const;
+      // Owns the GL texture, so it can only be moved, share it through a TextureHandle instead
+      Texture2D(const Texture2D&) = delete;
+      Texture2D& operator=(const Texture2D&) = delete;
+      Texture2D(Texture2D&& other) noexcept;
+      Texture2D& operator=(Texture2D&& other) noexcept;
+
+      // Takes over a texture filled elsewhere, e.g. streamed in by TextureCache, and deletes the current one.
+      // specs.format is the pixel format, compressed_size the data size of a block compressed texture.
+      void Adopt(uint32_t texture, const TextureSpecs& specs, size_t compressed_size = 0);
+
+      void Bind(uint32_t unit = 0) const;
+      void UnBind(uint32_t unit = 0) const;
 
       uint32_t GetWidth() const { return mSpecs.width; }
       uint32_t GetHeight() const { return mSpecs.height; }
 
       std::string GetName() const { return mSpecs.type; }
       std::string GetPath() const { return mSpecs.path; }
+
+      // Estimated VRAM footprint including the mip chain
+      size_t GetMemorySize() const;
+
+      // 1x1 grey texture meshes can sample until the real image is uploaded
+      static Texture2D CreatePlaceholder(const std::string& path);
+      // BC1/BC3 need EXT_texture_compression_s3tc, BC5 (RGTC) is core
+      static bool SupportsBlockCompression();
    private:
-      uint32_t mRendererID;
-      TextureSpecs mSpecs;
+      uint32_t mRendererID = 0;
+      TextureSpecs mSpecs{};
+      size_t mCompressedSize = 0;
    };
 
 }
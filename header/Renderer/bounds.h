@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Renderer/vertex_buffer.h>
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <span>
+
+namespace OGLR {
+
+    struct AABB {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+
+        bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+        glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+        float GetSurfaceArea() const {
+            if (!IsValid())
+                return 0.0f;
+            glm::vec3 size = max - min;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        void Expand(const glm::vec3& point) {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void Expand(const AABB& other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        // Box around the transformed box, extents go through the absolute rotation/scale part
+        AABB Transform(const glm::mat4& matrix) const {
+            if (!IsValid())
+                return *this;
+            glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+            glm::mat3 linear = glm::mat3(matrix);
+            glm::vec3 extents = glm::mat3(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2])) * GetExtents();
+            return { center - extents, center + extents };
+        }
+    };
+
+    // Centered on the mesh's AABB so culling can test both against one center
+    struct BoundingSphere {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+
+        BoundingSphere Transform(const glm::mat4& matrix) const {
+            float scale = glm::max(glm::length(glm::vec3(matrix[0])), glm::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+            return { glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale };
+        }
+    };
+
+    inline AABB ComputeAABB(std::span<const Vertex> vertices) {
+        AABB box;
+        for (const Vertex& vertex : vertices)
+            box.Expand(vertex.position);
+        return box;
+    }
+
+    inline BoundingSphere ComputeBoundingSphere(std::span<const Vertex> vertices, const AABB& box) {
+        BoundingSphere sphere;
+        if (!box.IsValid())
+            return sphere;
+        sphere.center = box.GetCenter();
+        float radius_squared = 0.0f;
+        for (const Vertex& vertex : vertices) {
+            glm::vec3 offset = vertex.position - sphere.center;
+            radius_squared = glm::max(radius_squared, glm::dot(offset, offset));
+        }
+        sphere.radius = glm::sqrt(radius_squared);
+        return sphere;
+    }
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Renderer/bounds.h>
+#include <Renderer/frustum_culler.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace OGLR {
+
+    struct Ray {
+        glm::vec3 origin = glm::vec3(0.0f);
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    };
+
+    struct RayHit {
+        uint32_t item = UINT32_MAX;
+        float distance = 0.0f;
+    };
+
+    // Bounding volume hierarchy over item AABBs, items are whatever the caller indexed the bounds by.
+    // Build uses binned SAH with the large subtrees split across the ThreadPool. Update refits only the
+    // path from one item to the root, so moving a few items never needs a rebuild. Refitting doesn't
+    // reorder anything though, rebuild after most of the scene moved far.
+    class BVH {
+    public:
+        inline static const uint32_t INVALID = UINT32_MAX;
+
+        void Build(std::span<const AABB> bounds);
+        void Update(uint32_t item, const AABB& bounds);
+
+        // Replaces visible with every item touching the frustum. Subtrees entirely inside are taken
+        // without testing their items.
+        void CullFrustum(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+        // Closest item box along the ray, direction doesn't need to be normalized but distances are
+        // measured in its length
+        bool Raycast(const Ray& ray, RayHit& hit, float max_distance = FLT_MAX) const;
+        // Replaces items with every item whose box intersects the sphere
+        void OverlapSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& items) const;
+
+        uint32_t GetItemCount() const { return static_cast<uint32_t>(mItemBounds.size()); }
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(mNodes.size()); }
+        const AABB& GetItemBounds(uint32_t item) const { return mItemBounds[item]; }
+        // Bounds of the whole hierarchy, invalid when empty
+        AABB GetBounds() const { return mNodes.empty() ? AABB() : mNodes[0].bounds; }
+    private:
+        struct Node {
+            AABB bounds;
+            uint32_t left = INVALID;
+            uint32_t right = INVALID;
+            uint32_t parent = INVALID;
+            // Leaves own mItems[first, first + count), interior nodes have count 0
+            uint32_t first = 0;
+            uint32_t count = 0;
+
+            bool IsLeaf() const { return count > 0; }
+        };
+
+        // Range of mItems whose subtree is built on a worker and stitched in at node afterwards
+        struct DeferredSubtree {
+            uint32_t node;
+            uint32_t begin;
+            uint32_t end;
+            std::vector<Node> nodes;
+        };
+
+        uint32_t buildRange(std::vector<Node>& nodes, uint32_t begin, uint32_t end, uint32_t parent, std::vector<DeferredSubtree>* deferred);
+        // Returns the split position in mItems or begin when the range should stay a leaf
+        uint32_t splitRange(uint32_t begin, uint32_t end, const AABB& bounds);
+        void stitch(DeferredSubtree& subtree);
+        void appendSubtree(uint32_t node, std::vector<uint32_t>& items) const;
+    private:
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mItems;
+        std::vector<uint32_t> mItemLeaf;
+        std::vector<AABB> mItemBounds;
+        std::vector<glm::vec3> mCentroids;
+        // Ranges at most this large are built as separate tasks
+        uint32_t mDeferThreshold = 0;
+    };
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Renderer/bounds.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace OGLR {
+
+    struct Frustum {
+        // left, right, bottom, top, near, far. xyz points inwards and is normalized, w is the distance.
+        glm::vec4 planes[6];
+
+        // Works for any view/projection pair, pass proj * view for world space planes
+        static Frustum FromMatrix(const glm::mat4& view_proj);
+    };
+
+    // Structure of arrays over world space bounds so the culler loads 4 or 8 objects per register.
+    // The arrays are padded to a multiple of 8, padding lanes are never reported.
+    class CullingBounds {
+    public:
+        void Resize(uint32_t count);
+        void Set(uint32_t index, const AABB& box, const BoundingSphere& sphere);
+
+        uint32_t GetCount() const { return mCount; }
+        glm::vec3 GetCenter(uint32_t index) const { return { mCenterX[index], mCenterY[index], mCenterZ[index] }; }
+    private:
+        friend class FrustumCuller;
+
+        uint32_t mCount = 0;
+        std::vector<float> mCenterX, mCenterY, mCenterZ;
+        std::vector<float> mExtentX, mExtentY, mExtentZ;
+        std::vector<float> mRadius;
+    };
+
+    struct CullingStats {
+        // Objects that reached a test, BVH::CullFrustum leaves out the ones under culled nodes
+        uint64_t tested = 0;
+        uint64_t visible = 0;
+        // Hierarchy nodes tested by BVH::CullFrustum, 0 for the flat paths
+        uint64_t nodesVisited = 0;
+    };
+
+    class FrustumCuller {
+    public:
+        // Replaces visible with the indices of every object touching the frustum, in index order
+        static uint32_t Cull(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint32_t>& visible);
+        // One object at a time, the reference the SIMD path is benchmarked against
+        static uint32_t CullScalar(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint32_t>& visible);
+
+        // "AVX", "SSE" or "scalar", whichever Cull was compiled with
+        static const char* GetInstructionSet();
+
+        static const CullingStats& GetStats() { return mStats; }
+        static void ResetStats() { mStats = {}; }
+        // Lets other culling paths report into the same totals
+        static void AddStats(const CullingStats& stats) {
+            mStats.tested += stats.tested;
+            mStats.visible += stats.visible;
+            mStats.nodesVisited += stats.nodesVisited;
+        }
+    private:
+        inline static CullingStats mStats;
+    };
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <Renderer/index_packer.h>
+#include <Renderer/mesh_cache.h>
+#include <Renderer/vertex_array.h>
+#include <Renderer/vertex_buffer.h>
+#include <Renderer/vertex_quantization.h>
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace OGLR {
+
+    // First fit suballocator over [0, capacity), freed ranges merge with their neighbours
+    class RangeAllocator {
+    public:
+        inline static const uint32_t INVALID = UINT32_MAX;
+
+        RangeAllocator(uint32_t capacity);
+
+        // Returns INVALID when no free range is large enough, Grow and try again.
+        // The returned offset is a multiple of alignment, the skipped part stays free.
+        uint32_t Allocate(uint32_t size, uint32_t alignment = 1);
+        void Free(uint32_t offset, uint32_t size);
+        void Grow(uint32_t capacity);
+
+        uint32_t GetCapacity() const { return mCapacity; }
+        uint32_t GetUsed() const { return mUsed; }
+    private:
+        void insertFree(uint32_t offset, uint32_t size);
+    private:
+        struct Range {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        // Sorted by offset and never adjacent, adjacent ranges are merged on Free
+        std::vector<Range> mFree;
+        uint32_t mCapacity;
+        uint32_t mUsed = 0;
+    };
+
+    // Where a mesh lives inside the arena, in vertices and 16 bit index slots rather than bytes.
+    // The chunks are ready to draw, firstIndex and baseVertex already point into the arena.
+    struct GeometryRange {
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexSlotOffset = 0;
+        uint32_t indexSlotCount = 0;
+        // LOD i draws chunks [lodChunks[i], lodChunks[i + 1]), see PackedIndices
+        std::vector<IndexChunk> chunks;
+        std::vector<uint32_t> lodChunks;
+        // Identity unless the arena stores quantized vertices, pass along with the model matrix
+        VertexDequantization dequantization;
+    };
+
+    // A mesh already converted to the arena's vertex format and index packing, made off the GL thread
+    // by GeometryArena::Prepare and uploaded a budget at a time by GeometryArena::Upload
+    struct StagedGeometry {
+        // Uploaded as is unless quantized holds the converted copy
+        std::span<const Vertex> vertices;
+        std::vector<QuantizedVertex> quantized;
+        VertexDequantization dequantization;
+        PackedIndices packed;
+        // Vertex bytes come first, then the index slots
+        uint32_t uploadedBytes = 0;
+
+        uint32_t GetVertexBytes() const;
+        uint32_t GetSize() const { return GetVertexBytes() + static_cast<uint32_t>(packed.slots.size() * sizeof(uint16_t)); }
+    };
+
+    struct GeometryArenaStats {
+        // Since creation, each one copies the whole buffer
+        uint32_t vertexGrows = 0;
+        uint32_t indexGrows = 0;
+    };
+
+    // One vertex buffer, one index buffer and one VAO shared by every mesh, so any set of meshes
+    // can be drawn with a single glMultiDrawElementsIndirect. Create one right after the GL
+    // context and keep it alive longer than any Mesh. Meshes are always handed over as Vertex,
+    // a quantized arena converts them against their own bounds on the way in. Indices are handed
+    // over as uint32_t and stored as 16 bit wherever IndexPacker finds they fit, the index buffer
+    // holds both types side by side and each draw names its own.
+    class GeometryArena {
+    public:
+        GeometryArena(VertexFormat format = VertexFormat::FLOAT32, uint32_t vertex_capacity = 1 << 18, uint32_t index_slot_capacity = 1 << 21);
+        ~GeometryArena();
+
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+
+        static GeometryArena& Get() { return *mCurrent; }
+
+        // indices holds every LOD back to back as described by lods, see MeshData
+        GeometryRange Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const MeshLOD> lods);
+
+        // Allocate in steps, for meshes streamed in over several frames. Prepare does the CPU work and is safe
+        // on any thread, vertices must outlive the upload. Reserve places the mesh, its range can't be drawn
+        // until Upload, which copies within the StagingUploader budget, returns true.
+        static void Prepare(VertexFormat format, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                            std::span<const MeshLOD> lods, StagedGeometry& staged);
+        GeometryRange Reserve(const StagedGeometry& staged);
+        bool Upload(StagedGeometry& staged, const GeometryRange& range);
+        void Free(const GeometryRange& range);
+
+        const VertexArray& GetVertexArray() const { return mVAO; }
+        VertexFormat GetVertexFormat() const { return mFormat; }
+        uint32_t GetVertexStride() const { return mStride; }
+
+        uint32_t GetVertexCapacity() const { return mVertices.GetCapacity(); }
+        uint32_t GetIndexSlotCapacity() const { return mIndices.GetCapacity(); }
+        uint32_t GetUsedVertices() const { return mVertices.GetUsed(); }
+        uint32_t GetUsedIndexSlots() const { return mIndices.GetUsed(); }
+        const GeometryArenaStats& GetStats() const { return mStats; }
+    private:
+        // Replaces the buffer with a larger one holding the same contents
+        static uint32_t growBuffer(uint32_t buffer, uint32_t old_size, uint32_t new_size);
+        void attachBuffers();
+    private:
+        VertexArray mVAO;
+        VertexFormat mFormat;
+        uint32_t mStride;
+        uint32_t mVertexBufferID = 0;
+        uint32_t mIndexBufferID = 0;
+        RangeAllocator mVertices;
+        // In 16 bit slots
+        RangeAllocator mIndices;
+        GeometryArenaStats mStats;
+
+        inline static GeometryArena* mCurrent = nullptr;
+    };
+
+    // Owns one allocation in the current GeometryArena
+    class MeshGeometry {
+    public:
+        MeshGeometry(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const MeshLOD> lods)
+            :mRange(GeometryArena::Get().Allocate(vertices, indices, lods)), mOwned(true) {}
+        // Takes over a range from GeometryArena::Reserve
+        explicit MeshGeometry(GeometryRange range)
+            :mRange(std::move(range)), mOwned(true) {}
+        ~MeshGeometry() { if (mOwned) GeometryArena::Get().Free(mRange); }
+
+        MeshGeometry(const MeshGeometry&) = delete;
+        MeshGeometry& operator=(const MeshGeometry&) = delete;
+        MeshGeometry(MeshGeometry&& other) noexcept :mRange(other.mRange), mOwned(other.mOwned) { other.mOwned = false; }
+        MeshGeometry& operator=(MeshGeometry&& other) noexcept {
+            std::swap(mRange, other.mRange);
+            std::swap(mOwned, other.mOwned);
+            return *this;
+        }
+
+        const GeometryRange& Get() const { return mRange; }
+    private:
+        GeometryRange mRange;
+        bool mOwned;
+    };
+
+}
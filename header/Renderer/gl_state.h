@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace OGLR {
+
+    struct GLStateStats {
+        uint64_t issued = 0;
+        // Calls dropped because GL already had that state
+        uint64_t elided = 0;
+    };
+
+    // Shadow of the GL state the engine changes per frame, every setter forwards only real changes.
+    // All binding of programs, vertex arrays, textures and framebuffers goes through here, anything
+    // that touches them behind its back has to call Invalidate. Textures are bound with
+    // glBindTextureUnit and the active texture unit is never changed, it stays 0 for uploads.
+    class GLState {
+    public:
+        inline static const uint32_t MAX_TEXTURE_UNITS = 32;
+
+        static void UseProgram(uint32_t program);
+        static void BindVertexArray(uint32_t vertex_array);
+        static void BindTexture(uint32_t unit, uint32_t texture);
+        // GL_FRAMEBUFFER sets both the draw and the read binding
+        static void BindFramebuffer(uint32_t target, uint32_t framebuffer);
+
+        static void Viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+        static void ClearColor(const glm::vec4& color);
+        static void SetEnabled(uint32_t capability, bool enabled);
+        // Front and back
+        static void PolygonMode(uint32_t mode);
+        static void PointSize(float size);
+
+        // Deleting a bound object reverts the binding to 0 in GL, the names get recycled afterwards
+        static void ForgetVertexArray(uint32_t vertex_array);
+        static void ForgetTexture(uint32_t texture);
+        static void ForgetFramebuffer(uint32_t framebuffer);
+
+        // Forgets everything, the next call of each setter goes through
+        static void Invalidate() { mState = {}; }
+
+        static const GLStateStats& GetStats() { return mStats; }
+        static void ResetStats() { mStats = {}; }
+    private:
+        template <typename T>
+        static bool update(T& cached, const T& value) {
+            if (cached == value) {
+                mStats.elided++;
+                return false;
+            }
+            cached = value;
+            mStats.issued++;
+            return true;
+        }
+    private:
+        // UNKNOWN never matches a real name or value
+        inline static const uint32_t UNKNOWN = UINT32_MAX;
+
+        struct State {
+            uint32_t program = UNKNOWN;
+            uint32_t vertexArray = UNKNOWN;
+            uint32_t textures[MAX_TEXTURE_UNITS];
+            uint32_t drawFramebuffer = UNKNOWN;
+            uint32_t readFramebuffer = UNKNOWN;
+            glm::ivec4 viewport = glm::ivec4(-1);
+            glm::vec4 clearColor = glm::vec4(-1.0f);
+            uint32_t polygonMode = UNKNOWN;
+            float pointSize = -1.0f;
+            // Capabilities seen so far, anything missing is unknown
+            std::vector<std::pair<uint32_t, bool>> capabilities;
+
+            State() { std::fill(std::begin(textures), std::end(textures), UNKNOWN); }
+        };
+
+        inline static State mState;
+        inline static GLStateStats mStats;
+    };
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace OGLR {
+
+    // GPU time between Begin and End through GL_TIME_ELAPSED queries. Results are read LATENCY
+    // timings later, by then the GPU has long finished them and reading never stalls.
+    // Timings can't nest, one query of this kind can be active at a time.
+    class GpuTimer {
+    public:
+        inline static const uint32_t LATENCY = 4;
+
+        GpuTimer();
+        ~GpuTimer();
+
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        void Begin();
+        void End();
+        // Waits for every timing still in flight
+        void Flush();
+
+        // Milliseconds of every timing read back so far, in the order they were taken
+        const std::vector<double>& GetResults() const { return mResults; }
+        // Forgets the results read so far, for callers that take them as they come
+        void ClearResults() { mResults.clear(); }
+    private:
+        void collect(uint32_t slot);
+    private:
+        uint32_t mQueries[LATENCY];
+        bool mPending[LATENCY] = {};
+        uint32_t mNext = 0;
+        std::vector<double> mResults;
+    };
+
+}
@@ -5,16 +5,34 @@
 
 namespace OGLR {
 
+    enum class IndexType : uint32_t {
+        UINT16,
+        UINT32
+    };
+
+    inline uint32_t GetIndexSize(IndexType type) { return type == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, what glDrawElements* expects as its type
+    uint32_t GetGLIndexType(IndexType type);
+
     class IndexBuffer {
     public:
         IndexBuffer() = default;
+        IndexBuffer(const std::vector<uint16_t>& data);
         IndexBuffer(const std::vector<uint32_t>& data);
+        IndexBuffer(const uint16_t* data, uint32_t count);
+        IndexBuffer(const uint32_t* data, uint32_t count);
 
         void Bind() const;
         void UnBind() const;
 
+        IndexType GetType() const { return mType; }
+        uint32_t GetCount() const { return mCount; }
+    private:
+        void create(const void* data, uint32_t count, IndexType type);
     private:
         uint32_t mRendererID;
+        IndexType mType = IndexType::UINT32;
+        uint32_t mCount = 0;
     };
 
 }
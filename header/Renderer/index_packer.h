@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Renderer/index_buffer.h>
+#include <Renderer/mesh_cache.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace OGLR {
+
+    // One draw's worth of indices sharing a type. firstIndex counts in elements of that type from the
+    // start of the packed data and baseVertex is added to every index, both relative to the mesh.
+    struct IndexChunk {
+        IndexType type;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t baseVertex;
+    };
+
+    // A mesh's indices as uploaded, in 16 bit slots. A 32 bit run takes two slots and starts on an
+    // even one, so the data stays addressable as either type as long as it is placed on an even slot.
+    struct PackedIndices {
+        std::vector<uint16_t> slots;
+        std::vector<IndexChunk> chunks;
+        // LOD i draws chunks [lodChunks[i], lodChunks[i + 1])
+        std::vector<uint32_t> lodChunks;
+    };
+
+    class IndexPacker {
+    public:
+        // A 16 bit chunk can reach this many vertices past its base vertex
+        inline static const uint32_t MAX_CHUNK_VERTEX_SPAN = UINT16_MAX;
+        // Splitting a LOD that spans more than that only pays while the chunks stay this large,
+        // every chunk is one more indirect draw
+        inline static const uint32_t MIN_INDICES_PER_CHUNK = 3 * 1024;
+
+        // Each LOD becomes one 16 bit chunk when its vertex range fits, several when it can be cut into
+        // large enough windows that do, and a single 32 bit chunk otherwise. Triangles keep their order.
+        static void Pack(std::span<const uint32_t> indices, std::span<const MeshLOD> lods, PackedIndices& packed);
+    };
+
+}
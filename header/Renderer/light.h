@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace OGLR {
+
+    struct DirectionalLight {
+        glm::vec3 direction;
+        glm::vec3 color;
+        float intensity;
+    };
+
+    struct PointLight {
+        glm::vec3 position;
+        glm::vec3 color;
+        float intensity;
+    };
+
+}
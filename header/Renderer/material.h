@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Renderer/shader.h>
+#include <Renderer/texture_cache.h>
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OGLR {
+
+    struct MeshTexture {
+        std::string type;
+        TextureHandle texture;
+    };
+
+    // Meshes that share a material share one of these, its ID is what the render queue sorts on
+    class Material {
+    public:
+        Material(const std::vector<MeshTexture>& textures)
+            :mID(mNextID++), mTextures(textures) {
+            // Samplers are named after their type and rank within it: texture_diffuse1, texture_specular1, ...
+            std::unordered_map<std::string, uint32_t> type_counts;
+            for (const MeshTexture& texture : mTextures)
+                mSamplerNames.push_back(texture.type + std::to_string(++type_counts[texture.type]));
+            mSpecularMap = type_counts.contains("texture_specular");
+            mNormalMap = type_counts.contains("texture_normal");
+        }
+
+        Material(const Material&) = delete;
+        Material& operator=(const Material&) = delete;
+
+        uint32_t GetID() const { return mID; }
+        const std::vector<MeshTexture>& GetTextures() const { return mTextures; }
+        bool HasSpecularMap() const { return mSpecularMap; }
+        bool HasNormalMap() const { return mNormalMap; }
+
+        // Expects the shader to be bound already
+        void Bind(Shader* shader) {
+            // Handles are resolved once per shader instead of looking names up every bind
+            if (shader->GetID() != mUniformShaderID)
+                resolveUniforms(shader);
+
+            for (uint32_t i = 0; i < mTextures.size(); i++) {
+                mTextures[i].texture->Bind(i);
+                shader->SetUniform(mSamplerUniforms[i], static_cast<int>(i));
+            }
+        }
+    private:
+        void resolveUniforms(const Shader* shader) {
+            mSamplerUniforms.clear();
+            for (const std::string& name : mSamplerNames)
+                mSamplerUniforms.push_back(shader->GetUniform<int>(name));
+            mUniformShaderID = shader->GetID();
+        }
+    private:
+        uint32_t mID;
+        std::vector<MeshTexture> mTextures;
+        bool mSpecularMap = false;
+        bool mNormalMap = false;
+
+        std::vector<std::string> mSamplerNames;
+        uint32_t mUniformShaderID = 0;
+        std::vector<UniformHandle<int>> mSamplerUniforms;
+
+        inline static uint32_t mNextID = 1;
+    };
+
+    // The programs one submission draws with, picked per material. Resolve them on the GL thread before
+    // submitting, e.g. through ShaderVariants, workers only choose between them.
+    struct MaterialShaders {
+        Shader* specularMapped = nullptr;
+        // Compiled without the specular map, specularMapped draws these too when not set
+        Shader* unmapped = nullptr;
+        // The same two compiled with the normal map, materials that have one skip it when these aren't set
+        Shader* normalSpecularMapped = nullptr;
+        Shader* normalMapped = nullptr;
+
+        Shader* Select(const Material& material) const {
+            if (material.HasNormalMap() && normalSpecularMapped)
+                return material.HasSpecularMap() || !normalMapped ? normalSpecularMapped : normalMapped;
+            return material.HasSpecularMap() || !unmapped ? specularMapped : unmapped;
+        }
+    };
+
+}
@@ -1,84 +1,117 @@
 #pragma once
 
-#include <glad/glad.h> // holds all OpenGL type declarations
-
 #include <glm/glm.hpp>
 
+#include <Renderer/bounds.h>
+#include <Renderer/geometry_arena.h>
+#include <Renderer/material.h>
+#include <Renderer/mesh_simplifier.h>
+#include <Renderer/render_queue.h>
 #include <Renderer/shader.h>
-#include <Renderer/vertex_array.h>
-#include <Renderer/Texture2D.h>
+#include <Renderer/uniform_buffer.h>
 
 #include <iostream>
-#include <string>
 #include <vector>
 #include <memory>
+#include <span>
 
 namespace OGLR {
 
+    // How far a LOD may move the surface on screen before a finer one is picked
+    struct LODSelection {
+        // Pixels per object space unit at view depth 1, proj[1][1] * viewport height / 2. 0 keeps full detail.
+        float pixelScale = 0.0f;
+        float maxPixelError = 1.0f;
+
+        static LODSelection FromProjection(const glm::mat4& proj, float viewport_height, float max_pixel_error = 1.0f) {
+            return { proj[1][1] * viewport_height * 0.5f, max_pixel_error };
+        }
+    };
+
+    struct LODStats {
+        uint64_t trianglesDrawn = 0;
+        // What the same draws would have cost at LOD 0
+        uint64_t trianglesFullDetail = 0;
+        uint32_t meshesPerLevel[MeshSimplifier::MAX_LODS] = {};
+    };
+
     class Mesh {
     public:
-        Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<Texture2D>& textures)
-            :mVertices(vertices), mIndices(indices), mTextures(textures) {
-            mVAO = std::make_unique<VertexArray>();
-            mVAO->Bind();
-            mVBO = std::make_unique<VertexBuffer>(vertices);
-            mEBO = std::make_unique<IndexBuffer>(indices);
-            setupMesh();
+        // The vertex/index memory is only read during construction, it can be a mapped cache file.
+        // indices holds every LOD back to back as described by lods, see MeshData.
+        Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const MeshLOD> lods,
+             const std::shared_ptr<Material>& material)
+            :mMaterial(material), mGeometry(vertices, indices, lods), mLODs(lods.begin(), lods.end()),
+             mBounds(ComputeAABB(vertices)), mBoundingSphere(ComputeBoundingSphere(vertices, mBounds)) {
+        }
+        // For geometry streamed into the arena ahead of time, see GeometryArena::Reserve
+        Mesh(std::span<const Vertex> vertices, std::span<const MeshLOD> lods, const std::shared_ptr<Material>& material,
+             MeshGeometry geometry)
+            :mMaterial(material), mGeometry(std::move(geometry)), mLODs(lods.begin(), lods.end()),
+             mBounds(ComputeAABB(vertices)), mBoundingSphere(ComputeBoundingSphere(vertices, mBounds)) {
         }
 
-        void Draw(Shader* shader, const glm::mat4& model, const glm::mat4& view, const glm::mat4& proj)  {
-            uint32_t diffuseNr  = 1;
-            uint32_t specularNr = 1;
-            uint32_t normalNr   = 1;
-            uint32_t shininessNr = 1;
-
-            shader->Bind();
-            for(uint32_t i = 0; i < mTextures.size(); i++) {
-                glActiveTexture(GL_TEXTURE0 + i);
-                mTextures[i].Bind();
-                std::string number;
-                std::string name = mTextures[i].GetName();
-                if(name == "texture_diffuse")
-                    number = std::to_string(diffuseNr++);
-                else if(name == "texture_specular")
-                    number = std::to_string(specularNr++);
-                else if(name == "texture_normal")
-                    number = std::to_string(normalNr++);
-                else if(name == "texture_shininess")
-                    number = std::to_string(shininessNr++);
-
-                shader->SetUniform1i(std::string(name + number), i);
-            }
-            glm::mat4 mvp = proj * view * model;
-            glm::mat4 mv = view * model;
-            glm::mat4 mv_norm = glm::transpose(glm::inverse(mv));
-
-            shader->SetUniformMatrix4("mvMatrix", mv);
-            shader->SetUniformMatrix4("normalMatrix", mv_norm);
-            shader->SetUniformMatrix4("mvp", mvp);
-            mVAO->Bind();
-            glDrawElements(GL_TRIANGLES, static_cast<uint32_t>(mIndices.size()), GL_UNSIGNED_INT, nullptr);
-            mVAO->UnBind();
-            shader->UnBind();
-            for(uint32_t i = 0; i < mTextures.size(); i++) {
-                mTextures[i].UnBind();
+        const std::shared_ptr<Material>& GetMaterial() const { return mMaterial; }
+        const GeometryRange& GetGeometry() const { return mGeometry.Get(); }
+        // Object space, Model keeps the world space copies the culler reads
+        const AABB& GetBounds() const { return mBounds; }
+        const BoundingSphere& GetBoundingSphere() const { return mBoundingSphere; }
+
+        // The per-object block holds this mesh's transform, set it through GetObjectSlot()
+        const ObjectSlot& GetObjectSlot() const { return mObject; }
+
+        const std::vector<MeshLOD>& GetLODs() const { return mLODs; }
+        // Coarsest LOD whose error stays under max_pixel_error, pixels_per_unit is the object space scale at the mesh
+        uint32_t SelectLOD(float pixels_per_unit, float max_pixel_error) const {
+            uint32_t lod = 0;
+            while (lod + 1 < mLODs.size() && mLODs[lod + 1].error * pixels_per_unit <= max_pixel_error)
+                lod++;
+            return lod;
+        }
+
+        // Binding and drawing happen in RenderQueue::Execute, sorted against every other submitted mesh
+        // Safe from any thread with its own list and stats, see Mesh::AddLODStats
+        void Submit(DrawList& list, RenderPass pass, const MaterialShaders& shaders, float view_depth, uint32_t lod, LODStats& stats) const {
+            // Usually one chunk, meshes spanning more than 16 bits of vertices may have been cut into several
+            const GeometryRange& geometry = mGeometry.Get();
+            DrawCommand command;
+            command.shader = shaders.Select(*mMaterial);
+            command.material = mMaterial.get();
+            command.vertexArray = &GeometryArena::Get().GetVertexArray();
+            command.object = mObject.Get();
+            for (uint32_t chunk = geometry.lodChunks[lod]; chunk < geometry.lodChunks[lod + 1]; chunk++) {
+                command.indexType = geometry.chunks[chunk].type;
+                command.indexCount = geometry.chunks[chunk].indexCount;
+                command.firstIndex = geometry.chunks[chunk].firstIndex;
+                command.baseVertex = geometry.chunks[chunk].baseVertex;
+                list.Submit(pass, command, view_depth);
             }
+
+            stats.trianglesDrawn += mLODs[lod].indexCount / 3;
+            stats.trianglesFullDetail += mLODs[0].indexCount / 3;
+            stats.meshesPerLevel[lod]++;
         }
-    private:
-        void setupMesh() {
-            VertexLayout layout;
-            layout.Push<float>(3, false);
-            layout.Push<float>(3, false);
-            layout.Push<float>(2, false);
-            mVAO->AddVertexData(mVBO.get(), mEBO.get(), layout);
+
+        static const LODStats& GetLODStats() { return mLODStats; }
+        // Folds in what one batch of Submit calls counted, from the GL thread
+        static void AddLODStats(const LODStats& stats) {
+            mLODStats.trianglesDrawn += stats.trianglesDrawn;
+            mLODStats.trianglesFullDetail += stats.trianglesFullDetail;
+            for (uint32_t level = 0; level < MeshSimplifier::MAX_LODS; level++)
+                mLODStats.meshesPerLevel[level] += stats.meshesPerLevel[level];
         }
+        static void ResetLODStats() { mLODStats = {}; }
     private:
-        std::vector<Vertex>       mVertices;
-        std::vector<uint32_t> mIndices;
-        std::vector<Texture2D>      mTextures;
-        std::unique_ptr<VertexArray> mVAO;
-        std::unique_ptr<VertexBuffer> mVBO;
-        std::unique_ptr<IndexBuffer> mEBO;
+        std::shared_ptr<Material> mMaterial;
+        // Suballocated from the shared arena, every mesh draws with the same VAO
+        MeshGeometry mGeometry;
+        std::vector<MeshLOD> mLODs;
+
+        AABB mBounds;
+        BoundingSphere mBoundingSphere;
+        ObjectSlot mObject;
+
+        inline static LODStats mLODStats;
     };
 
 }
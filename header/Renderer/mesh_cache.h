@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Renderer/vertex_buffer.h>
+#include <mapped_file.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    struct MaterialTextureRef {
+        std::string type;
+        std::string path;
+    };
+
+    struct MaterialData {
+        std::vector<MaterialTextureRef> textures;
+    };
+
+    // One simplified index list of a mesh. The offset counts from the mesh's first index and
+    // error is the object space distance the simplifier estimates the surface moved by.
+    struct MeshLOD {
+        uint32_t indexOffset, indexCount;
+        float error;
+    };
+
+    // Offsets are in elements into ModelData::vertices / ModelData::indices / ModelData::lods.
+    // The index range holds every LOD back to back, LOD 0 is the full detail mesh.
+    struct MeshData {
+        uint32_t vertexOffset, vertexCount;
+        uint32_t indexOffset, indexCount;
+        uint32_t materialIndex;
+        uint32_t lodOffset, lodCount;
+    };
+
+    // CPU side geometry of a whole model, ready to be uploaded as is.
+    // vertices/indices either view the imported vectors or a mapped cache file.
+    struct ModelData {
+        std::vector<MeshData> meshes;
+        std::vector<MaterialData> materials;
+        std::vector<MeshLOD> lods;
+        std::span<const Vertex> vertices;
+        std::span<const uint32_t> indices;
+
+        std::vector<Vertex> importedVertices;
+        std::vector<uint32_t> importedIndices;
+        MappedFile mapping;
+    };
+
+    // Binary on-disk copy of an imported model, keyed by the source hash and the import flags
+    class MeshCache {
+    public:
+        inline static const uint32_t MAGIC = 0x4D4C474F; // "OGLM"
+        inline static const uint32_t VERSION = 4;
+
+        // The model file's contents plus, for an .obj, the size and modification time of every .mtl it names
+        static uint64_t HashSource(const std::string& path);
+        static std::string GetCachePath(const std::string& source_path) { return source_path + ".oglrcache"; }
+
+        static bool Load(const std::string& cache_path, uint64_t source_hash, uint32_t import_flags, ModelData& data);
+        static bool Write(const std::string& cache_path, uint64_t source_hash, uint32_t import_flags, const ModelData& data);
+    };
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Renderer/vertex_buffer.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace OGLR {
+
+    // Simulated FIFO post-transform cache, ACMR is transformed vertices per triangle (0.5 is the
+    // ideal for a regular grid, 3 means no reuse) and ATVR per unique vertex (1 is ideal)
+    struct VertexCacheStats {
+        uint32_t transformed = 0;
+        float acmr = 0.0f;
+        float atvr = 0.0f;
+    };
+
+    // Import time passes over a single mesh, meant to run in the order they are declared
+    class MeshOptimizer {
+    public:
+        inline static const uint32_t CACHE_SIZE = 16;
+        // Clusters sorted for overdraw may cost this much ACMR over the cache optimized order
+        inline static constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+        // Merges bit identical vertices through a hash of the whole Vertex, indices are rewritten in place
+        static void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        // Tipsify (Sander et al. 2007), clusters receives the first triangle of every run that started over
+        // after the ordering hit a dead end, the natural units to reorder for overdraw
+        static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count, std::vector<uint32_t>* clusters = nullptr);
+
+        // Draws the clusters facing away from the mesh center first, they are the likeliest to occlude the rest.
+        // Clusters that came out too small for the cache are merged first so the ACMR stays within the threshold.
+        static void OptimizeOverdraw(std::vector<uint32_t>& indices, std::span<const Vertex> vertices, std::span<const uint32_t> clusters);
+
+        // Orders vertices by first use so fetches walk memory forwards, unreferenced vertices are dropped
+        static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        static VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t cache_size = CACHE_SIZE);
+    };
+
+}
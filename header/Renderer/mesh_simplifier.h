@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Renderer/mesh_cache.h>
+#include <Renderer/vertex_buffer.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace OGLR {
+
+    // Quadric error metric edge collapse (Garland-Heckbert). Vertices only ever collapse onto other
+    // existing vertices, so every LOD indexes the same vertex range as the full detail mesh.
+    class MeshSimplifier {
+    public:
+        inline static const uint32_t MAX_LODS = 5;
+        // Each LOD aims for this fraction of the previous one's triangles
+        inline static constexpr float LOD_RATIO = 0.5f;
+        // Below this the draw call costs more than the triangles, no LODs are generated
+        inline static const uint32_t MIN_TRIANGLES = 256;
+
+        // Fills lod_indices with LOD 0 (a copy of indices) followed by every simplified level, in a
+        // single collapse sequence so the errors only grow. lods gets one entry per level. Each level
+        // collapses until it reaches its triangle target or nothing can collapse without folding a triangle
+        // over, its error estimate is in object space units.
+        static void GenerateLODs(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                 std::vector<uint32_t>& lod_indices, std::vector<MeshLOD>& lods);
+    };
+
+}
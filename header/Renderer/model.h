@@ -7,179 +7,500 @@
 #include <assimp/postprocess.h>
 
 #include <Renderer/mesh.h>
+#include <Renderer/frustum_culler.h>
+#include <Renderer/material.h>
+#include <Renderer/mesh_cache.h>
+#include <Renderer/mesh_optimizer.h>
+#include <Renderer/mesh_simplifier.h>
+#include <Renderer/occlusion_buffer.h>
+#include <Renderer/render_queue.h>
 #include <Renderer/shader.h>
+#include <Renderer/staging_uploader.h>
 #include <Renderer/Texture2D.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
+#include <Renderer/texture_cache.h>
+#include <thread_pool.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string>
 #include <iostream>
 #include <vector>
 
 namespace OGLR {
 
-    inline Texture2D LoadTexture(const std::string& path, const std::string& typeName, const std::string& directory) {
-        TextureSpecs specs;
-        specs.path = directory + "/" + path;
-        specs.type = typeName;
-
-        int width, height, nrComponents;
-        uint8_t* data = stbi_load(specs.path.c_str(), &width, &height, &nrComponents, 0);
-        if (data) {
-            if (nrComponents == 1)
-                specs.format = GL_RED;
-            else if (nrComponents == 3)
-                specs.format = GL_RGB;
-            else if (nrComponents == 4)
-                specs.format = GL_RGBA;
-
-            specs.width = width;
-            specs.height = height;
-
-            Texture2D texture(data, specs);
-            stbi_image_free(data);
-            return texture;
-        }
-        std::cout << "Texture failed to load at path: " << path << '\n';
-        data = new uint8_t[3]{1, 1, 1};
-        specs.width = 3;
-        specs.height = 1;
-        Texture2D texture(data, specs);
-        stbi_image_free(data);
-        return texture;
-    }
-
     class Model {
     public:
+        // Returns right away with no meshes, the file is parsed on ThreadPool::Get() and Update streams
+        // the meshes in once it is done
         Model(const std::string& path)
-            :mModelMatrix(1.0f) {
+            :mModelMatrix(1.0f), mPath(path) {
             loadModel(path);
         }
 
+        // Uploads the meshes of a finished load, as many per frame as the StagingUploader budget allows.
+        // Each one can be drawn from the frame it arrives in, textures follow through TextureCache::Update.
+        void Update() {
+            if (mLoad)
+                streamMeshes();
+            if (mLoadReported || !IsFullyLoaded())
+                return;
+            mLoadReported = true;
+            reportLoadTimes();
+        }
+
+        // Still parsing or uploading meshes, a model that failed to load stops streaming without any
+        bool IsStreaming() const { return mLoad != nullptr; }
+
+        bool IsFullyLoaded() const {
+            if (IsStreaming())
+                return false;
+            // A texture that failed to load keeps its placeholder, it counts as done
+            for (const TextureHandle& texture : mTextures) {
+                if (TextureCache::Get().IsPending(texture))
+                    return false;
+            }
+            return true;
+        }
+
         void Translate(const glm::vec3& world_pos) {
             mModelMatrix = glm::translate(mModelMatrix, world_pos);
+            updateObjects();
         }
 
         void Rotate(float degrees, const glm::vec3& axis) {
             mModelMatrix = glm::rotate(mModelMatrix, glm::radians(degrees), axis);
+            updateObjects();
         }
 
         void Scale(const glm::vec3& world_scale) {
             mModelMatrix = glm::scale(mModelMatrix, world_scale);
+            updateObjects();
         }
 
-        void Draw(Shader* shader, const glm::mat4& view, const glm::mat4& proj) {
-            for (uint32_t i = 0; i < mMeshes.size(); i++)
-                mMeshes[i].Draw(shader, mModelMatrix, view, proj);
+        // Submits the meshes inside the view/proj frustum. Shaders still read the camera from the frame
+        // block (see UniformBlocks::SetFrame), these only decide what gets drawn and in which order.
+        void Submit(RenderQueue& queue, RenderPass pass, const MaterialShaders& shaders, const glm::mat4& view, const glm::mat4& proj,
+                    const LODSelection& lod = {}) {
+            FrustumCuller::Cull(Frustum::FromMatrix(proj * view), mWorldBounds, mVisible);
+            LODStats stats;
+            for (uint32_t index : mVisible)
+                SubmitMesh(index, queue.GetDrawList(0), pass, shaders, view, lod, stats);
+            Mesh::AddLODStats(stats);
+        }
+
+        // For callers that did their own culling, e.g. Scene through its BVH. Only reads the model, any
+        // number of threads can submit its meshes at once into their own lists.
+        void SubmitMesh(uint32_t index, DrawList& list, RenderPass pass, const MaterialShaders& shaders, const glm::mat4& view,
+                        const LODSelection& lod, LODStats& stats) const {
+            const Mesh& mesh = mMeshes[index];
+            float view_depth = -(view * glm::vec4(mWorldBounds.GetCenter(index), 1.0f)).z;
+            // The nearest point of the bounding sphere decides, so the error is never underestimated
+            float nearest = std::max(view_depth - mesh.GetBoundingSphere().radius * mMaxScale, 1e-3f);
+            uint32_t level = mesh.SelectLOD(lod.pixelScale * mMaxScale / nearest, lod.maxPixelError);
+            mesh.Submit(list, pass, shaders, view_depth, level, stats);
+        }
+
+        const std::string& GetPath() const { return mPath; }
+        uint32_t GetMeshCount() const { return static_cast<uint32_t>(mMeshes.size()); }
+        AABB GetMeshBounds(uint32_t index) const { return mMeshes[index].GetBounds().Transform(mModelMatrix); }
+        // Bumped on every transform change, lets Scene find the models it has to refit
+        uint64_t GetTransformVersion() const { return mTransformVersion; }
+        const glm::mat4& GetModelMatrix() const { return mModelMatrix; }
+
+        // CPU side import without touching GL, also what the offline tools use.
+        // A warm load maps the cache and never touches Assimp.
+        static bool LoadData(const std::string& path, ModelData& data) {
+            uint64_t source_hash = MeshCache::HashSource(path);
+            std::string cache_path = MeshCache::GetCachePath(path);
+            if (MeshCache::Load(cache_path, source_hash, IMPORT_FLAGS, data))
+                return true;
+            if (!importModel(path, data))
+                return false;
+            MeshCache::Write(cache_path, source_hash, IMPORT_FLAGS, data);
+            return true;
         }
+        // The largest meshes by surface area, rasterized on the CPU to hide whatever is behind them.
+        // Empty until every mesh is resident.
+        const std::vector<OccluderMesh>& GetOccluders() const { return mOccluders; }
     private:
+        inline static const uint32_t IMPORT_FLAGS = aiProcess_Triangulate               |
+                                                    aiProcess_FixInfacingNormals        |
+                                                    aiProcess_PreTransformVertices      |
+                                                    aiProcess_GenNormals                |
+                                                    aiProcess_GenUVCoords               |
+                                                    //aiProcess_OptimizeMeshes            |
+                                                    // Welding and cache ordering happen in optimizeMeshes instead
+                                                    //aiProcess_JoinIdenticalVertices     |
+                                                    aiProcess_FlipUVs;
+
+        inline static const uint32_t MAX_OCCLUDERS = 32;
+        inline static const uint32_t MAX_OCCLUDER_TRIANGLES = 1 << 16;
+        // Dense meshes cost more to rasterize than they save, they still get tested like any other
+        inline static const uint32_t MAX_TRIANGLES_PER_OCCLUDER = 1 << 14;
+
+        // Written by the load job, the GL thread only reads it once done is set
+        struct LoadState {
+            ModelData data;
+            // One per mesh, converted for the arena on the worker too
+            std::vector<StagedGeometry> geometry;
+            bool succeeded = false;
+            double parseMs = 0.0;
+            std::atomic<bool> done = false;
+
+            std::vector<std::shared_ptr<Material>> materials;
+            bool started = false;
+        };
+
         void loadModel(const std::string& path) {
+            mDirectory = path.substr(0, path.find_last_of('/'));
+            mLoadStart = Clock::now();
+
+            // The job holds its own reference, a model destroyed mid-load leaves it nothing to clean up
+            mLoad = std::make_shared<LoadState>();
+            ThreadPool::Get().Submit([load = mLoad, path, format = GeometryArena::Get().GetVertexFormat()]() {
+                Clock::time_point parse_start = Clock::now();
+                load->succeeded = LoadData(path, load->data);
+                if (load->succeeded) {
+                    const ModelData& data = load->data;
+                    std::span<const MeshLOD> lods = data.lods;
+                    load->geometry.resize(data.meshes.size());
+                    for (uint32_t i = 0; i < data.meshes.size(); i++) {
+                        const MeshData& mesh = data.meshes[i];
+                        GeometryArena::Prepare(format, data.vertices.subspan(mesh.vertexOffset, mesh.vertexCount),
+                                               data.indices.subspan(mesh.indexOffset, mesh.indexCount),
+                                               lods.subspan(mesh.lodOffset, mesh.lodCount), load->geometry[i]);
+                    }
+                }
+                load->parseMs = std::chrono::duration<double, std::milli>(Clock::now() - parse_start).count();
+                load->done.store(true, std::memory_order_release);
+            });
+        }
+
+        void streamMeshes() {
+            LoadState& load = *mLoad;
+            if (!load.done.load(std::memory_order_acquire))
+                return;
+            if (!load.succeeded) {
+                mLoad.reset();
+                mLoadReported = true;
+                return;
+            }
+
+            const ModelData& data = load.data;
+            if (!load.started) {
+                load.started = true;
+                mParseMs = load.parseMs;
+                mMeshUploadStart = Clock::now();
+                mMeshes.reserve(data.meshes.size());
+
+                // Decoding starts right away on the workers while the meshes upload
+                load.materials.resize(data.materials.size());
+                for (uint32_t i = 0; i < data.materials.size(); i++) {
+                    std::vector<MeshTexture> textures;
+                    for (const MaterialTextureRef& texture : data.materials[i].textures) {
+                        bool normal_map = texture.type == "texture_normal";
+                        TextureHandle handle = TextureCache::Get().Acquire(mDirectory + '/' + texture.path, normal_map);
+                        textures.push_back({ texture.type, handle });
+                        mTextures.push_back(handle);
+                    }
+                    load.materials[i] = std::make_shared<Material>(textures);
+                }
+            }
+
+            std::span<const MeshLOD> lods = data.lods;
+            while (mMeshes.size() < data.meshes.size()) {
+                uint32_t index = static_cast<uint32_t>(mMeshes.size());
+                StagedGeometry& staged = load.geometry[index];
+                if (!mUploading)
+                    mUploading.emplace(GeometryArena::Get().Reserve(staged));
+                if (!GeometryArena::Get().Upload(staged, mUploading->Get()))
+                    return;
+
+                const MeshData& mesh = data.meshes[index];
+                mMeshes.emplace_back(data.vertices.subspan(mesh.vertexOffset, mesh.vertexCount), lods.subspan(mesh.lodOffset, mesh.lodCount),
+                                     load.materials[mesh.materialIndex], std::move(*mUploading));
+                mUploading.reset();
+                staged = {};
+                addObject(index);
+            }
+
+            selectOccluders(data);
+            reportLODs(data);
+            reportIndices(data);
+            mMeshUploadMs = std::chrono::duration<double, std::milli>(Clock::now() - mMeshUploadStart).count();
+            mLoad.reset();
+        }
+
+        void selectOccluders(const ModelData& data) {
+            std::vector<uint32_t> order(mMeshes.size());
+            for (uint32_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+                return mMeshes[a].GetBounds().GetSurfaceArea() > mMeshes[b].GetBounds().GetSurfaceArea();
+            });
+
+            uint32_t triangle_count = 0;
+            for (uint32_t index : order) {
+                const MeshData& mesh = data.meshes[index];
+                uint32_t mesh_triangles = data.lods[mesh.lodOffset].indexCount / 3;
+                if (mesh_triangles == 0 || mesh_triangles > MAX_TRIANGLES_PER_OCCLUDER)
+                    continue;
+                if (mOccluders.size() == MAX_OCCLUDERS || triangle_count + mesh_triangles > MAX_OCCLUDER_TRIANGLES)
+                    break;
+
+                OccluderMesh& occluder = mOccluders.emplace_back();
+                occluder.positions.reserve(mesh.vertexCount);
+                for (const Vertex& vertex : data.vertices.subspan(mesh.vertexOffset, mesh.vertexCount))
+                    occluder.positions.push_back(vertex.position);
+                std::span<const uint32_t> indices = data.indices.subspan(mesh.indexOffset, mesh_triangles * 3);
+                occluder.indices.assign(indices.begin(), indices.end());
+                triangle_count += mesh_triangles;
+            }
+        }
+
+        // Only written when the transform changes, the shared buffer re-uploads just those slots
+        void updateObjects() {
+            mTransformVersion++;
+            mWorldBounds.Resize(static_cast<uint32_t>(mMeshes.size()));
+            mMaxScale = std::max({ glm::length(glm::vec3(mModelMatrix[0])), glm::length(glm::vec3(mModelMatrix[1])),
+                                   glm::length(glm::vec3(mModelMatrix[2])) });
+            for (uint32_t i = 0; i < mMeshes.size(); i++)
+                updateObject(i);
+        }
+
+        // A mesh that just streamed in, Scene sees the mesh count change and rebuilds its hierarchy
+        void addObject(uint32_t index) {
+            mWorldBounds.Resize(static_cast<uint32_t>(mMeshes.size()));
+            updateObject(index);
+        }
+
+        void updateObject(uint32_t index) {
+            const Mesh& mesh = mMeshes[index];
+            mesh.GetObjectSlot().Set(mModelMatrix, mesh.GetGeometry().dequantization);
+            mWorldBounds.Set(index, mesh.GetBounds().Transform(mModelMatrix), mesh.GetBoundingSphere().Transform(mModelMatrix));
+        }
+
+        static bool importModel(const std::string& path, ModelData& data) {
             Assimp::Importer importer;
-            const aiScene* scene = importer.ReadFile(path,  aiProcess_Triangulate               |
-                                                            aiProcess_FixInfacingNormals        |
-                                                            aiProcess_PreTransformVertices      |
-                                                            aiProcess_GenNormals                |
-                                                            aiProcess_GenUVCoords               |
-                                                            //aiProcess_OptimizeMeshes            |
-                                                            //aiProcess_JoinIdenticalVertices     |
-                                                            aiProcess_FlipUVs);
+            const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
             if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
                 std::cerr << "ERROR::ASSIMP:: " << importer.GetErrorString() << "\n";
-                return;
+                return false;
             }
-            mDirectory = path.substr(0, path.find_last_of('/'));
-            processNode(scene->mRootNode, scene);
+
+            data.materials.resize(scene->mNumMaterials);
+            for (uint32_t i = 0; i < scene->mNumMaterials; i++) {
+                aiMaterial* material = scene->mMaterials[i];
+                processMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data.materials[i]);
+                processMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data.materials[i]);
+                processMaterialTextures(material, aiTextureType_SHININESS, "texture_shininess", data.materials[i]);
+                // OBJ files name their normal maps map_bump, which assimp reports as a height map
+                processMaterialTextures(material, aiTextureType_NORMALS, "texture_normal", data.materials[i]);
+                processMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", data.materials[i]);
+            }
+
+            processNode(scene->mRootNode, scene, data);
+            optimizeMeshes(path, data);
+            data.vertices = data.importedVertices;
+            data.indices = data.importedIndices;
+            return true;
+        }
+
+        // What the import time passes turn one mesh into, every LOD already in its final index range
+        struct OptimizedMesh {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            std::vector<MeshLOD> lods;
+            VertexCacheStats before, after;
+        };
+
+        // Stands in for aiProcess_JoinIdenticalVertices and aiProcess_ImproveCacheLocality, then builds the LODs
+        static void optimizeMesh(std::span<const Vertex> imported_vertices, std::span<const uint32_t> imported_indices, OptimizedMesh& mesh) {
+            mesh.vertices.assign(imported_vertices.begin(), imported_vertices.end());
+            std::vector<uint32_t> indices(imported_indices.begin(), imported_indices.end());
+            mesh.before = MeshOptimizer::AnalyzeVertexCache(indices, static_cast<uint32_t>(mesh.vertices.size()));
+
+            MeshOptimizer::WeldVertices(mesh.vertices, indices);
+            std::vector<uint32_t> clusters;
+            MeshOptimizer::OptimizeVertexCache(indices, static_cast<uint32_t>(mesh.vertices.size()), &clusters);
+            MeshOptimizer::OptimizeOverdraw(indices, mesh.vertices, clusters);
+
+            // Simplification keeps the surviving triangles in order, the coarser levels still get their own pass
+            MeshSimplifier::GenerateLODs(mesh.vertices, indices, mesh.indices, mesh.lods);
+            for (uint32_t lod = 1; lod < mesh.lods.size(); lod++) {
+                auto begin = mesh.indices.begin() + mesh.lods[lod].indexOffset;
+                std::vector<uint32_t> lod_indices(begin, begin + mesh.lods[lod].indexCount);
+                MeshOptimizer::OptimizeVertexCache(lod_indices, static_cast<uint32_t>(mesh.vertices.size()));
+                std::copy(lod_indices.begin(), lod_indices.end(), begin);
+            }
+
+            // Last, over every level at once, LOD 0 decides the order
+            MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+            mesh.after = MeshOptimizer::AnalyzeVertexCache(std::span<const uint32_t>(mesh.indices).first(mesh.lods[0].indexCount),
+                                                           static_cast<uint32_t>(mesh.vertices.size()));
+        }
+
+        // One range per mesh, the results are stitched back into single vertex and index lists afterwards.
+        // Runs inside the load job, ParallelFor lets it go on alone when every other worker is busy.
+        static void optimizeMeshes(const std::string& path, ModelData& data) {
+            std::vector<OptimizedMesh> optimized(data.meshes.size());
+            ThreadPool::Get().ParallelFor(static_cast<uint32_t>(data.meshes.size()), 1, [&data, &optimized](uint32_t, uint32_t i, uint32_t) {
+                const MeshData& mesh = data.meshes[i];
+                optimizeMesh(std::span<const Vertex>(data.importedVertices).subspan(mesh.vertexOffset, mesh.vertexCount),
+                             std::span<const uint32_t>(data.importedIndices).subspan(mesh.indexOffset, mesh.indexCount),
+                             optimized[i]);
+            });
+
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            data.lods.clear();
+            VertexCacheStats total_before, total_after;
+            uint64_t triangles = 0;
+            for (uint32_t i = 0; i < data.meshes.size(); i++) {
+                MeshData& mesh = data.meshes[i];
+                const OptimizedMesh& result = optimized[i];
+                mesh.vertexOffset = static_cast<uint32_t>(vertices.size());
+                mesh.vertexCount = static_cast<uint32_t>(result.vertices.size());
+                mesh.indexOffset = static_cast<uint32_t>(indices.size());
+                mesh.indexCount = static_cast<uint32_t>(result.indices.size());
+                mesh.lodOffset = static_cast<uint32_t>(data.lods.size());
+                mesh.lodCount = static_cast<uint32_t>(result.lods.size());
+                vertices.insert(vertices.end(), result.vertices.begin(), result.vertices.end());
+                indices.insert(indices.end(), result.indices.begin(), result.indices.end());
+                data.lods.insert(data.lods.end(), result.lods.begin(), result.lods.end());
+
+                total_before.transformed += result.before.transformed;
+                total_after.transformed += result.after.transformed;
+                triangles += result.lods[0].indexCount / 3;
+            }
+            if (triangles > 0) {
+                std::cout << path << ": " << data.importedVertices.size() << " -> " << vertices.size() << " vertices, ACMR "
+                          << static_cast<double>(total_before.transformed) / triangles << " -> "
+                          << static_cast<double>(total_after.transformed) / triangles << '\n';
+            }
+            data.importedVertices = std::move(vertices);
+            data.importedIndices = std::move(indices);
         }
 
-        void processNode(aiNode* node, const aiScene* scene) {
+        static void processNode(aiNode* node, const aiScene* scene, ModelData& data) {
             for (uint32_t i = 0; i < node->mNumMeshes; i++) {
                 aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-                mMeshes.push_back(processMesh(mesh, scene));
+                processMesh(mesh, data);
             }
             for (uint32_t i = 0; i < node->mNumChildren; i++) {
-                processNode(node->mChildren[i], scene);
+                processNode(node->mChildren[i], scene, data);
             }
 
         }
 
-        Mesh processMesh(aiMesh* mesh, const aiScene* scene) {
-            std::vector<Vertex> vertices;
-            std::vector<uint32_t> indices;
-            std::vector<Texture2D> textures;
+        static void processMesh(aiMesh* mesh, ModelData& data) {
+            MeshData mesh_data;
+            mesh_data.vertexOffset = static_cast<uint32_t>(data.importedVertices.size());
+            mesh_data.vertexCount = mesh->mNumVertices;
+            mesh_data.indexOffset = static_cast<uint32_t>(data.importedIndices.size());
+            mesh_data.materialIndex = mesh->mMaterialIndex;
 
+            data.importedVertices.resize(data.importedVertices.size() + mesh->mNumVertices);
+            Vertex* vertices = data.importedVertices.data() + mesh_data.vertexOffset;
             for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
-                Vertex vertex;
-                glm::vec3 vector;
-                vector.x = mesh->mVertices[i].x;
-                vector.y = mesh->mVertices[i].y;
-                vector.z = mesh->mVertices[i].z;
-                vertex.position = vector;
-
-                if (mesh->HasNormals()) {
-                    vector.x = mesh->mNormals[i].x;
-                    vector.y = mesh->mNormals[i].y;
-                    vector.z = mesh->mNormals[i].z;
-                    vertex.normal = vector;
-                }
+                Vertex& vertex = vertices[i];
+                vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
 
-                if(!mesh->mTextureCoords[0]) {
-                    vertex.tex_coords = glm::vec2(0.0f, 0.0f);
-                } else {
-                    glm::vec2 vec;
-                    vec.x = mesh->mTextureCoords[0][i].x; 
-                    vec.y = mesh->mTextureCoords[0][i].y;
-                    vertex.tex_coords = vec;
-                }
+                if (mesh->HasNormals())
+                    vertex.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+                else
+                    vertex.normal = glm::vec3(0.0f);
 
-                vertices.push_back(vertex);
+                if(!mesh->mTextureCoords[0])
+                    vertex.tex_coords = glm::vec2(0.0f, 0.0f);
+                else
+                    vertex.tex_coords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
             }
 
+            // Faces are triangulated, so every face has exactly three indices
+            size_t index_count = 0;
+            for (uint32_t i = 0; i < mesh->mNumFaces; i++)
+                index_count += mesh->mFaces[i].mNumIndices;
+            data.importedIndices.reserve(data.importedIndices.size() + index_count);
             for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
-                aiFace face = mesh->mFaces[i];
-                for (uint32_t j = 0; j < face.mNumIndices; j++)
-                    indices.push_back(face.mIndices[j]);
+                const aiFace& face = mesh->mFaces[i];
+                data.importedIndices.insert(data.importedIndices.end(), face.mIndices, face.mIndices + face.mNumIndices);
             }
+            mesh_data.indexCount = static_cast<uint32_t>(index_count);
 
-            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-            std::vector<Texture2D> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-
-            std::vector<Texture2D> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-
-            std::vector<Texture2D> shininessMaps = loadMaterialTextures(material, aiTextureType_SHININESS, "texture_shininess");
-            textures.insert(textures.end(), shininessMaps.begin(), shininessMaps.end());
-
-            return Mesh(vertices, indices, textures);
+            data.meshes.push_back(mesh_data);
         }
 
-        std::vector<Texture2D> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName) {
-            std::vector<Texture2D> textures;
+        static void processMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName, MaterialData& material) {
             for (uint32_t i = 0; i < mat->GetTextureCount(type); i++) {
                 aiString str;
                 mat->GetTexture(type, i, &str);
-                bool skip = false;
-                for (uint32_t j = 0; j < mTexturesLoaded.size(); j++) {
-                    if(std::strcmp(mTexturesLoaded[j].GetPath().c_str(), (mDirectory + '/' + std::string(str.C_Str())).c_str()) == 0) {
-                        textures.push_back(mTexturesLoaded[j]);
-                        skip = true;
-                        break;
-                    }
-                }
-                if(!skip) {
-                    Texture2D texture = LoadTexture(str.C_Str(), typeName, mDirectory);
-                    textures.push_back(texture);
-                    mTexturesLoaded.push_back(texture);
+                material.textures.push_back({ typeName, str.C_Str() });
+            }
+        }
+
+        // Triangles and the worst error of each level across all meshes, meshes without that level count their coarsest
+        void reportLODs(const ModelData& data) const {
+            for (uint32_t level = 0; level < MeshSimplifier::MAX_LODS; level++) {
+                uint64_t triangles = 0;
+                float error = 0.0f;
+                bool generated = false;
+                for (const MeshData& mesh : data.meshes) {
+                    const MeshLOD& lod = data.lods[mesh.lodOffset + std::min(level, mesh.lodCount - 1)];
+                    generated |= level < mesh.lodCount;
+                    triangles += lod.indexCount / 3;
+                    error = std::max(error, lod.error);
                 }
+                if (!generated)
+                    break;
+                std::cout << mPath << " LOD " << level << ": " << triangles << " triangles, error up to " << error << '\n';
+            }
+        }
+
+        void reportIndices(const ModelData& data) const {
+            uint64_t packed_bytes = 0, chunks_16 = 0, chunks_32 = 0;
+            for (const Mesh& mesh : mMeshes) {
+                packed_bytes += mesh.GetGeometry().indexSlotCount * sizeof(uint16_t);
+                for (const IndexChunk& chunk : mesh.GetGeometry().chunks)
+                    (chunk.type == IndexType::UINT16 ? chunks_16 : chunks_32)++;
             }
-            return textures;
+            std::cout << mPath << " indices: " << packed_bytes / 1024 << " KB, " << data.indices.size_bytes() / 1024
+                      << " KB as 32 bit, " << chunks_16 << " 16 bit and " << chunks_32 << " 32 bit draws\n";
+        }
+
+        void reportLoadTimes() const {
+            double resident_ms = std::chrono::duration<double, std::milli>(Clock::now() - mLoadStart).count();
+            std::cout << "Loaded " << mPath << ": parse " << mParseMs << " ms, mesh upload " << mMeshUploadMs << " ms, "
+                      << mTextures.size() << " textures resident after " << resident_ms << " ms\n";
         }
     private:
-        std::vector<Texture2D> mTexturesLoaded;
         std::vector<Mesh>    mMeshes;
         glm::mat4 mModelMatrix;
+        // Largest axis scale of mModelMatrix, turns object space LOD errors into world space
+        float mMaxScale = 1.0f;
+        CullingBounds mWorldBounds;
+        std::vector<uint32_t> mVisible;
+        std::vector<OccluderMesh> mOccluders;
+        uint64_t mTransformVersion = 0;
+        std::string mPath;
         std::string mDirectory;
+
+        // One per material slot, keeps the textures alive as long as the model
+        std::vector<TextureHandle> mTextures;
+
+        // Until every mesh is resident, the next one's arena range while it uploads
+        std::shared_ptr<LoadState> mLoad;
+        std::optional<MeshGeometry> mUploading;
+
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point mLoadStart;
+        Clock::time_point mMeshUploadStart;
+        double mParseMs = 0.0;
+        double mMeshUploadMs = 0.0;
+        bool mLoadReported = false;
     };
 
 
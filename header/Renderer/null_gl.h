@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    enum class GLCallKind : uint8_t {
+        OTHER,
+        STATE,      // binds, enables, uniforms and other state setters
+        UPLOAD,     // data copied from the CPU into a buffer or texture
+        DRAW,
+        OBJECT,     // creating and deleting objects
+        QUERY       // reads back from GL, a sync point on a real driver
+    };
+
+    // Everything that reached GL between two EndFrame calls
+    struct NullGLFrame {
+        uint64_t calls = 0;
+        uint64_t draws = 0;
+        // Meshes drawn, a multi-draw counts each of its commands
+        uint64_t drawCommands = 0;
+        uint64_t stateChanges = 0;
+        uint64_t queries = 0;
+        // Writes into persistently mapped memory never go through GL, StreamBuffer counts those
+        uint64_t bytesUploaded = 0;
+        // Indexed by function, see GetFunctionName
+        std::vector<uint32_t> callCounts;
+    };
+
+    // Recording stand-in for the GL driver. Load points glad's function pointers at stubs that
+    // count every call and answer queries like a driver that never fails, so the engine runs and
+    // can be timed without a GPU. Buffers are only backed by memory once mapped, nothing is drawn.
+    // Functions the engine doesn't call stay null, a new GL call needs its stub added here.
+    class NullGL {
+    public:
+        static bool Load();
+        static bool IsLoaded() { return mLoaded; }
+
+        // Closes the current frame, call once per presented frame like SwapBuffers
+        static void EndFrame();
+        // Frames closed so far, the first one holds everything done while loading
+        static const std::vector<NullGLFrame>& GetFrames() { return mFrames; }
+
+        // Keeps the command stream of every call from now on, written out by WriteTrace
+        static void StartRecording() { mRecording = true; }
+        static bool WriteTrace(const std::string& path);
+        // Rebuilds the per-frame statistics of a written trace and prints them as a JSON array
+        static bool ReplayTrace(const std::string& path, std::ostream& json);
+        static void WriteJSON(const std::vector<NullGLFrame>& frames, const std::vector<std::string>& names, std::ostream& json);
+
+        static uint32_t GetFunctionCount();
+        static const char* GetFunctionName(uint32_t function);
+        static GLCallKind GetFunctionKind(uint32_t function);
+
+        // Called by the stubs, value is the bytes of an upload or the commands of a draw
+        static void Record(uint32_t function, uint64_t value = 0);
+    private:
+        static void accumulate(NullGLFrame& frame, GLCallKind kind, uint32_t function, uint64_t value);
+    private:
+        struct TraceRecord {
+            uint16_t function;
+            uint16_t reserved;
+            uint32_t value;
+        };
+        inline static const uint16_t FRAME_END = UINT16_MAX;
+        inline static const uint32_t TRACE_MAGIC = 0x54474C4F; // "OGLT"
+        inline static const uint32_t TRACE_VERSION = 1;
+
+        inline static bool mLoaded = false;
+        inline static bool mRecording = false;
+        inline static NullGLFrame mFrame;
+        inline static std::vector<NullGLFrame> mFrames;
+        inline static std::vector<TraceRecord> mTrace;
+    };
+
+}
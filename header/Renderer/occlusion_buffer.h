@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Renderer/bounds.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    // CPU copy of a mesh that is large enough to hide others, kept in object space
+    struct OccluderMesh {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
+
+    struct OcclusionStats {
+        uint32_t occluderTriangles = 0;
+        // Triangles left after rejecting the ones outside the frustum and clipping at the near plane
+        uint32_t rasterizedTriangles = 0;
+        uint32_t tested = 0;
+        uint32_t occluded = 0;
+    };
+
+    // Low resolution depth buffer the occluders are rasterized into on the CPU, followed by a max
+    // depth pyramid that bounds are tested against. Depth is GL window depth, 0 near and 1 far.
+    // Everything runs on the calling thread in submission order, the results only depend on the input.
+    class OcclusionBuffer {
+    public:
+        // Width is rounded up to a multiple of 4, the rasterizer fills 4 pixels at a time
+        OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+        // Clears to the far plane, occluders rasterized afterwards are seen through view_proj
+        void Begin(const glm::mat4& view_proj);
+        void RasterizeOccluder(const OccluderMesh& occluder, const glm::mat4& model);
+        // Builds the pyramid, IsVisible is only valid afterwards
+        void End();
+
+        // Conservative, anything crossing the near plane or leaving the screen counts as visible
+        bool IsVisible(const AABB& bounds) { return IsVisible(bounds, mStats); }
+        // Counts into stats instead, so several threads can test at once, see AddStats
+        bool IsVisible(const AABB& bounds, OcclusionStats& stats) const;
+
+        // Binary PGM with near white and far black, row 0 at the top of the screen
+        bool WriteDebugImage(const std::string& path, uint32_t level = 0) const;
+
+        uint32_t GetWidth() const { return mWidth; }
+        uint32_t GetHeight() const { return mHeight; }
+        uint32_t GetLevelCount() const { return static_cast<uint32_t>(mLevels.size()); }
+        const std::vector<float>& GetDepth(uint32_t level = 0) const { return mLevels[level].depth; }
+
+        const OcclusionStats& GetStats() const { return mStats; }
+        void ResetStats() { mStats = {}; }
+        void AddStats(const OcclusionStats& stats) {
+            mStats.tested += stats.tested;
+            mStats.occluded += stats.occluded;
+        }
+    private:
+        struct Level {
+            uint32_t width;
+            uint32_t height;
+            std::vector<float> depth;
+        };
+
+        void rasterizeClipped(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+        void rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+    private:
+        uint32_t mWidth;
+        uint32_t mHeight;
+        glm::mat4 mViewProj = glm::mat4(1.0f);
+        std::vector<Level> mLevels;
+        std::vector<glm::vec4> mClipPositions;
+
+        OcclusionStats mStats;
+    };
+
+}
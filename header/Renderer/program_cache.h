@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace OGLR {
+
+    struct ShaderSource;
+
+    // Linked program binaries on disk, so a warm start skips compiling and linking. Keyed by a hash of every
+    // stage's source as handed to GL and of the driver's vendor, renderer and version strings, an edited
+    // shader, another define or a driver update simply misses and the next link overwrites the file.
+    class ProgramCache {
+    public:
+        inline static const uint32_t MAGIC = 0x504C474F; // "OGLP"
+        inline static const uint32_t VERSION = 1;
+
+        // Variants of one file, see ShaderPreprocessor::GetDefinesHash, each get their own binary
+        static std::string GetCachePath(const std::string& shader_path, uint64_t variant = 0);
+        // Drivers may offer no binary formats at all, nothing is cached then
+        static bool IsSupported();
+        static uint64_t GetKey(const ShaderSource& source);
+
+        // False on a miss or when the driver refuses the binary, the program has to be linked from source then.
+        // compile_ms receives how long linking from source took when the binary was stored.
+        static bool Load(const std::string& cache_path, uint64_t key, uint32_t program, double& compile_ms);
+        // The program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+        static bool Store(const std::string& cache_path, uint64_t key, uint32_t program, double compile_ms);
+    };
+
+}
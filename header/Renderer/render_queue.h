@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Renderer/material.h>
+#include <Renderer/shader.h>
+#include <Renderer/uniform_buffer.h>
+#include <Renderer/vertex_array.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace OGLR {
+
+    class ThreadPool;
+
+    // Passes run in this order, each one is executed separately so the caller can switch targets in between
+    enum RenderPass : uint32_t {
+        OFFSCREEN_PASS = 0,
+        MAIN_PASS = 1,
+        MAX_RENDER_PASSES = 16
+    };
+
+    struct DrawCommand {
+        Shader* shader = nullptr;
+        Material* material = nullptr;
+        const VertexArray* vertexArray = nullptr;
+        IndexType indexType = IndexType::UINT32;
+        uint32_t indexCount = 0;
+        // In elements of indexType
+        uint32_t firstIndex = 0;
+        uint32_t baseVertex = 0;
+        // ObjectData slot, reaches the shader as gl_BaseInstance
+        uint32_t object = 0;
+    };
+
+    // Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+    struct DrawElementsIndirectCommand {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t baseInstance;
+    };
+
+    struct RenderQueueStats {
+        uint32_t draws = 0;
+        // glMultiDrawElementsIndirect calls, one per run of draws sharing program, material, vertex array and index type
+        uint32_t multiDraws = 0;
+        uint32_t programSwitches = 0;
+        uint32_t materialBinds = 0;
+        uint32_t vertexArrayBinds = 0;
+        // Program, texture and vertex array binds a per-mesh draw would have made
+        uint32_t bindsElided = 0;
+    };
+
+    // Draws submitted by one thread. Any number of threads can fill their own list at once, RenderQueue
+    // merges them in list order, so the result doesn't depend on which thread finished first.
+    class DrawList {
+    public:
+        void Submit(RenderPass pass, const DrawCommand& command, float view_depth);
+
+        uint32_t GetCommandCount() const { return static_cast<uint32_t>(mCommands.size()); }
+    private:
+        friend class RenderQueue;
+
+        void clear(float depth_scale);
+    private:
+        std::vector<DrawCommand> mCommands;
+        std::vector<uint64_t> mKeys;
+        float mDepthScale = 0.0f;
+    };
+
+    class RenderQueue {
+    public:
+        RenderQueue() = default;
+
+        RenderQueue(const RenderQueue&) = delete;
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        // Key layout, most significant first: pass 4 | shader 12 | material 16 | vertex array 15 | index type 1 | depth 16
+        static uint64_t MakeKey(RenderPass pass, uint32_t shader, uint32_t material, uint32_t vertex_array, IndexType index_type, uint16_t depth);
+
+        // far_plane maps view distances onto the 16 depth bits, nearer draws sort first within a state group
+        void Begin(float far_plane);
+        // Into the first draw list, from the GL thread
+        void Submit(RenderPass pass, const DrawCommand& command, float view_depth);
+        // Adds count empty lists for workers to fill and returns the index of the first, from the GL thread.
+        // References from GetDrawList stay valid until the next AddDrawLists or Begin.
+        uint32_t AddDrawLists(uint32_t count);
+        DrawList& GetDrawList(uint32_t index) { return mLists[index]; }
+
+        // Merges the draw lists, sorts them and writes the indirect commands, on the pool's workers too when
+        // given one. Everything Execute does afterwards is binding state and issuing the multi-draws.
+        // Called by the first Execute of a frame if the caller didn't.
+        void Prepare(ThreadPool* pool = nullptr);
+        void Execute(RenderPass pass);
+
+        uint32_t GetCommandCount() const;
+        // Totals of the last frame, i.e. everything executed between the previous two Begin calls
+        const RenderQueueStats& GetStats() const { return mLastStats; }
+        // Totals of the frame still being built, everything executed since the last Begin
+        const RenderQueueStats& GetCurrentStats() const { return mStats; }
+    private:
+        // Draws per worker range when Prepare is given a pool
+        inline static const uint32_t PARALLEL_GRAIN = 4096;
+
+        struct SortEntry {
+            uint64_t key;
+            uint32_t command;
+        };
+
+        // Consecutive sorted draws sharing all their state, one glMultiDrawElementsIndirect
+        struct DrawRun {
+            Shader* shader;
+            Material* material;
+            const VertexArray* vertexArray;
+            IndexType indexType;
+            RenderPass pass;
+            uint32_t first;
+            uint32_t count;
+        };
+
+        void merge(ThreadPool* pool);
+        void sort();
+        void uploadIndirect(ThreadPool* pool);
+        void buildRuns();
+    private:
+        // Draw lists are kept across frames with their capacity, only the first mListCount are in use
+        std::vector<DrawList> mLists;
+        uint32_t mListCount = 0;
+
+        std::vector<DrawCommand> mCommands;
+        std::vector<SortEntry> mEntries;
+        std::vector<SortEntry> mScratch;
+        std::vector<DrawRun> mRuns;
+        bool mPrepared = false;
+        float mDepthScale = 0.0f;
+
+        // Written in sorted order for every pass at once into the current StreamBuffer, each pass draws from its own slice
+        uint32_t mIndirectBufferID = 0;
+        uint32_t mIndirectOffset = 0;
+
+        RenderQueueStats mStats;
+        RenderQueueStats mLastStats;
+    };
+
+}
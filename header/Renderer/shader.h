@@ -1,51 +1,92 @@
 #pragma once
 
+#include <Renderer/shader_preprocessor.h>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include <string>
+#include <string_view>
 #include <optional>
+#include <vector>
 
 namespace OGLR {
 
-    struct ShaderSource {
-        std::optional<std::string> vertex;
-        std::optional<std::string> fragment;
-        std::optional<std::string> geometry;
-        std::optional<std::string> compute;
+    // Location of a uniform resolved once, setting it through Shader::SetUniform does no string work or hashing.
+    // An invalid handle (uniform optimized out or missing) is silently ignored like location -1 in GL.
+    template <typename T>
+    struct UniformHandle {
+        int32_t location = -1;
+
+        bool IsValid() const { return location != -1; }
     };
 
-    enum class ShaderType {
-        UNKNOWN = 0,
-        VERTEX,
-        FRAGMENT,
-        GEOMETRY,
-        COMPUTE
+    // Uniform name resolutions and names built as std::string, reset once per frame
+    struct UniformStats {
+        uint32_t locationLookups = 0;
+        uint32_t stringAllocations = 0;
     };
 
     class Shader {
     public:
         Shader() = default;
-        Shader(const std::string& filepath);
+        // Loads the program binary cached next to the file when it is still valid, see ProgramCache.
+        // The defines specialize this program, see ShaderVariants for compiling them on demand.
+        Shader(const std::string& filepath, const ShaderDefines& defines = {});
        ~Shader();
 
        void Bind();
        void UnBind();
 
+       // Unique for the process lifetime, unlike the GL program name which gets recycled on reload
+       uint32_t GetID() const { return mID; }
+
+       template <typename T>
+       UniformHandle<T> GetUniform(std::string_view name) const { return { FindUniformLocation(name) }; }
+
+       void SetUniform(UniformHandle<glm::vec4> handle, const glm::vec4& value);
+       void SetUniform(UniformHandle<glm::vec3> handle, const glm::vec3& value);
+       void SetUniform(UniformHandle<float> handle, float value);
+       void SetUniform(UniformHandle<int> handle, int value);
+       void SetUniform(UniformHandle<glm::mat4> handle, const glm::mat4& value);
+       void SetUniform(UniformHandle<glm::mat3> handle, const glm::mat3& value);
+
        void SetUniform4f(const std::string& name, const glm::vec4& value);
        void SetUniform3f(const std::string& name, const glm::vec3& value);
        void SetUniform1f(const std::string& name, float value);
        void SetUniform1i(const std::string& name, int value);
        void SetUniformMatrix4(const std::string& name, const glm::mat4& value);
        void SetUniformMatrix3(const std::string& name, const glm::mat3& value);
+
+       // Looks the name up in the uniforms reflected at link time, -1 if the program has no such uniform
+       int32_t FindUniformLocation(std::string_view name) const;
+
+       static const UniformStats& GetStats() { return mStats; }
+       static void ResetStats() { mStats = {}; }
     private:
         int GetUniformLocation(const std::string& name);
     private:
-        const ShaderSource ParseShader();
-        uint32_t CompileAndLinkShader(const std::string& source, uint32_t type);
+        // retrievable keeps the binary around for ProgramCache::Store
+        bool LinkFromSource(const ShaderSource& source, bool retrievable);
+        uint32_t CompileAndLinkShader(const std::string& source, uint32_t type, const std::vector<std::string>& files);
+        void ReflectUniforms();
+        void InsertUniform(std::string_view name, int32_t location);
     private:
         uint32_t mRendererID;
+        uint32_t mID = 0;
         std::string mFilePath;
+        // The path and its defines, for log messages
+        std::string mName;
+
+        // Open addressing table of name hash -> location, sized to a power of two
+        struct UniformSlot {
+            uint64_t hash = 0;
+            int32_t location = -1;
+        };
+        std::vector<UniformSlot> mUniformTable;
+
+        inline static UniformStats mStats;
+        inline static uint32_t mNextID = 1;
     };
 
 }
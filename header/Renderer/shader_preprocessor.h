@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    struct ShaderSource {
+        std::optional<std::string> vertex;
+        std::optional<std::string> fragment;
+        std::optional<std::string> geometry;
+        std::optional<std::string> compute;
+        // Every file that went into the stages, the #line directives refer to them by index
+        std::vector<std::string> files;
+    };
+
+    enum class ShaderType {
+        UNKNOWN = 0,
+        VERTEX,
+        FRAGMENT,
+        GEOMETRY,
+        COMPUTE
+    };
+
+    // Injected as "#define name value" into every stage, an empty value defines just the name
+    struct ShaderDefine {
+        std::string name;
+        std::string value;
+    };
+    using ShaderDefines = std::vector<ShaderDefine>;
+
+    // Turns a .glsl file into the sources handed to GL. The file is split into stages at "#shader vertex",
+    // "fragment", "geometry" or "compute". #include "path" pastes a file relative to the one including it,
+    // at most once per stage like #pragma once, so shared blocks can be included from anywhere. The defines
+    // go right after each stage's #version line and #line directives keep compiler errors pointing at the
+    // right file and line.
+    class ShaderPreprocessor {
+    public:
+        // False when the file or one of its includes can't be read, the errors have been printed then
+        static bool Process(const std::string& filepath, const ShaderDefines& defines, ShaderSource& source);
+
+        // 0 without defines. Depends on their order, which also changes the generated source.
+        static uint64_t GetDefinesHash(const ShaderDefines& defines);
+        // "NAME=value NAME2" for log messages
+        static std::string DescribeDefines(const ShaderDefines& defines);
+    };
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Renderer/shader.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace OGLR {
+
+    // Specializations of one shader file, each set of defines is compiled the first time it is asked for
+    // and kept from then on, e.g. a lighting shader for exactly the lights of this frame. GL thread only.
+    class ShaderVariants {
+    public:
+        ShaderVariants(const std::string& filepath)
+            :mFilePath(filepath) {}
+
+        // The same defines in another order are another variant, see ShaderPreprocessor::GetDefinesHash
+        Shader* Get(const ShaderDefines& defines);
+        uint32_t GetCount() const { return static_cast<uint32_t>(mVariants.size()); }
+
+        // Drops every variant, the next Get compiles them again from the current files
+        void Reload() { mVariants.clear(); }
+    private:
+        std::string mFilePath;
+        std::unordered_map<uint64_t, std::unique_ptr<Shader>> mVariants;
+    };
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+namespace OGLR {
+
+    struct StagingStats {
+        uint64_t bytesUploaded = 0;
+        uint32_t bufferCopies = 0;
+        uint32_t textureCopies = 0;
+    };
+
+    // One mip level of a texture to upload. Rows are rows of texels, or of 4x4 blocks when compressed.
+    struct TextureLevelUpload {
+        uint32_t texture = 0;
+        uint32_t level = 0;
+        uint32_t width = 0, height = 0;
+        // Pixel format and type, or the compressed internal format with type unused
+        uint32_t format = 0;
+        uint32_t type = 0;
+        bool compressed = false;
+        const uint8_t* data = nullptr;
+        // Bytes per row, tightly packed as GL_UNPACK_ALIGNMENT 1 reads them
+        uint32_t rowSize = 0;
+
+        uint32_t GetRowCount() const { return compressed ? (height + 3) / 4 : height; }
+    };
+
+    // Caps the bytes that reach GPU resources per frame, so loading never costs a frame more than the
+    // budget. Data is copied into the StreamBuffer and from there by the GPU, into buffers with
+    // glCopyNamedBufferSubData and into textures from the stream buffer bound as GL_PIXEL_UNPACK_BUFFER,
+    // so the driver never has to copy client memory. Callers upload what fits and come back next frame
+    // for the rest. GL thread only, needs a StreamBuffer.
+    class StagingUploader {
+    public:
+        static void SetFrameBudget(uint32_t bytes) { mFrameBudget = bytes; }
+        static uint32_t GetFrameBudget() { return mFrameBudget; }
+
+        // Call after StreamBuffer::BeginFrame, refills the budget
+        static void BeginFrame();
+        static uint32_t GetRemaining() { return mRemaining; }
+
+        // Copies as much of the size bytes at data as the budget allows to buffer at offset, returns the bytes copied
+        static uint32_t CopyToBuffer(uint32_t buffer, uint32_t offset, const void* data, uint32_t size);
+        // Uploads as many rows from first_row on as the budget allows and returns how many. A frame that hasn't
+        // uploaded anything yet always takes one row, so a budget smaller than a row still makes progress.
+        static uint32_t UploadTextureRows(const TextureLevelUpload& level, uint32_t first_row);
+
+        // Totals of the last frame
+        static const StagingStats& GetStats() { return mLastStats; }
+    private:
+        inline static uint32_t mFrameBudget = 8 << 20;
+        inline static uint32_t mRemaining = 8 << 20;
+        inline static StagingStats mStats;
+        inline static StagingStats mLastStats;
+    };
+
+}
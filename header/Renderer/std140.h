@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+
+namespace OGLR {
+
+    // Base alignment and size of a type under the std140 rules. Structs not listed here are
+    // treated as std140 structs: 16 byte aligned and padded to a multiple of 16.
+    template <typename T>
+    struct Std140Traits {
+        static_assert(std::is_class_v<T>, "type has no std140 equivalent");
+        static constexpr size_t alignment = 16;
+        static constexpr size_t size = (sizeof(T) + 15) & ~size_t(15);
+    };
+
+    template <> struct Std140Traits<float>     { static constexpr size_t alignment = 4;  static constexpr size_t size = 4; };
+    template <> struct Std140Traits<int32_t>   { static constexpr size_t alignment = 4;  static constexpr size_t size = 4; };
+    template <> struct Std140Traits<uint32_t>  { static constexpr size_t alignment = 4;  static constexpr size_t size = 4; };
+    template <> struct Std140Traits<glm::vec2> { static constexpr size_t alignment = 8;  static constexpr size_t size = 8; };
+    template <> struct Std140Traits<glm::vec3> { static constexpr size_t alignment = 16; static constexpr size_t size = 12; };
+    template <> struct Std140Traits<glm::vec4> { static constexpr size_t alignment = 16; static constexpr size_t size = 16; };
+    template <> struct Std140Traits<glm::ivec4> { static constexpr size_t alignment = 16; static constexpr size_t size = 16; };
+    // Matrices are arrays of column vectors, each padded to a vec4
+    template <> struct Std140Traits<glm::mat3> { static constexpr size_t alignment = 16; static constexpr size_t size = 48; };
+    template <> struct Std140Traits<glm::mat4> { static constexpr size_t alignment = 16; static constexpr size_t size = 64; };
+
+    // Array elements are rounded up to a vec4, and the C++ element has to have that exact stride
+    template <typename T, size_t N>
+    struct Std140Traits<T[N]> {
+        static constexpr size_t stride = (Std140Traits<T>::size + 15) & ~size_t(15);
+        static_assert(sizeof(T) == stride, "C++ array element stride doesn't match std140, pad the element type");
+        static constexpr size_t alignment = 16;
+        static constexpr size_t size = stride * N;
+    };
+
+    // True when `offsets` (offsetof each member, in declaration order) and struct_size are exactly what
+    // GLSL computes for a std140 block declaring Members in that order. Use it in a static_assert:
+    //     static_assert(IsStd140Layout<decltype(Block::a), decltype(Block::b)>({ offsetof(Block, a), offsetof(Block, b) }, sizeof(Block)));
+    template <typename... Members>
+    constexpr bool IsStd140Layout(std::initializer_list<size_t> offsets, size_t struct_size) {
+        constexpr size_t alignments[] = { Std140Traits<std::remove_cv_t<Members>>::alignment... };
+        constexpr size_t sizes[] = { Std140Traits<std::remove_cv_t<Members>>::size... };
+        if (offsets.size() != sizeof...(Members))
+            return false;
+
+        size_t offset = 0;
+        const size_t* actual = offsets.begin();
+        for (size_t i = 0; i < sizeof...(Members); i++) {
+            offset = (offset + alignments[i] - 1) & ~(alignments[i] - 1);
+            if (actual[i] != offset)
+                return false;
+            offset += sizes[i];
+        }
+        return struct_size == ((offset + 15) & ~size_t(15));
+    }
+
+}
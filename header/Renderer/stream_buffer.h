@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace OGLR {
+
+    // Where an allocation landed. Bind buffer at offset, the buffer can change when the ring grows.
+    struct StreamAllocation {
+        void* data = nullptr;
+        uint32_t buffer = 0;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct StreamStats {
+        uint64_t bytesStreamed = 0;
+        uint32_t allocations = 0;
+        // BeginFrame found the GPU still reading the region it was about to reuse
+        uint32_t fenceStalls = 0;
+        double stallMs = 0.0;
+        uint32_t grows = 0;
+        // Since creation, a frame's grows are easy to miss
+        uint32_t totalGrows = 0;
+        // All FRAMES regions together
+        uint64_t bufferSize = 0;
+    };
+
+    // Per-frame data written straight into a persistently mapped, coherent buffer, no driver copies.
+    // The buffer is split into FRAMES regions, each frame allocates linearly from its own and fences
+    // it at the end, so the CPU only waits when it gets FRAMES frames ahead of the GPU. Create one
+    // right after the GL context and keep it alive longer than anything that streams through it.
+    class StreamBuffer {
+    public:
+        inline static const uint32_t FRAMES = 3;
+
+        StreamBuffer(uint32_t frame_size = 4 << 20);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        static StreamBuffer& Get() { return *mCurrent; }
+
+        // Waits for the next region to be free, everything allocated before is out of reach afterwards
+        void BeginFrame();
+        void EndFrame();
+
+        // Only valid until the BeginFrame FRAMES frames later. A frame that outgrows its region moves the
+        // ring into a larger buffer, earlier allocations keep their old one until the GPU is done with it.
+        StreamAllocation Allocate(uint32_t size, uint32_t alignment = 4);
+        template <typename T>
+        StreamAllocation Allocate(uint32_t count) { return Allocate(static_cast<uint32_t>(sizeof(T) * count), alignof(T) < 4 ? 4 : alignof(T)); }
+
+        // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+        uint32_t GetUniformAlignment() const { return mUniformAlignment; }
+        uint32_t GetStorageAlignment() const { return mStorageAlignment; }
+
+        uint32_t GetFrameSize() const { return mFrameSize; }
+        // Totals of the last frame, i.e. everything between the previous two EndFrame calls
+        const StreamStats& GetStats() const { return mLastStats; }
+    private:
+        void createBuffer(uint32_t frame_size);
+        // Waits for the fence and deletes it, true if it wasn't signaled yet
+        bool waitFence(GLsync& fence);
+    private:
+        struct RetiredBuffer {
+            uint32_t buffer;
+            GLsync fence;
+        };
+
+        uint32_t mBufferID = 0;
+        uint8_t* mMapped = nullptr;
+        uint32_t mFrameSize = 0;
+        GLsync mFences[FRAMES] = {};
+        uint32_t mFrame = 0;
+        uint32_t mCursor = 0;
+        // Outgrown buffers that in-flight frames may still read
+        std::vector<RetiredBuffer> mRetired;
+
+        uint32_t mUniformAlignment = 256;
+        uint32_t mStorageAlignment = 256;
+
+        StreamStats mStats;
+        StreamStats mLastStats;
+
+        inline static StreamBuffer* mCurrent = nullptr;
+    };
+
+}
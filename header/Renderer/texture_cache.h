@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Renderer/Texture2D.h>
+#include <Renderer/texture_loader.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OGLR {
+
+    // Shared reference to a cached texture, the GL texture is deleted with the last handle
+    using TextureHandle = std::shared_ptr<Texture2D>;
+
+    // Process wide texture cache keyed by the hash of the normalized path, so every model sharing an
+    // image shares one GL texture. Not thread safe, Acquire/Update and dropping handles happen on the GL thread.
+    class TextureCache {
+    public:
+        static TextureCache& Get();
+
+        // Returns the cached texture or a placeholder that turns into the real image once decoded.
+        // Normal maps are compressed to BC5, which keeps their two channels at full precision.
+        TextureHandle Acquire(const std::string& path, bool normal_map = false);
+
+        // Uploads textures the workers finished decoding within the StagingUploader budget. Each one is built
+        // into a texture of its own a few rows at a time and swapped in once complete, so nothing samples a
+        // half uploaded image.
+        void Update();
+
+        // Upload block compressed textures from .oglrtex containers instead of raw pixels.
+        // Enabled on the first Acquire when the driver supports it.
+        void SetCompressionEnabled(bool enabled) { mCompression = enabled ? Compression::Enabled : Compression::Disabled; }
+
+        uint32_t GetTextureCount() const { return static_cast<uint32_t>(mEntries.size()); }
+        // Still decoding or uploading. Textures whose image failed to load are settled too, they keep the placeholder.
+        bool IsPending(const TextureHandle& texture) const;
+        // Still decoding or uploading
+        uint32_t GetPendingCount() const { return mLoader.GetPendingCount() + (mUpload ? 1 : 0); }
+        size_t GetMemoryUsage() const { return mMemoryUsage; }
+        // Running total of texture data uploaded, take the difference across a frame for its share
+        uint64_t GetUploadedBytes() const { return mUploadedBytes; }
+
+        static std::string NormalizePath(const std::string& path);
+    private:
+        TextureCache() = default;
+
+        // Poll callback, keeps the image and creates the texture it goes into
+        bool beginUpload(DecodedImage& image);
+        // Poll callback for images that failed to decode
+        void failUpload(const DecodedImage& image);
+        // False when the budget ran out before the last row
+        bool continueUpload();
+        // A decode or upload still running for key, e.g. of an entry every handle was dropped from
+        bool isInFlight(uint64_t key) const;
+        void release(uint64_t key, Texture2D* texture);
+        void reportLoadTimes() const;
+    private:
+        // Deleter of every handle, IsPending finds the entry through the key it carries
+        struct Release {
+            TextureCache* cache;
+            uint64_t key;
+
+            void operator()(Texture2D* texture) const { cache->release(key, texture); }
+        };
+
+        struct PendingUpload {
+            uint64_t key;
+            DecodedImage image;
+            uint32_t texture = 0;
+            uint32_t levelCount = 0;
+            // Where the next UploadTextureRows call picks up
+            uint32_t level = 0;
+            uint32_t row = 0;
+        };
+
+        struct Entry {
+            std::string path;
+            std::weak_ptr<Texture2D> texture;
+            Texture2D* rawTexture;
+            size_t memorySize;
+            // Until the image is adopted or failed to load
+            bool pending = true;
+        };
+
+        std::unordered_map<uint64_t, Entry> mEntries;
+        // Decode requests still in flight, keyed by the loader's request id
+        std::unordered_map<uint32_t, uint64_t> mRequests;
+        TextureLoader mLoader;
+        std::optional<PendingUpload> mUpload;
+        size_t mMemoryUsage = 0;
+        uint64_t mUploadedBytes = 0;
+        double mUploadMs = 0.0;
+
+        enum class Compression { Unknown, Enabled, Disabled };
+        Compression mCompression = Compression::Unknown;
+    };
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    enum class BlockFormat : uint32_t {
+        BC1 = 1,    // RGB, 8 bytes per 4x4 block
+        BC3,        // RGBA, BC4 alpha + BC1 color, 16 bytes per block
+        BC5         // two BC4 channels, used for tangent space normal maps (XY)
+    };
+
+    struct CompressedLevel {
+        uint32_t width, height;
+        uint64_t offset, size;   // into CompressedTexture::data
+    };
+
+    // Block compressed image with its full, pre-generated mip chain
+    struct CompressedTexture {
+        BlockFormat format = BlockFormat::BC1;
+        uint32_t width = 0, height = 0;
+        std::vector<CompressedLevel> levels;
+        std::vector<uint8_t> data;
+
+        uint32_t GetGLFormat() const;
+        size_t GetMemorySize() const { return data.size(); }
+    };
+
+    // Pure CPU encoder/decoder, no GL involved, so results can be checked offline against the source images.
+    // Pixels are always tightly packed 8 bit RGBA.
+    class BlockCompressor {
+    public:
+        static uint32_t GetBlockSize(BlockFormat format);
+        // Normal maps get BC5, named as such or by normal_map, images with any non opaque texel BC3, everything else BC1
+        static BlockFormat SelectFormat(const std::string& path, const uint8_t* rgba, uint32_t width, uint32_t height,
+                                        bool normal_map = false);
+
+        static void EncodeBC1Block(const uint8_t rgba[64], uint8_t out[8]);
+        static void EncodeBC4Block(const uint8_t rgba[64], uint32_t channel, uint8_t out[8]);
+        static void EncodeBC3Block(const uint8_t rgba[64], uint8_t out[16]);
+        static void EncodeBC5Block(const uint8_t rgba[64], uint8_t out[16]);
+        static void DecodeBlock(BlockFormat format, const uint8_t* block, uint8_t rgba[64]);
+
+        static CompressedTexture Compress(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format, bool generate_mips = true);
+        static std::vector<uint8_t> Decompress(const CompressedTexture& texture, uint32_t level = 0);
+
+        // Over the first `channels` channels of two RGBA images
+        static double ComputePSNR(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height, uint32_t channels);
+
+        // Expands 1-4 component pixels to RGBA
+        static std::vector<uint8_t> ToRGBA(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components);
+    };
+
+    // KTX2 style container: identifier, header, level index, then the levels smallest mip first.
+    // The source key identifies the image it was built from, a mismatch means the file is stale.
+    // So does a different normal map hint, the format was picked with it.
+    class CompressedTextureFile {
+    public:
+        inline static const uint32_t VERSION = 2;
+
+        static std::string GetPath(const std::string& source_path) { return source_path + ".oglrtex"; }
+        // Cheap staleness key from the source file's size and modification time, 0 if it doesn't exist
+        static uint64_t GetSourceKey(const std::string& source_path);
+
+        static bool Read(const std::string& path, uint64_t source_key, bool normal_map, CompressedTexture& texture);
+        static bool Write(const std::string& path, uint64_t source_key, bool normal_map, const CompressedTexture& texture);
+    };
+
+}
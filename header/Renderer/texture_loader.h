@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Renderer/texture_compression.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace OGLR {
+
+    // Either raw pixels from stb_image or, when compression was requested, a block compressed mip chain
+    struct DecodedImage {
+        uint32_t request;
+        std::string path;
+        uint8_t* pixels;
+        uint32_t width, height;
+        uint32_t components;
+        CompressedTexture compressed;
+
+        bool IsCompressed() const { return !compressed.levels.empty(); }
+    };
+
+    // Wall-clock timings, in milliseconds, of a batch of texture loads
+    struct TextureLoadStats {
+        uint32_t requested = 0;
+        uint32_t uploaded = 0;
+        uint32_t failed = 0;
+        uint32_t workers = 0;
+        double decodeWallMs = 0.0;
+        double decodeCpuMs = 0.0;
+        double uploadMs = 0.0;
+    };
+
+    // Decodes images on ThreadPool::Get() and hands them back to the GL thread through a queue.
+    // Request() can be called from anywhere, Poll() must run on the thread owning the GL context.
+    class TextureLoader {
+    public:
+        TextureLoader();
+        ~TextureLoader();
+
+        TextureLoader(const TextureLoader&) = delete;
+        TextureLoader& operator=(const TextureLoader&) = delete;
+        TextureLoader(TextureLoader&&) = default;
+        TextureLoader& operator=(TextureLoader&&) = default;
+
+        // With compress set the image comes back block compressed, read from its .oglrtex container
+        // or encoded and written there on a miss. normal_map picks BC5 whatever the file is called.
+        uint32_t Request(const std::string& path, bool compress = false, bool normal_map = false);
+
+        // Hands up to max_uploads finished decodes to on_ready, which does the GL upload. The pixels are freed
+        // afterwards unless on_ready returns true, it then keeps the image and frees it with FreeImage once done.
+        // Images that failed to decode go to on_failed instead, if given, so the requester keeps its placeholder.
+        void Poll(const std::function<bool(DecodedImage& image)>& on_ready, uint32_t max_uploads = UINT32_MAX,
+                  const std::function<void(const DecodedImage& image)>& on_failed = nullptr);
+        static void FreeImage(DecodedImage& image);
+
+        uint32_t GetPendingCount() const { return mPending; }
+        const TextureLoadStats& GetStats() const { return mStats; }
+
+        // Loads the up to date container for the image at path, or builds and writes it.
+        // psnr, if given, receives the quality of level 0 against the source when it had to be built.
+        static bool LoadCompressed(const std::string& path, CompressedTexture& texture, double* psnr = nullptr, bool normal_map = false);
+        // Encodes the image at path without touching its container, e.g. to check the quality of the encoder
+        static bool Compress(const std::string& path, CompressedTexture& texture, double* psnr = nullptr, bool normal_map = false);
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        // Shared with in-flight jobs, so destroying the loader never leaves a worker with a dangling queue
+        struct SharedState {
+            std::mutex mutex;
+            std::deque<DecodedImage> finished;
+            std::atomic<int64_t> decodeCpuNs = 0;
+            std::atomic<int64_t> lastDecodeEndNs = 0;
+            // Set when the loader is destroyed, jobs finishing afterwards free their own image
+            bool closed = false;
+        };
+    private:
+        std::shared_ptr<SharedState> mState;
+        uint32_t mNextRequest = 0;
+        uint32_t mPending = 0;
+        // Decode wall time is measured from the loader's first request
+        Clock::time_point mFirstRequest;
+        TextureLoadStats mStats;
+    };
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <Renderer/light.h>
+#include <Renderer/std140.h>
+#include <Renderer/vertex_quantization.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace OGLR {
+
+    // Binding points every shader's blocks are attached to right after linking.
+    // ObjectData is a shader storage block, the other two are uniform blocks.
+    enum UniformBinding : uint32_t {
+        FRAME_BINDING = 0,
+        LIGHT_BINDING = 1,
+        OBJECT_BINDING = 2
+    };
+
+    struct UniformBlockName {
+        const char* name;
+        UniformBinding binding;
+    };
+    inline constexpr UniformBlockName UNIFORM_BLOCK_NAMES[] = {
+        { "FrameData", FRAME_BINDING },
+        { "LightData", LIGHT_BINDING }
+    };
+    inline constexpr UniformBlockName STORAGE_BLOCK_NAMES[] = {
+        { "ObjectData", OBJECT_BINDING }
+    };
+
+    inline constexpr uint32_t MAX_DIR_LIGHTS = 4;
+    inline constexpr uint32_t MAX_POINT_LIGHTS = 255;
+
+    // C++ mirrors of the blocks in res/shaders/include, checked against std140 below
+    struct FrameUniforms {
+        glm::mat4 view;
+        glm::mat4 proj;
+        glm::mat4 viewProj;
+    };
+
+    struct GPUDirectionalLight {
+        glm::vec3 direction;    // view space
+        float intensity;
+        glm::vec3 color;
+        float padding;
+    };
+
+    struct GPUPointLight {
+        glm::vec3 position;     // view space
+        float intensity;
+        glm::vec3 color;
+        float padding;
+    };
+
+    struct LightUniforms {
+        glm::ivec4 counts;      // x: directional lights, y: point lights
+        GPUDirectionalLight dirLights[MAX_DIR_LIGHTS];
+        GPUPointLight pointLights[MAX_POINT_LIGHTS];
+    };
+
+    // One element of the ObjectData storage array, std430 lays mat4s and vec4s out exactly like std140
+    struct ObjectUniforms {
+        glm::mat4 model;
+        glm::mat4 normalMatrix;     // world space, inverse transpose of model
+        glm::vec4 positionScale;    // w: normals are octahedral, see VertexDequantization
+        glm::vec4 positionOffset;
+    };
+
+    static_assert(IsStd140Layout<decltype(FrameUniforms::view), decltype(FrameUniforms::proj), decltype(FrameUniforms::viewProj)>(
+        { offsetof(FrameUniforms, view), offsetof(FrameUniforms, proj), offsetof(FrameUniforms, viewProj) }, sizeof(FrameUniforms)),
+        "FrameUniforms doesn't match std140");
+    static_assert(IsStd140Layout<decltype(GPUDirectionalLight::direction), decltype(GPUDirectionalLight::intensity),
+                                 decltype(GPUDirectionalLight::color), decltype(GPUDirectionalLight::padding)>(
+        { offsetof(GPUDirectionalLight, direction), offsetof(GPUDirectionalLight, intensity),
+          offsetof(GPUDirectionalLight, color), offsetof(GPUDirectionalLight, padding) }, sizeof(GPUDirectionalLight)),
+        "GPUDirectionalLight doesn't match std140");
+    static_assert(IsStd140Layout<decltype(GPUPointLight::position), decltype(GPUPointLight::intensity),
+                                 decltype(GPUPointLight::color), decltype(GPUPointLight::padding)>(
+        { offsetof(GPUPointLight, position), offsetof(GPUPointLight, intensity),
+          offsetof(GPUPointLight, color), offsetof(GPUPointLight, padding) }, sizeof(GPUPointLight)),
+        "GPUPointLight doesn't match std140");
+    static_assert(IsStd140Layout<decltype(LightUniforms::counts), decltype(LightUniforms::dirLights), decltype(LightUniforms::pointLights)>(
+        { offsetof(LightUniforms, counts), offsetof(LightUniforms, dirLights), offsetof(LightUniforms, pointLights) }, sizeof(LightUniforms)),
+        "LightUniforms doesn't match std140");
+    static_assert(IsStd140Layout<decltype(ObjectUniforms::model), decltype(ObjectUniforms::normalMatrix),
+                                 decltype(ObjectUniforms::positionScale), decltype(ObjectUniforms::positionOffset)>(
+        { offsetof(ObjectUniforms, model), offsetof(ObjectUniforms, normalMatrix),
+          offsetof(ObjectUniforms, positionScale), offsetof(ObjectUniforms, positionOffset) }, sizeof(ObjectUniforms)),
+        "ObjectUniforms doesn't match std140");
+
+    // GL buffer with a CPU shadow copy. Writes that change nothing are dropped and Flush only
+    // re-uploads the byte range that actually changed since the last flush.
+    class UniformBuffer {
+    public:
+        UniformBuffer(uint32_t size, uint32_t target = GL_UNIFORM_BUFFER);
+        ~UniformBuffer();
+
+        UniformBuffer(const UniformBuffer&) = delete;
+        UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+        void Write(uint32_t offset, const void* data, uint32_t size);
+        template <typename T>
+        void Write(uint32_t offset, const T& value) { Write(offset, &value, sizeof(T)); }
+
+        // Grows the buffer keeping its contents, the whole thing is uploaded on the next Flush
+        void Resize(uint32_t size);
+        void Flush();
+
+        void BindBase(uint32_t binding) const;
+        void BindRange(uint32_t binding, uint32_t offset, uint32_t size) const;
+
+        uint32_t GetSize() const { return static_cast<uint32_t>(mShadow.size()); }
+        uint64_t GetUploadedBytes() const { return mUploadedBytes; }
+    private:
+        uint32_t mRendererID = 0;
+        uint32_t mTarget;
+        std::vector<uint8_t> mShadow;
+        uint32_t mDirtyBegin = UINT32_MAX;
+        uint32_t mDirtyEnd = 0;
+        uint64_t mUploadedBytes = 0;
+    };
+
+    // Frame, light and per-object blocks shared by every shader. The engine writes into the current
+    // instance, create one right after the GL context and keep it alive longer than any Mesh.
+    // The frame block changes every frame and is streamed through the current StreamBuffer instead.
+    class UniformBlocks {
+    public:
+        UniformBlocks();
+        ~UniformBlocks();
+
+        UniformBlocks(const UniformBlocks&) = delete;
+        UniformBlocks& operator=(const UniformBlocks&) = delete;
+
+        static UniformBlocks& Get() { return *mCurrent; }
+
+        void SetFrame(const glm::mat4& view, const glm::mat4& proj);
+        // Light directions and positions are moved into view space here, like the shaders expect
+        void SetLights(const std::vector<DirectionalLight>& directional_lights, const std::vector<PointLight>& point_lights, const glm::mat4& view);
+
+        // Slots index the ObjectData array, shaders read theirs with gl_BaseInstance
+        uint32_t AllocateObject();
+        void FreeObject(uint32_t slot);
+        void SetObject(uint32_t slot, const glm::mat4& model, const VertexDequantization& dequantization = {});
+
+        // Uploads every changed range and binds the blocks to their binding points, once per frame
+        // between StreamBuffer::BeginFrame and EndFrame
+        void Flush();
+
+        // Total bytes sent to the GPU through the blocks so far
+        uint64_t GetUploadedBytes() const;
+    private:
+        FrameUniforms mFrame{};
+        uint64_t mStreamedBytes = 0;
+        UniformBuffer mLights;
+        UniformBuffer mObjects;
+        uint32_t mObjectCount = 0;
+        std::vector<uint32_t> mFreeObjects;
+
+        inline static UniformBlocks* mCurrent = nullptr;
+    };
+
+    // Owns one ObjectData slot of the current UniformBlocks
+    class ObjectSlot {
+    public:
+        ObjectSlot() :mSlot(UniformBlocks::Get().AllocateObject()) {}
+        ~ObjectSlot() { if (mSlot != INVALID) UniformBlocks::Get().FreeObject(mSlot); }
+
+        ObjectSlot(const ObjectSlot&) = delete;
+        ObjectSlot& operator=(const ObjectSlot&) = delete;
+        ObjectSlot(ObjectSlot&& other) noexcept :mSlot(other.mSlot) { other.mSlot = INVALID; }
+        ObjectSlot& operator=(ObjectSlot&& other) noexcept { std::swap(mSlot, other.mSlot); return *this; }
+
+        // Pass as the base instance of the draw
+        uint32_t Get() const { return mSlot; }
+        void Set(const glm::mat4& model, const VertexDequantization& dequantization = {}) const {
+            UniformBlocks::Get().SetObject(mSlot, model, dequantization);
+        }
+    private:
+        inline static const uint32_t INVALID = UINT32_MAX;
+        uint32_t mSlot;
+    };
+
+}
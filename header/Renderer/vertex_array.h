@@ -39,6 +39,8 @@ namespace OGLR {
 
         void Bind() const;
         void UnBind() const;
+
+        uint32_t GetID() const { return mRendererID; }
     private:
         uint32_t mRendererID;
     };
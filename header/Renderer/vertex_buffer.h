@@ -13,10 +13,20 @@ namespace OGLR {
         glm::vec2 tex_coords;
     };
 
+    // Attribute types with no C++ counterpart, both hold the raw bits GL reads
+    struct Half {
+        uint16_t bits;
+    };
+    // Signed, x in the low 10 bits and w in the top 2, read as GL_INT_2_10_10_10_REV
+    struct Packed1010102 {
+        uint32_t bits;
+    };
+
     class VertexBuffer {
     public:
         VertexBuffer() = default;
         VertexBuffer(const std::vector<Vertex>& bufferData);
+        VertexBuffer(const Vertex* data, uint32_t count);
         VertexBuffer(const std::vector<float>& bufferData);
 
         void Bind() const;
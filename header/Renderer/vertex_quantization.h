@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Renderer/vertex_array.h>
+#include <Renderer/vertex_buffer.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace OGLR {
+
+    enum class VertexFormat : uint32_t {
+        FLOAT32,    // Vertex as is, 32 bytes
+        QUANTIZED   // QuantizedVertex, 16 bytes
+    };
+
+    // Positions as unorm16 within the mesh bounds, octahedral snorm16 normals and half float UVs
+    struct QuantizedVertex {
+        uint16_t position[4];   // w is padding, keeps the normal 4 byte aligned
+        int16_t normal[2];
+        Half tex_coords[2];
+    };
+    static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex should stay 16 bytes");
+
+    // Brings what the vertex shader reads back to object space, stored per object next to the model matrix.
+    // Positions arrive normalized to [0, 1], the scale is the extent of the mesh bounds.
+    struct VertexDequantization {
+        glm::vec3 positionScale = glm::vec3(1.0f);
+        glm::vec3 positionOffset = glm::vec3(0.0f);
+        bool octahedralNormals = false;
+    };
+
+    // Largest differences between a mesh and its quantized copy, next to what the format promises
+    struct QuantizationError {
+        float position = 0.0f;          // object space units
+        float positionBound = 0.0f;     // half a quantization step along the longest axis
+        float normalDegrees = 0.0f;
+        float texCoord = 0.0f;          // relative to the coordinate's magnitude
+        bool IsWithinBounds() const;
+    };
+
+    Half FloatToHalf(float value);
+    float HalfToFloat(Half value);
+
+    // Maps the unit sphere onto the [-1, 1] square, the same decode lives in the shaders
+    glm::vec2 OctahedralEncode(const glm::vec3& normal);
+    glm::vec3 OctahedralDecode(const glm::vec2& encoded);
+
+    Packed1010102 PackSnorm1010102(const glm::vec4& value);
+    glm::vec4 UnpackSnorm1010102(Packed1010102 value);
+
+    class VertexQuantizer {
+    public:
+        inline static constexpr float NORMAL_ERROR_BOUND_DEGREES = 0.01f;
+        // Half floats keep 11 significant bits
+        inline static constexpr float TEX_COORD_ERROR_BOUND = 1.0f / 2048.0f;
+
+        // Positions are quantized against the bounds of exactly these vertices
+        static VertexDequantization Quantize(std::span<const Vertex> vertices, std::vector<QuantizedVertex>& quantized);
+        static Vertex Dequantize(const QuantizedVertex& vertex, const VertexDequantization& dequantization);
+        static QuantizationError MeasureError(std::span<const Vertex> vertices, std::span<const QuantizedVertex> quantized,
+                                              const VertexDequantization& dequantization);
+
+        // Attributes 0-2 are position, normal and UV in both formats
+        static VertexLayout GetLayout(VertexFormat format);
+        static uint32_t GetStride(VertexFormat format) { return format == VertexFormat::QUANTIZED ? sizeof(QuantizedVertex) : sizeof(Vertex); }
+    };
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <profiler.h>
+#include <Renderer/gpu_timer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    struct FrameSample {
+        uint64_t frame = 0;
+        float cpuMs = 0.0f;
+        // Negative until the GPU timer comes back, GpuTimer::LATENCY frames later
+        float gpuMs = -1.0f;
+        uint32_t draws = 0;
+        uint64_t triangles = 0;
+        uint64_t bytesUploaded = 0;
+    };
+
+    struct FrameZoneTime {
+        const char* name = nullptr;
+        float ms = 0.0f;
+    };
+
+    // A frame whose CPU or GPU time went over budget
+    struct Hitch {
+        uint64_t frame = 0;
+        float cpuMs = 0.0f;
+        float gpuMs = 0.0f;
+        // Slowest tagged zones of the frame, longest first, names are null past the last one
+        FrameZoneTime zones[3];
+    };
+
+    struct FrameTimes {
+        float min = 0.0f, avg = 0.0f, p50 = 0.0f, p95 = 0.0f, p99 = 0.0f, max = 0.0f;
+    };
+
+    struct FrameSummary {
+        uint64_t frames = 0;
+        uint64_t hitches = 0;
+        FrameTimes cpu, gpu;
+        double avgDraws = 0.0;
+        double avgTriangles = 0.0;
+        double avgBytesUploaded = 0.0;
+    };
+
+    // Per-frame CPU and GPU times and counters, kept for the last HISTORY frames in a ring other threads
+    // can read without locking. Every slot is guarded by a sequence number the GL thread makes odd while
+    // writing, readers retry when it changed under them. Frames over budget are kept as hitches together
+    // with their slowest OGLR_FRAME_ZONEs, once their GPU time is known.
+    class FrameStats {
+    public:
+        inline static const uint32_t HISTORY = 1024;
+        inline static const uint32_t MAX_HITCHES = 256;
+
+        // Needs the GL context, keep_all_frames also keeps every sample for the report and the summary
+        static void Start(float budget_ms, bool keep_all_frames = false);
+        // Waits for the last GPU times and releases the timer, call while the context is still alive
+        static void Finish();
+        // Forgets everything recorded so far, e.g. after warming up
+        static void Reset();
+
+        static void BeginFrame();
+        // Call once the frame's GL work is submitted, before presenting
+        static void EndFrame(uint32_t draws, uint64_t triangles, uint64_t bytes_uploaded);
+        // From OGLR_FRAME_ZONE, GL thread only
+        static void AddZoneTime(const char* name, float ms);
+
+        // Copies up to count of the newest samples, oldest first, from any thread
+        static uint32_t GetRecent(FrameSample* samples, uint32_t count);
+        // Rolling over the last HISTORY frames, or every frame with keep_all_frames
+        static FrameSummary GetSummary();
+        static const std::vector<Hitch>& GetHitches() { return mHitches; }
+        static uint64_t GetHitchCount() { return mHitchCount; }
+        static float GetBudget() { return mBudgetMs; }
+
+        // One row per frame
+        static bool WriteCSV(const std::string& path);
+        // Summary and hitches, stable keys for diffing between builds
+        static bool WriteJSON(const std::string& path);
+    private:
+        struct Slot {
+            std::atomic<uint32_t> sequence;
+            FrameSample sample;
+        };
+
+        static void write(const FrameSample& sample);
+        static void resolveGPU(uint64_t frame, float ms);
+        static std::vector<FrameSample> collect();
+        static FrameTimes computeTimes(std::vector<float>& ms);
+    private:
+        inline static Slot mRing[HISTORY];
+        inline static std::atomic<uint64_t> mWritten = 0;
+        inline static std::atomic<uint64_t> mFirstFrame = 0;
+        inline static uint64_t mFrame = 0;
+        inline static uint64_t mGpuResolved = 0;
+        inline static int64_t mFrameStart = 0;
+        inline static float mBudgetMs = 1000.0f / 60.0f;
+        inline static bool mKeepAll = false;
+        inline static std::unique_ptr<GpuTimer> mGpuTimer;
+
+        // GPU times arrive GpuTimer::LATENCY frames late, a frame's zones are kept until then
+        inline static std::vector<FrameZoneTime> mZones[GpuTimer::LATENCY + 1];
+        inline static std::vector<FrameSample> mAllSamples;
+        inline static std::vector<Hitch> mHitches;
+        inline static uint64_t mHitchCount = 0;
+    };
+
+    // A profiler zone that is also timed into the frame statistics on every frame, for the coarse
+    // steps of a frame that a hitch should be blamed on. GL thread only.
+    class FrameZone {
+    public:
+        FrameZone(const char* name)
+            :mZone(name), mName(name), mStart(Profiler::Now()) {
+        }
+        ~FrameZone() {
+            FrameStats::AddZoneTime(mName, (Profiler::Now() - mStart) / 1e6f);
+        }
+
+        FrameZone(const FrameZone&) = delete;
+        FrameZone& operator=(const FrameZone&) = delete;
+    private:
+        ProfileZone mZone;
+        const char* mName;
+        int64_t mStart;
+    };
+
+}
+
+#define OGLR_FRAME_ZONE(name) ::OGLR::FrameZone OGLR_PROFILE_CONCAT(frame_zone_, __LINE__)(name)
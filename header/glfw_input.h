@@ -8,26 +8,30 @@ namespace OGLR {
     class Input {
     public:
         static bool KeyPressed(uint32_t key) { return mPressedKeys[key]; }
-        static bool KeyHeld(uint32_t key) { return glfwGetKey(mCurrentWindow, key) == GLFW_PRESS; }
+        static bool KeyHeld(uint32_t key) { return mCurrentWindow && glfwGetKey(mCurrentWindow, key) == GLFW_PRESS; }
         static bool KeyReleased(uint32_t key) { return mReleasedKeys[key]; }
 
         static bool MouseButtonPressed(uint32_t button) { return mPressedMouseButtons[button]; }
-        static bool MouseButtonHeld(uint32_t button) { return glfwGetMouseButton(mCurrentWindow, button); }
+        static bool MouseButtonHeld(uint32_t button) { return mCurrentWindow && glfwGetMouseButton(mCurrentWindow, button); }
         static bool MouseButtonReleased(uint32_t button) { return mReleasedMouseButtons[button]; }
 
-        static void LockMouse() { glfwSetInputMode(mCurrentWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED); };
-        static void UnLockMouse() { glfwSetInputMode(mCurrentWindow, GLFW_CURSOR, GLFW_CURSOR_NORMAL); };
-        static bool IsMouseLocked() { return glfwGetInputMode(mCurrentWindow, GLFW_CURSOR) == GLFW_CURSOR_DISABLED; }
+        // Without a window (a headless run) nothing is ever held and the mouse stays put
+        static void LockMouse() { if (mCurrentWindow) glfwSetInputMode(mCurrentWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED); };
+        static void UnLockMouse() { if (mCurrentWindow) glfwSetInputMode(mCurrentWindow, GLFW_CURSOR, GLFW_CURSOR_NORMAL); };
+        static bool IsMouseLocked() { return mCurrentWindow && glfwGetInputMode(mCurrentWindow, GLFW_CURSOR) == GLFW_CURSOR_DISABLED; }
 
         static std::pair<float, float> GetMousePosition() {
-            double x, y;
-            glfwGetCursorPos(mCurrentWindow, &x, &y);
+            double x = 0.0, y = 0.0;
+            if (mCurrentWindow)
+                glfwGetCursorPos(mCurrentWindow, &x, &y);
             return std::make_pair(static_cast<float>(x), static_cast<float>(y));
         }
 
     protected:
         static void SetCurrentWindow(GLFWwindow* window) { mCurrentWindow = window; }
         static void OnUpdate() {
+            if (!mCurrentWindow)
+                return;
             glfwPollEvents();
             for (int key = 0; key < NUM_KEYS; key++) {
                 int current_key_state = glfwGetKey(mCurrentWindow, key);
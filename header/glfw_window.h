@@ -3,17 +3,28 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 #include <glfw_input.h>
+#include <offscreen_context.h>
 
+#include <memory>
 #include <string>
 #include <cstdint>
 
 namespace OGLR {
 
+    enum class GLBackend {
+        NATIVE,
+        // Real GL rendering into a framebuffer object, without a visible window. An EGL context when
+        // built with OGLR_ENABLE_EGL, a hidden GLFW window otherwise.
+        OFFSCREEN,
+        NULL_GL     // no window or context, GL calls are only counted, see NullGL
+    };
+
     struct WindowSpecs {
         std::string title = "OGLR Window";
         uint32_t width = 1280, height = 720;
         bool vsync = true;
         bool fullscreen = false;
+        GLBackend backend = GLBackend::NATIVE;
     };
 
     class Window {
@@ -22,13 +33,19 @@ namespace OGLR {
         ~Window();
 
         void OnUpdate() const;
-        bool ShouldClose() const { return glfwWindowShouldClose(mGLFWwindow); }
+        bool ShouldClose() const { return mGLFWwindow ? glfwWindowShouldClose(mGLFWwindow) : mClosed; }
         void Close() const;
 
         uint32_t GetWidth() const { return mSpecs.width; }
         uint32_t GetHeight() const { return mSpecs.height; }
         bool IsVSync() const { return mSpecs.vsync; }
         bool IsFullScreen() const { return mSpecs.fullscreen; }
+        bool IsHeadless() const { return mSpecs.backend != GLBackend::NATIVE; }
+
+        // What stands in for the default framebuffer, the offscreen target or 0
+        uint32_t GetFramebuffer() const { return mFramebuffer; }
+        // Writes the color of GetFramebuffer as a binary PPM
+        bool WriteImage(const std::string& path) const;
 
         void SetWidth(int width);
         void SetHeight(int height);
@@ -36,6 +53,10 @@ namespace OGLR {
 
         void Focus() const { Input::SetCurrentWindow(mGLFWwindow); }
     private:
+        void createOffscreen();
+        void createFramebuffer();
+        void deleteFramebuffer();
+
         static void DebugLogOGL(uint32_t source, uint32_t type, uint32_t id,
                                                     uint32_t severity, int32_t length,
                                                     const char* msg, const void* data);
@@ -43,6 +64,11 @@ namespace OGLR {
     protected:
         GLFWwindow* mGLFWwindow;
         WindowSpecs mSpecs;
+        mutable bool mClosed = false;
+        std::unique_ptr<OffscreenContext> mOffscreenContext;
+        uint32_t mFramebuffer = 0;
+        uint32_t mColorBuffer = 0;
+        uint32_t mDepthBuffer = 0;
     };
 
 }
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace OGLR {
+
+    inline constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    inline constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    // 64-bit FNV-1a, pass the previous result as seed to hash several blocks as one
+    inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    inline uint64_t HashString(std::string_view str, uint64_t seed = FNV_OFFSET_BASIS) {
+        return HashBytes(str.data(), str.size(), seed);
+    }
+
+}
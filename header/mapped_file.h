@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace OGLR {
+
+    // Read-only memory mapping of a whole file, unmapped when the object dies
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool IsOpen() const { return mData != nullptr; }
+        const uint8_t* GetData() const { return mData; }
+        size_t GetSize() const { return mSize; }
+    private:
+        void unmap();
+    private:
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+#ifdef _WIN32
+        void* mFileHandle = nullptr;
+        void* mMappingHandle = nullptr;
+#endif
+    };
+
+}
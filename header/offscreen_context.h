@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace OGLR {
+
+    // GL context without a window or display through EGL, surfaceless when the driver allows it and a
+    // 1x1 pbuffer otherwise. Mesa's llvmpipe provides one without a GPU. Only built with OGLR_ENABLE_EGL,
+    // Create fails otherwise. Nothing is presented, render into a framebuffer object.
+    class OffscreenContext {
+    public:
+        OffscreenContext() = default;
+        ~OffscreenContext();
+
+        OffscreenContext(const OffscreenContext&) = delete;
+        OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+        // Creates a core context of the given version, makes it current and loads GL through glad
+        bool Create(uint32_t major, uint32_t minor);
+    private:
+        // EGL handles, kept opaque so the EGL headers stay out of here
+        void* mDisplay = nullptr;
+        void* mSurface = nullptr;
+        void* mContext = nullptr;
+    };
+
+}
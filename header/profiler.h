@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace OGLR {
+
+    // Times are nanoseconds on the profiler's clock, GPU timestamps are moved onto it when a capture starts
+    struct ProfileEvent {
+        const char* name;
+        int64_t start;
+        int64_t duration;
+        uint32_t capture;
+    };
+
+    // Scoped CPU zones from any thread and GPU zones from the GL thread, collected while a capture runs
+    // and written as a Chrome trace, which chrome://tracing and Perfetto open. Outside a capture a zone
+    // costs one relaxed atomic load. Zone names must outlive the capture, use string literals.
+    //
+    // Each thread appends to its own buffer without locking, the buffer is registered once per thread
+    // and is never freed, so a trace can still be written after the thread is gone. A full buffer drops
+    // the rest of the capture's events. GPU zones are GL_TIMESTAMP query pairs read GPU_LATENCY frames
+    // later, pairs that still aren't done then are dropped rather than waited for.
+    class Profiler {
+    public:
+        inline static const uint32_t EVENTS_PER_THREAD = 1 << 16;
+        inline static const uint32_t GPU_LATENCY = 4;
+        inline static const uint32_t MAX_GPU_ZONES = 64;    // per frame
+
+        // Records the next frame_count frames and writes them to path, ignored while a capture runs
+        static void Capture(uint32_t frame_count, const std::string& path);
+        static bool IsCapturing() { return mCapturing.load(std::memory_order_relaxed); }
+        // Call on the GL thread at the top of every frame, collects GPU zones and finishes captures
+        static void BeginFrame();
+        // Ends a running capture early and writes what it has
+        static void Flush();
+
+        // Names the calling thread's track, the thread pool names its workers
+        static void SetThreadName(const std::string& name);
+
+        static int64_t Now();
+        static void RecordCPU(const char* name, int64_t start, int64_t end);
+        // Returns the zone for EndGPU, or UINT32_MAX when nothing is recorded
+        static uint32_t BeginGPU(const char* name);
+        static void EndGPU(uint32_t zone);
+    private:
+        struct ThreadBuffer {
+            uint32_t id;
+            std::string name;
+            std::vector<ProfileEvent> events;
+            // Events published to the writer, only the owning thread adds to it
+            std::atomic<uint32_t> count = 0;
+        };
+
+        static ThreadBuffer& threadBuffer();
+        // Without wait, zones the GPU hasn't finished yet are dropped
+        static void collectGPU(uint32_t slot, bool wait);
+        static void finish();
+        static bool writeTrace(const std::string& path);
+    private:
+        inline static std::atomic<bool> mCapturing = false;
+        inline static std::atomic<uint32_t> mCapture = 0;
+        inline static uint32_t mFramesLeft = 0;
+        inline static std::string mPath;
+        inline static int64_t mCaptureStart = 0;
+
+        inline static std::mutex mThreadsMutex;
+        inline static std::vector<std::unique_ptr<ThreadBuffer>> mThreads;
+
+        // GPU_LATENCY frames of MAX_GPU_ZONES begin and end queries each
+        inline static std::vector<uint32_t> mGpuQueries;
+        inline static std::vector<const char*> mGpuZones[GPU_LATENCY];
+        inline static uint32_t mGpuSlot = 0;
+        inline static int64_t mGpuClockOffset = 0;
+        inline static std::vector<ProfileEvent> mGpuEvents;
+        inline static uint32_t mGpuDropped = 0;
+    };
+
+    class ProfileZone {
+    public:
+        ProfileZone(const char* name)
+            :mName(Profiler::IsCapturing() ? name : nullptr), mStart(mName ? Profiler::Now() : 0) {
+        }
+        ~ProfileZone() {
+            if (mName && Profiler::IsCapturing())
+                Profiler::RecordCPU(mName, mStart, Profiler::Now());
+        }
+
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+    private:
+        const char* mName;
+        int64_t mStart;
+    };
+
+    // Only on the GL thread, zones can nest
+    class GpuProfileZone {
+    public:
+        GpuProfileZone(const char* name)
+            :mZone(Profiler::IsCapturing() ? Profiler::BeginGPU(name) : UINT32_MAX) {
+        }
+        ~GpuProfileZone() {
+            if (mZone != UINT32_MAX)
+                Profiler::EndGPU(mZone);
+        }
+
+        GpuProfileZone(const GpuProfileZone&) = delete;
+        GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+    private:
+        uint32_t mZone;
+    };
+
+}
+
+#define OGLR_PROFILE_CONCAT_(a, b) a##b
+#define OGLR_PROFILE_CONCAT(a, b) OGLR_PROFILE_CONCAT_(a, b)
+#define OGLR_PROFILE_ZONE(name) ::OGLR::ProfileZone OGLR_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define OGLR_PROFILE_GPU_ZONE(name) ::OGLR::GpuProfileZone OGLR_PROFILE_CONCAT(gpu_profile_zone_, __LINE__)(name)
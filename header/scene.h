@@ -1,30 +1,73 @@
 #pragma once
 
 #include <Renderer/model.h>
+#include <Renderer/light.h>
+#include <Renderer/bvh.h>
+#include <Renderer/occlusion_buffer.h>
+#include <Renderer/render_queue.h>
 
 #include <glm/glm.hpp>
 
 namespace OGLR {
 
-    struct DirectionalLight {
-        glm::vec3 direction;
-        glm::vec3 color;
-        float intensity;
+    struct SceneItem {
+        uint32_t model;
+        uint32_t mesh;
     };
 
-    struct PointLight {
-        glm::vec3 position;
-        glm::vec3 color;
-        float intensity;
-    };
-
-    // TODO: Add camera and optimize models
+    // TODO: Add camera
     struct Scene {
         std::vector<Model> models;
 
         // Lights
         std::vector<PointLight> point_lights;
         std::vector<DirectionalLight> directional_lights;
+
+        // Every mesh of every model, indexed like bvh_items
+        BVH bvh;
+        std::vector<SceneItem> bvh_items;
+
+        // Filled with every model's occluders, only re-rendered when the camera or a transform changes
+        OcclusionBuffer occlusion;
+        bool occlusion_culling = true;
+
+        // Call after removing models, transforms and new models are picked up by Update
+        void BuildBVH();
+        // Streams in model loads and refits only the meshes of models whose transform changed. Meshes that
+        // arrive while a model streams join the BVH at most every STREAMING_REBUILD_FRAMES frames, a new model
+        // or one that just finished streaming rebuilds it right away.
+        void Update();
+
+        // Culls through the BVH, then against the occlusion buffer, and submits what's left, see Model::Submit.
+        // With a pool the visible meshes are split into ranges that are tested, LOD selected and submitted
+        // on the workers, each into its own draw list. The draws come out the same either way.
+        void Submit(RenderQueue& queue, RenderPass pass, const MaterialShaders& shaders, const glm::mat4& view, const glm::mat4& proj,
+                    const LODSelection& lod = {}, ThreadPool* pool = nullptr);
+        // Closest mesh whose world bounds the ray hits
+        bool Pick(const Ray& ray, SceneItem& item, float& distance) const;
+        // Meshes within reach of a light or any other sphere
+        void GetMeshesInSphere(const glm::vec3& center, float radius, std::vector<SceneItem>& items) const;
+    private:
+        // Visible meshes per worker range
+        inline static const uint32_t SUBMIT_GRAIN = 1024;
+        // A full build per uploaded mesh would cost a frame's budget many times over while streaming
+        inline static const uint32_t STREAMING_REBUILD_FRAMES = 30;
+
+        struct RangeStats {
+            OcclusionStats occlusion;
+            LODStats lod;
+        };
+
+        std::vector<uint32_t> mModelFirstItem;
+        std::vector<uint64_t> mModelVersions;
+        std::vector<uint32_t> mModelMeshCounts;
+        uint32_t mFramesSinceBuild = 0;
+        std::vector<uint32_t> mVisible;
+        std::vector<RangeStats> mRangeStats;
+        glm::mat4 mOcclusionViewProj = glm::mat4(1.0f);
+        bool mOcclusionValid = false;
+
+        void updateOcclusion(const glm::mat4& view_proj);
     };
-    
-}
\ No newline at end of file
+
+}
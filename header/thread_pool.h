@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OGLR {
+
+    class ThreadPool {
+    public:
+        // 0 picks one worker per core, minus the one driving the GL context
+        ThreadPool(uint32_t thread_count = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void Submit(std::function<void()> job);
+        // Blocks until every submitted job has finished
+        void Wait();
+        // Splits [0, count) into ranges of at most grain items (at least 1) and runs body(range, begin, end) on each, on the
+        // workers and the calling thread, returning once every range is done. Ranges are handed out from a
+        // shared counter, so a worker still busy with an earlier job, e.g. decoding a texture, never holds the
+        // caller up, it finds nothing left once it gets there.
+        void ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t, uint32_t)>& body);
+
+        uint32_t GetThreadCount() const { return static_cast<uint32_t>(mThreads.size()); }
+
+        // Process wide pool shared by the loaders
+        static ThreadPool& Get();
+    private:
+        void workerLoop(uint32_t index);
+    private:
+        std::vector<std::thread> mThreads;
+        std::deque<std::function<void()>> mJobs;
+        std::mutex mMutex;
+        std::condition_variable mJobAvailable;
+        std::condition_variable mJobsDone;
+        uint32_t mActiveJobs = 0;
+        bool mStopping = false;
+    };
+
+}
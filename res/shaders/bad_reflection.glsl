@@ -1,26 +1,28 @@
 #shader vertex
-#version 330 core
+#version 460 core
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inTex;
 
-uniform mat4 mvp;
-uniform mat4 mvMatrix;
-uniform mat4 normalMatrix;
+#include "include/frame_data.glsl"
+#include "include/object_data.glsl"
 
 out vec3 fragNormal;
 out vec3 fragPosition;
 out vec2 texCoord;
 
 void main() {
-    fragPosition = vec3(mvMatrix * vec4(inPosition, 1.0f));
+    ObjectUniforms object = objects[gl_BaseInstance];
+    vec3 position = inPosition * object.positionScale.xyz + object.positionOffset.xyz;
+    vec4 worldPosition = object.model * vec4(position, 1.0f);
+    fragPosition = vec3(view * worldPosition);
     texCoord = inTex;
 
-    gl_Position = mvp * vec4(inPosition, 1.0f);
+    gl_Position = viewProj * worldPosition;
 }
 
 #shader fragment
-#version 330 core
+#version 460 core
 
 in vec3 fragPosition;
 in vec2 texCoord;
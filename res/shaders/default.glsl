@@ -1,32 +1,33 @@
 #shader vertex
-#version 330 core
+#version 460 core
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTex;
 
-uniform mat4 mvp;
-uniform mat4 mvMatrix;
-uniform mat4 normalMatrix;
+#include "include/frame_data.glsl"
+#include "include/object_data.glsl"
 
 out vec3 fragNormal;
 out vec3 fragPosition;
 out vec2 texCoord;
 
 void main() {
-    fragPosition = vec3(mvMatrix * vec4(inPosition, 1.0f));
-    fragNormal = normalize(mat3(normalMatrix) * inNormal); 
+    ObjectUniforms object = objects[gl_BaseInstance];
+    // Quantized meshes arrive in [0, 1] of their bounds, full float ones get a scale of 1 and no offset
+    vec3 position = inPosition * object.positionScale.xyz + object.positionOffset.xyz;
+    vec3 normal = object.positionScale.w != 0.0f ? octahedralDecode(inNormal.xy) : inNormal;
+    vec4 worldPosition = object.model * vec4(position, 1.0f);
+    fragPosition = vec3(view * worldPosition);
+    fragNormal = normalize(mat3(view) * mat3(object.normalMatrix) * normal); 
     texCoord = inTex;
 
-    gl_Position = mvp * vec4(inPosition, 1.0f);
+    gl_Position = viewProj * worldPosition;
 }
 
 
 #shader fragment
-#version 330 core
-
-#define MAX_DIR_LIGHTS 4
-#define MAX_POINT_LIGHTS 255
+#version 460 core
 
 in vec3 fragNormal;
 in vec3 fragPosition;
@@ -34,57 +35,89 @@ in vec2 texCoord;
 
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
-
-struct DirLight { 
-    vec3 direction;
-    vec3 color;
-    float intensity;
-};
-
-struct PointLight {
-    vec3 position;
-    vec3 color;
-    float intensity;
-};
-
-uniform int dir_lights_count;
-uniform DirLight dir_lights[MAX_DIR_LIGHTS];
-uniform int point_lights_count;
-uniform PointLight point_lights[MAX_POINT_LIGHTS];
+uniform sampler2D texture_normal1;
+
+#include "include/lights.glsl"
+
+// Variants fix these at compile time, so loops over lights that don't exist and the specular fetch
+// of materials without a map compile away. Without them the counts come from LightData.
+#ifndef DIR_LIGHT_COUNT
+#define DIR_LIGHT_COUNT light_counts.x
+#endif
+#ifndef POINT_LIGHT_COUNT
+#define POINT_LIGHT_COUNT light_counts.y
+#endif
+#ifndef SPECULAR_MAP
+#define SPECULAR_MAP 1
+#endif
+#ifndef NORMAL_MAP
+#define NORMAL_MAP 0
+#endif
 
 out vec4 fragColor;
 
+#if NORMAL_MAP
+// Meshes carry no tangents, the frame comes from the screen space derivatives of position and UV
+mat3 cotangentFrame(vec3 normal, vec3 position, vec2 uv) {
+    vec3 dp1 = dFdx(position);
+    vec3 dp2 = dFdy(position);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    vec3 dp2perp = cross(dp2, normal);
+    vec3 dp1perp = cross(normal, dp1);
+    vec3 tangent = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 bitangent = dp2perp * duv1.y + dp1perp * duv2.y;
+    float invmax = inversesqrt(max(max(dot(tangent, tangent), dot(bitangent, bitangent)), 1e-20f));
+    return mat3(tangent * invmax, bitangent * invmax, normal);
+}
+#endif
+
 void main() {
     vec3 normal = normalize(fragNormal);
+#if NORMAL_MAP
+    // BC5 keeps only x and y, z is rebuilt the same way for uncompressed maps
+    vec2 tangent_xy = texture(texture_normal1, texCoord).xy * 2.0f - 1.0f;
+    vec3 tangent_normal = vec3(tangent_xy, sqrt(max(1.0f - dot(tangent_xy, tangent_xy), 0.0f)));
+    normal = normalize(cotangentFrame(normal, fragPosition, texCoord) * tangent_normal);
+#endif
     vec3 viewDir = -normalize(fragPosition);
 
     // texture colors
     vec3 diff_color = texture(texture_diffuse1, texCoord).xyz;
+#if SPECULAR_MAP
     vec3 spec_color = texture(texture_specular1, texCoord).xyz;
+#endif
     vec3 ambient = 0.15f * diff_color * dir_lights[0].color;
 
     // Light calculations
     vec3 result = ambient;
-    for (int i = 0; i < dir_lights_count; i++) {
+    for (int i = 0; i < DIR_LIGHT_COUNT; i++) {
         vec3 lightDirection = -normalize(dir_lights[i].direction);
         float geo_term = max(dot(normal, lightDirection), 0.0f);
         vec3 diffuse = geo_term * diff_color;
 
+        vec3 specular = vec3(0.0f);
+#if SPECULAR_MAP
         vec3 halfVec = normalize(lightDirection + viewDir);
         float spec = pow(max(dot(normal, halfVec), 0.0f), 32);
-        vec3 specular = spec * spec_color;
+        specular = spec * spec_color;
+#endif
 
         result += dir_lights[i].intensity * (diffuse + specular);
     };
 
-    for (int i = 0; i < point_lights_count; i++) {
+    for (int i = 0; i < POINT_LIGHT_COUNT; i++) {
         vec3 lightDirection = -normalize(point_lights[i].position - viewDir);
         float geo_term = max(dot(normal, lightDirection), 0.0f);
         vec3 diffuse = geo_term * diff_color;
 
+        vec3 specular = vec3(0.0f);
+#if SPECULAR_MAP
         vec3 halfVec = normalize(lightDirection + viewDir);
         float spec = pow(max(dot(normal, halfVec), 0.0f), 32);
-        vec3 specular = spec * spec_color;
+        specular = spec * spec_color;
+#endif
 
         result += point_lights[i].intensity * (diffuse + specular);
     };
@@ -0,0 +1,6 @@
+// FrameUniforms in uniform_buffer.h
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+};
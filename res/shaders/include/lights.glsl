@@ -0,0 +1,19 @@
+// LightUniforms in uniform_buffer.h, the Shader class defines MAX_DIR_LIGHTS and MAX_POINT_LIGHTS to match it
+struct DirLight {
+    vec3 direction;
+    float intensity;
+    vec3 color;
+};
+
+struct PointLight {
+    vec3 position;
+    float intensity;
+    vec3 color;
+};
+
+// x: directional lights, y: point lights
+layout(std140) uniform LightData {
+    ivec4 light_counts;
+    DirLight dir_lights[MAX_DIR_LIGHTS];
+    PointLight point_lights[MAX_POINT_LIGHTS];
+};
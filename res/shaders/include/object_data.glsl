@@ -0,0 +1,20 @@
+// ObjectUniforms in uniform_buffer.h
+struct ObjectUniforms {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 positionScale;     // w: normals are octahedral
+    vec4 positionOffset;
+};
+
+// Indexed by the draw's base instance, so one multi-draw can cover many objects
+layout(std430) readonly buffer ObjectData {
+    ObjectUniforms objects[];
+};
+
+// Inverse of OctahedralEncode in vertex_quantization.cpp
+vec3 octahedralDecode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0f);
+    normal.xy += vec2(normal.x >= 0.0f ? -fold : fold, normal.y >= 0.0f ? -fold : fold);
+    return normalize(normal);
+}
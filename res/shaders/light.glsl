@@ -1,29 +1,33 @@
 #shader vertex
-#version 330 core
+#version 460 core
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTex;
 
-uniform mat4 mvp;
-uniform mat4 mvMatrix;
-uniform mat4 normalMatrix;
+#include "include/frame_data.glsl"
+#include "include/object_data.glsl"
 
 out vec3 fragNormal;
 out vec3 fragPosition;
 out vec2 texCoord;
 
 void main() {
-    fragPosition = vec3(mvMatrix * vec4(inPosition, 1.0f));
-    fragNormal = normalize(mat3(normalMatrix) * inNormal);
+    ObjectUniforms object = objects[gl_BaseInstance];
+    // Quantized meshes arrive in [0, 1] of their bounds, full float ones get a scale of 1 and no offset
+    vec3 position = inPosition * object.positionScale.xyz + object.positionOffset.xyz;
+    vec3 normal = object.positionScale.w != 0.0f ? octahedralDecode(inNormal.xy) : inNormal;
+    vec4 worldPosition = object.model * vec4(position, 1.0f);
+    fragPosition = vec3(view * worldPosition);
+    fragNormal = normalize(mat3(view) * mat3(object.normalMatrix) * normal);
     texCoord = inTex;
 
-    gl_Position = mvp * vec4(inPosition, 1.0f);
+    gl_Position = viewProj * worldPosition;
 }
 
 
 #shader fragment
-#version 330 core
+#version 460 core
 
 in vec3 fragNormal;
 in vec3 fragPosition;
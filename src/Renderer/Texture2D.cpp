@@ -1,14 +1,20 @@
 #include <Renderer/Texture2D.h>
+#include <Renderer/gl_state.h>
 #include <glad/glad.h>
 
+#include <cstring>
+#include <utility>
+
 namespace OGLR {
 
       Texture2D::Texture2D(const uint8_t* data, const TextureSpecs& specs)
       :mSpecs(specs) {
             glGenTextures(1, &mRendererID);
-            glBindTexture(GL_TEXTURE_2D, mRendererID);
+            // Unit 0 is the active one, so this is also what the GL_TEXTURE_2D calls below edit
+            GLState::BindTexture(0, mRendererID);
             glTexImage2D(GL_TEXTURE_2D, 0, specs.format, specs.width, specs.height, 0, specs.format, GL_UNSIGNED_BYTE, data);
             glGenerateMipmap(GL_TEXTURE_2D);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
 
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -16,12 +22,77 @@ namespace OGLR {
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
       }
 
-      void Texture2D::Bind() const {
-            glBindTexture(GL_TEXTURE_2D, mRendererID);
+      Texture2D::~Texture2D() {
+            if (mRendererID) {
+                  GLState::ForgetTexture(mRendererID);
+                  glDeleteTextures(1, &mRendererID);
+            }
+      }
+
+      Texture2D::Texture2D(Texture2D&& other) noexcept {
+            *this = std::move(other);
+      }
+
+      Texture2D& Texture2D::operator=(Texture2D&& other) noexcept {
+            std::swap(mRendererID, other.mRendererID);
+            std::swap(mSpecs, other.mSpecs);
+            std::swap(mCompressedSize, other.mCompressedSize);
+            return *this;
+      }
+
+      void Texture2D::Adopt(uint32_t texture, const TextureSpecs& specs, size_t compressed_size) {
+            if (mRendererID) {
+                  GLState::ForgetTexture(mRendererID);
+                  glDeleteTextures(1, &mRendererID);
+            }
+            mRendererID = texture;
+            mSpecs = specs;
+            mCompressedSize = compressed_size;
+      }
+
+      void Texture2D::Bind(uint32_t unit) const {
+            GLState::BindTexture(unit, mRendererID);
+      }
+
+      void Texture2D::UnBind(uint32_t unit) const {
+            GLState::BindTexture(unit, 0);
+      }
+
+      size_t Texture2D::GetMemorySize() const {
+            if (mCompressedSize)
+                  return mCompressedSize;
+
+            size_t bytes_per_texel = 4;
+            switch (mSpecs.format) {
+                  case GL_RED: bytes_per_texel = 1; break;
+                  case GL_RG:  bytes_per_texel = 2; break;
+                  case GL_RGB: bytes_per_texel = 3; break;
+            }
+            // A full mip chain adds a third on top of the base level
+            size_t base = static_cast<size_t>(mSpecs.width) * mSpecs.height * bytes_per_texel;
+            return base + base / 3;
+      }
+
+      Texture2D Texture2D::CreatePlaceholder(const std::string& path) {
+            static const uint8_t grey[3] = { 128, 128, 128 };
+            TextureSpecs specs;
+            specs.path = path;
+            specs.width = 1;
+            specs.height = 1;
+            specs.format = GL_RGB;
+
+            return Texture2D(grey, specs);
       }
 
-      void Texture2D::UnBind() const {
-            glBindTexture(GL_TEXTURE_2D, 0);
+      bool Texture2D::SupportsBlockCompression() {
+            int extension_count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+            for (int i = 0; i < extension_count; i++) {
+                  const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                  if (extension && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+                        return true;
+            }
+            return false;
       }
 
 }
@@ -0,0 +1,391 @@
+#include <Renderer/bvh.h>
+
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace OGLR {
+
+    namespace {
+
+        const uint32_t SAH_BINS = 16;
+        const uint32_t MAX_LEAF_ITEMS = 4;
+        // Cost of visiting a node relative to testing one item
+        const float TRAVERSAL_COST = 1.0f;
+        // Smaller ranges aren't worth a trip through the pool
+        const uint32_t MIN_PARALLEL_ITEMS = 2048;
+
+        bool sameBounds(const AABB& a, const AABB& b) {
+            return a.min == b.min && a.max == b.max;
+        }
+
+        // Entry distance along the ray, FLT_MAX when it misses or enters beyond max_distance
+        float intersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance) {
+            glm::vec3 t0 = (box.min - origin) * inverse_direction;
+            glm::vec3 t1 = (box.max - origin) * inverse_direction;
+            glm::vec3 near = glm::min(t0, t1);
+            glm::vec3 far = glm::max(t0, t1);
+            float enter = glm::max(glm::max(near.x, near.y), glm::max(near.z, 0.0f));
+            float exit = glm::min(glm::min(far.x, far.y), glm::min(far.z, max_distance));
+            return enter <= exit ? enter : FLT_MAX;
+        }
+
+        bool overlapsSphere(const AABB& box, const glm::vec3& center, float radius) {
+            glm::vec3 offset = center - glm::clamp(center, box.min, box.max);
+            return glm::dot(offset, offset) <= radius * radius;
+        }
+
+    }
+
+    void BVH::Build(std::span<const AABB> bounds) {
+        uint32_t count = static_cast<uint32_t>(bounds.size());
+        mItemBounds.assign(bounds.begin(), bounds.end());
+        mCentroids.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+            mCentroids[i] = mItemBounds[i].IsValid() ? mItemBounds[i].GetCenter() : glm::vec3(0.0f);
+        mItems.resize(count);
+        std::iota(mItems.begin(), mItems.end(), 0u);
+        mItemLeaf.assign(count, INVALID);
+        mNodes.clear();
+        if (count == 0)
+            return;
+        mNodes.reserve(2 * count);
+
+        // The top of the tree is split here, every range below the threshold becomes a task. Four per
+        // worker keeps them all busy when the SAH splits come out uneven.
+        uint32_t workers = ThreadPool::Get().GetThreadCount();
+        mDeferThreshold = std::max(MIN_PARALLEL_ITEMS, count / (workers * 4));
+        std::vector<DeferredSubtree> deferred;
+        buildRange(mNodes, 0, count, INVALID, count > mDeferThreshold ? &deferred : nullptr);
+
+        if (!deferred.empty()) {
+            // The caller builds subtrees too, so this finishes even when every worker is busy or it runs on one
+            uint32_t subtree_count = static_cast<uint32_t>(deferred.size());
+            ThreadPool::Get().ParallelFor(subtree_count, 1, [this, &deferred](uint32_t subtree, uint32_t, uint32_t) {
+                buildRange(deferred[subtree].nodes, deferred[subtree].begin, deferred[subtree].end, INVALID, nullptr);
+            });
+            for (DeferredSubtree& subtree : deferred)
+                stitch(subtree);
+        }
+
+        for (uint32_t node = 0; node < mNodes.size(); node++) {
+            for (uint32_t i = mNodes[node].first; i < mNodes[node].first + mNodes[node].count; i++)
+                mItemLeaf[mItems[i]] = node;
+        }
+    }
+
+    void BVH::Update(uint32_t item, const AABB& bounds) {
+        mItemBounds[item] = bounds;
+        mCentroids[item] = bounds.IsValid() ? bounds.GetCenter() : glm::vec3(0.0f);
+
+        // Walks up until a node's bounds come out unchanged, everything above it is still correct
+        for (uint32_t node = mItemLeaf[item]; node != INVALID; node = mNodes[node].parent) {
+            AABB refit;
+            if (mNodes[node].IsLeaf()) {
+                for (uint32_t i = mNodes[node].first; i < mNodes[node].first + mNodes[node].count; i++)
+                    refit.Expand(mItemBounds[mItems[i]]);
+            } else {
+                refit.Expand(mNodes[mNodes[node].left].bounds);
+                refit.Expand(mNodes[mNodes[node].right].bounds);
+            }
+            if (sameBounds(refit, mNodes[node].bounds))
+                break;
+            mNodes[node].bounds = refit;
+        }
+    }
+
+    void BVH::CullFrustum(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+        visible.clear();
+        if (mNodes.empty())
+            return;
+
+        // Each entry carries the planes its parent wasn't already entirely inside of
+        struct Entry {
+            uint32_t node;
+            uint32_t planes;
+        };
+        const uint32_t ALL_PLANES = 0x3F;
+        std::vector<Entry> stack;
+        stack.reserve(64);
+        stack.push_back({ 0, ALL_PLANES });
+
+        CullingStats stats;
+        auto classify = [&](const AABB& box, uint32_t& planes) {
+            glm::vec3 center = box.GetCenter();
+            glm::vec3 extents = box.GetExtents();
+            for (uint32_t p = 0; p < 6; p++) {
+                if (!(planes & (1u << p)))
+                    continue;
+                const glm::vec4& plane = frustum.planes[p];
+                float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+                float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+                if (distance + radius < 0.0f)
+                    return false;
+                if (distance - radius >= 0.0f)
+                    planes &= ~(1u << p);
+            }
+            return true;
+        };
+
+        while (!stack.empty()) {
+            Entry entry = stack.back();
+            stack.pop_back();
+            const Node& node = mNodes[entry.node];
+            stats.nodesVisited++;
+
+            uint32_t planes = entry.planes;
+            if (!node.bounds.IsValid() || !classify(node.bounds, planes))
+                continue;
+            // Items under a node found entirely inside pass with it, ones under a culled node are never tested
+            if (planes == 0) {
+                size_t first = visible.size();
+                appendSubtree(entry.node, visible);
+                stats.tested += visible.size() - first;
+                continue;
+            }
+            if (node.IsLeaf()) {
+                stats.tested += node.count;
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    uint32_t item_planes = planes;
+                    if (mItemBounds[mItems[i]].IsValid() && classify(mItemBounds[mItems[i]], item_planes))
+                        visible.push_back(mItems[i]);
+                }
+                continue;
+            }
+            stack.push_back({ node.left, planes });
+            stack.push_back({ node.right, planes });
+        }
+
+        stats.visible = visible.size();
+        FrustumCuller::AddStats(stats);
+    }
+
+    bool BVH::Raycast(const Ray& ray, RayHit& hit, float max_distance) const {
+        hit = {};
+        if (mNodes.empty())
+            return false;
+
+        glm::vec3 inverse_direction = 1.0f / ray.direction;
+        float closest = max_distance;
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        if (intersectRay(mNodes[0].bounds, ray.origin, inverse_direction, closest) != FLT_MAX)
+            stack.push_back(0);
+
+        while (!stack.empty()) {
+            const Node& node = mNodes[stack.back()];
+            stack.pop_back();
+            if (intersectRay(node.bounds, ray.origin, inverse_direction, closest) == FLT_MAX)
+                continue;
+
+            if (node.IsLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    float distance = intersectRay(mItemBounds[mItems[i]], ray.origin, inverse_direction, closest);
+                    if (distance < closest) {
+                        closest = distance;
+                        hit.item = mItems[i];
+                        hit.distance = distance;
+                    }
+                }
+                continue;
+            }
+
+            // Nearer child goes on top so it can shrink closest before the other one is tested
+            float left = intersectRay(mNodes[node.left].bounds, ray.origin, inverse_direction, closest);
+            float right = intersectRay(mNodes[node.right].bounds, ray.origin, inverse_direction, closest);
+            uint32_t near_child = left <= right ? node.left : node.right;
+            uint32_t far_child = left <= right ? node.right : node.left;
+            if (glm::max(left, right) != FLT_MAX)
+                stack.push_back(far_child);
+            if (glm::min(left, right) != FLT_MAX)
+                stack.push_back(near_child);
+        }
+        return hit.item != INVALID;
+    }
+
+    void BVH::OverlapSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& items) const {
+        items.clear();
+        if (mNodes.empty())
+            return;
+
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node = mNodes[stack.back()];
+            stack.pop_back();
+            if (!node.bounds.IsValid() || !overlapsSphere(node.bounds, center, radius))
+                continue;
+
+            if (node.IsLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    const AABB& box = mItemBounds[mItems[i]];
+                    if (box.IsValid() && overlapsSphere(box, center, radius))
+                        items.push_back(mItems[i]);
+                }
+                continue;
+            }
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    uint32_t BVH::buildRange(std::vector<Node>& nodes, uint32_t begin, uint32_t end, uint32_t parent, std::vector<DeferredSubtree>* deferred) {
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes[index].parent = parent;
+        if (deferred && end - begin <= mDeferThreshold) {
+            deferred->push_back({ index, begin, end, {} });
+            return index;
+        }
+
+        AABB bounds;
+        for (uint32_t i = begin; i < end; i++)
+            bounds.Expand(mItemBounds[mItems[i]]);
+        nodes[index].bounds = bounds;
+
+        uint32_t split = splitRange(begin, end, bounds);
+        if (split == begin) {
+            nodes[index].first = begin;
+            nodes[index].count = end - begin;
+            return index;
+        }
+        // nodes may reallocate while the children are built, only index into it afterwards
+        uint32_t left = buildRange(nodes, begin, split, index, deferred);
+        uint32_t right = buildRange(nodes, split, end, index, deferred);
+        nodes[index].left = left;
+        nodes[index].right = right;
+        return index;
+    }
+
+    uint32_t BVH::splitRange(uint32_t begin, uint32_t end, const AABB& bounds) {
+        uint32_t count = end - begin;
+        if (count <= 1)
+            return begin;
+
+        AABB centroid_bounds;
+        for (uint32_t i = begin; i < end; i++)
+            centroid_bounds.Expand(mCentroids[mItems[i]]);
+
+        struct Bin {
+            AABB bounds;
+            uint32_t count = 0;
+        };
+        float best_cost = FLT_MAX;
+        int best_axis = -1;
+        uint32_t best_bin = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            float low = centroid_bounds.min[axis];
+            float extent = centroid_bounds.max[axis] - low;
+            if (extent <= 0.0f)
+                continue;
+
+            std::array<Bin, SAH_BINS> bins{};
+            float scale = SAH_BINS / extent;
+            for (uint32_t i = begin; i < end; i++) {
+                uint32_t bin = std::min(SAH_BINS - 1, static_cast<uint32_t>((mCentroids[mItems[i]][axis] - low) * scale));
+                bins[bin].bounds.Expand(mItemBounds[mItems[i]]);
+                bins[bin].count++;
+            }
+
+            // Suffix sweep for the right side, then a prefix sweep evaluating every split plane
+            std::array<float, SAH_BINS> right_area{};
+            std::array<uint32_t, SAH_BINS> right_count{};
+            AABB accumulated;
+            uint32_t accumulated_count = 0;
+            for (uint32_t bin = SAH_BINS - 1; bin > 0; bin--) {
+                accumulated.Expand(bins[bin].bounds);
+                accumulated_count += bins[bin].count;
+                right_area[bin] = accumulated.GetSurfaceArea();
+                right_count[bin] = accumulated_count;
+            }
+            accumulated = AABB();
+            accumulated_count = 0;
+            for (uint32_t bin = 0; bin < SAH_BINS - 1; bin++) {
+                accumulated.Expand(bins[bin].bounds);
+                accumulated_count += bins[bin].count;
+                if (accumulated_count == 0 || right_count[bin + 1] == 0)
+                    continue;
+                float cost = accumulated_count * accumulated.GetSurfaceArea() + right_count[bin + 1] * right_area[bin + 1];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = bin;
+                }
+            }
+        }
+
+        auto median_split = [&]() {
+            int axis = 0;
+            glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+            if (extent.y > extent[axis]) axis = 1;
+            if (extent.z > extent[axis]) axis = 2;
+            uint32_t middle = begin + count / 2;
+            std::nth_element(mItems.begin() + begin, mItems.begin() + middle, mItems.begin() + end,
+                [&](uint32_t a, uint32_t b) { return mCentroids[a][axis] < mCentroids[b][axis]; });
+            return middle;
+        };
+
+        // Every centroid in one spot, SAH can't separate them
+        if (best_axis < 0)
+            return count > MAX_LEAF_ITEMS ? median_split() : begin;
+
+        float area = bounds.GetSurfaceArea();
+        float split_cost = TRAVERSAL_COST + (area > 0.0f ? best_cost / area : 0.0f);
+        if (split_cost >= static_cast<float>(count) && count <= MAX_LEAF_ITEMS)
+            return begin;
+
+        float low = centroid_bounds.min[best_axis];
+        float scale = SAH_BINS / (centroid_bounds.max[best_axis] - low);
+        auto middle = std::partition(mItems.begin() + begin, mItems.begin() + end, [&](uint32_t item) {
+            return std::min(SAH_BINS - 1, static_cast<uint32_t>((mCentroids[item][best_axis] - low) * scale)) <= best_bin;
+        });
+        uint32_t split = static_cast<uint32_t>(middle - mItems.begin());
+        return split == begin || split == end ? median_split() : split;
+    }
+
+    void BVH::stitch(DeferredSubtree& subtree) {
+        // The subtree's root replaces the placeholder, the rest is appended with its links moved along
+        uint32_t base = static_cast<uint32_t>(mNodes.size());
+        auto remap = [&](uint32_t local) {
+            if (local == INVALID)
+                return INVALID;
+            return local == 0 ? subtree.node : base + local - 1;
+        };
+
+        Node root = subtree.nodes[0];
+        root.parent = mNodes[subtree.node].parent;
+        root.left = remap(root.left);
+        root.right = remap(root.right);
+        mNodes[subtree.node] = root;
+        for (uint32_t i = 1; i < subtree.nodes.size(); i++) {
+            Node node = subtree.nodes[i];
+            node.parent = remap(node.parent);
+            node.left = remap(node.left);
+            node.right = remap(node.right);
+            mNodes.push_back(node);
+        }
+    }
+
+    void BVH::appendSubtree(uint32_t node, std::vector<uint32_t>& items) const {
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(node);
+        while (!stack.empty()) {
+            const Node& current = mNodes[stack.back()];
+            stack.pop_back();
+            if (current.IsLeaf()) {
+                for (uint32_t i = current.first; i < current.first + current.count; i++) {
+                    if (mItemBounds[mItems[i]].IsValid())
+                        items.push_back(mItems[i]);
+                }
+                continue;
+            }
+            stack.push_back(current.left);
+            stack.push_back(current.right);
+        }
+    }
+
+}
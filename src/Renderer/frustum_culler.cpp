@@ -0,0 +1,162 @@
+#include <Renderer/frustum_culler.h>
+
+#include <bit>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define OGLR_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define OGLR_CULL_SSE
+#endif
+
+namespace OGLR {
+
+    Frustum Frustum::FromMatrix(const glm::mat4& view_proj) {
+        // Gribb/Hartmann, glm is column major so row i is m[0][i], m[1][i], ...
+        auto row = [&](int i) { return glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]); };
+        Frustum frustum;
+        frustum.planes[0] = row(3) + row(0);
+        frustum.planes[1] = row(3) - row(0);
+        frustum.planes[2] = row(3) + row(1);
+        frustum.planes[3] = row(3) - row(1);
+        frustum.planes[4] = row(3) + row(2);
+        frustum.planes[5] = row(3) - row(2);
+        for (glm::vec4& plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    void CullingBounds::Resize(uint32_t count) {
+        mCount = count;
+        uint32_t padded = (count + 7) & ~7u;
+        for (std::vector<float>* array : { &mCenterX, &mCenterY, &mCenterZ, &mExtentX, &mExtentY, &mExtentZ, &mRadius })
+            array->resize(padded, 0.0f);
+    }
+
+    void CullingBounds::Set(uint32_t index, const AABB& box, const BoundingSphere& sphere) {
+        // Empty meshes get a negative size, which puts them outside of every plane
+        const float EMPTY = -1e30f;
+        glm::vec3 center = box.IsValid() ? box.GetCenter() : glm::vec3(0.0f);
+        glm::vec3 extents = box.IsValid() ? box.GetExtents() : glm::vec3(EMPTY);
+        mCenterX[index] = center.x;
+        mCenterY[index] = center.y;
+        mCenterZ[index] = center.z;
+        mExtentX[index] = extents.x;
+        mExtentY[index] = extents.y;
+        mExtentZ[index] = extents.z;
+        mRadius[index] = box.IsValid() ? sphere.radius : EMPTY;
+    }
+
+    // An object is outside when it's entirely behind one plane. Box and sphere share a center, so the
+    // smaller of the two projected radii is still conservative and tighter than either alone.
+    uint32_t FrustumCuller::CullScalar(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint32_t>& visible) {
+        visible.clear();
+        for (uint32_t i = 0; i < bounds.mCount; i++) {
+            bool inside = true;
+            for (const glm::vec4& plane : frustum.planes) {
+                float distance = plane.x * bounds.mCenterX[i] + plane.y * bounds.mCenterY[i] + plane.z * bounds.mCenterZ[i] + plane.w;
+                float radius = glm::abs(plane.x) * bounds.mExtentX[i] + glm::abs(plane.y) * bounds.mExtentY[i] + glm::abs(plane.z) * bounds.mExtentZ[i];
+                radius = glm::min(radius, bounds.mRadius[i]);
+                if (distance + radius < 0.0f) {
+                    inside = false;
+                    break;
+                }
+            }
+            if (inside)
+                visible.push_back(i);
+        }
+        mStats.tested += bounds.mCount;
+        mStats.visible += visible.size();
+        return static_cast<uint32_t>(visible.size());
+    }
+
+    uint32_t FrustumCuller::Cull(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint32_t>& visible) {
+#if defined(OGLR_CULL_AVX)
+        visible.clear();
+        uint32_t padded = (bounds.mCount + 7) & ~7u;
+        const __m256 zero = _mm256_setzero_ps();
+        for (uint32_t i = 0; i < padded; i += 8) {
+            __m256 center_x = _mm256_loadu_ps(&bounds.mCenterX[i]);
+            __m256 center_y = _mm256_loadu_ps(&bounds.mCenterY[i]);
+            __m256 center_z = _mm256_loadu_ps(&bounds.mCenterZ[i]);
+            __m256 extent_x = _mm256_loadu_ps(&bounds.mExtentX[i]);
+            __m256 extent_y = _mm256_loadu_ps(&bounds.mExtentY[i]);
+            __m256 extent_z = _mm256_loadu_ps(&bounds.mExtentZ[i]);
+            __m256 sphere_radius = _mm256_loadu_ps(&bounds.mRadius[i]);
+
+            __m256 outside = zero;
+            for (const glm::vec4& plane : frustum.planes) {
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(center_x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(center_y, _mm256_set1_ps(plane.y))),
+                    _mm256_add_ps(_mm256_mul_ps(center_z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+                __m256 radius = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(extent_x, _mm256_set1_ps(glm::abs(plane.x))), _mm256_mul_ps(extent_y, _mm256_set1_ps(glm::abs(plane.y)))),
+                    _mm256_mul_ps(extent_z, _mm256_set1_ps(glm::abs(plane.z))));
+                radius = _mm256_min_ps(radius, sphere_radius);
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+            }
+
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF;
+            while (mask) {
+                uint32_t index = i + std::countr_zero(mask);
+                if (index < bounds.mCount)
+                    visible.push_back(index);
+                mask &= mask - 1;
+            }
+        }
+        mStats.tested += bounds.mCount;
+        mStats.visible += visible.size();
+        return static_cast<uint32_t>(visible.size());
+#elif defined(OGLR_CULL_SSE)
+        visible.clear();
+        uint32_t padded = (bounds.mCount + 3) & ~3u;
+        const __m128 zero = _mm_setzero_ps();
+        for (uint32_t i = 0; i < padded; i += 4) {
+            __m128 center_x = _mm_loadu_ps(&bounds.mCenterX[i]);
+            __m128 center_y = _mm_loadu_ps(&bounds.mCenterY[i]);
+            __m128 center_z = _mm_loadu_ps(&bounds.mCenterZ[i]);
+            __m128 extent_x = _mm_loadu_ps(&bounds.mExtentX[i]);
+            __m128 extent_y = _mm_loadu_ps(&bounds.mExtentY[i]);
+            __m128 extent_z = _mm_loadu_ps(&bounds.mExtentZ[i]);
+            __m128 sphere_radius = _mm_loadu_ps(&bounds.mRadius[i]);
+
+            __m128 outside = zero;
+            for (const glm::vec4& plane : frustum.planes) {
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(plane.x)), _mm_mul_ps(center_y, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(center_z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                __m128 radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(extent_x, _mm_set1_ps(glm::abs(plane.x))), _mm_mul_ps(extent_y, _mm_set1_ps(glm::abs(plane.y)))),
+                    _mm_mul_ps(extent_z, _mm_set1_ps(glm::abs(plane.z))));
+                radius = _mm_min_ps(radius, sphere_radius);
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+            while (mask) {
+                uint32_t index = i + std::countr_zero(mask);
+                if (index < bounds.mCount)
+                    visible.push_back(index);
+                mask &= mask - 1;
+            }
+        }
+        mStats.tested += bounds.mCount;
+        mStats.visible += visible.size();
+        return static_cast<uint32_t>(visible.size());
+#else
+        return CullScalar(frustum, bounds, visible);
+#endif
+    }
+
+    const char* FrustumCuller::GetInstructionSet() {
+#if defined(OGLR_CULL_AVX)
+        return "AVX";
+#elif defined(OGLR_CULL_SSE)
+        return "SSE";
+#else
+        return "scalar";
+#endif
+    }
+
+}
@@ -0,0 +1,209 @@
+#include <Renderer/geometry_arena.h>
+#include <Renderer/staging_uploader.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+namespace OGLR {
+
+    RangeAllocator::RangeAllocator(uint32_t capacity)
+        :mCapacity(capacity) {
+        if (capacity > 0)
+            mFree.push_back({ 0, capacity });
+    }
+
+    uint32_t RangeAllocator::Allocate(uint32_t size, uint32_t alignment) {
+        if (size == 0)
+            return 0;
+        for (size_t i = 0; i < mFree.size(); i++) {
+            Range& range = mFree[i];
+            uint32_t padding = (alignment - range.offset % alignment) % alignment;
+            if (range.size < size + padding)
+                continue;
+            uint32_t offset = range.offset + padding;
+            uint32_t remaining = range.size - padding - size;
+            mUsed += size;
+            if (padding == 0) {
+                range.offset += size;
+                range.size = remaining;
+                if (range.size == 0)
+                    mFree.erase(mFree.begin() + i);
+            } else {
+                range.size = padding;
+                if (remaining > 0)
+                    mFree.insert(mFree.begin() + i + 1, { offset + size, remaining });
+            }
+            return offset;
+        }
+        return INVALID;
+    }
+
+    void RangeAllocator::Free(uint32_t offset, uint32_t size) {
+        if (size == 0)
+            return;
+        mUsed -= size;
+        insertFree(offset, size);
+    }
+
+    void RangeAllocator::Grow(uint32_t capacity) {
+        if (capacity <= mCapacity)
+            return;
+        insertFree(mCapacity, capacity - mCapacity);
+        mCapacity = capacity;
+    }
+
+    void RangeAllocator::insertFree(uint32_t offset, uint32_t size) {
+        auto next = std::lower_bound(mFree.begin(), mFree.end(), offset,
+            [](const Range& range, uint32_t value) { return range.offset < value; });
+        bool merges_prev = next != mFree.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+        bool merges_next = next != mFree.end() && offset + size == next->offset;
+
+        if (merges_prev && merges_next) {
+            std::prev(next)->size += size + next->size;
+            mFree.erase(next);
+        } else if (merges_prev) {
+            std::prev(next)->size += size;
+        } else if (merges_next) {
+            next->offset = offset;
+            next->size += size;
+        } else {
+            mFree.insert(next, { offset, size });
+        }
+    }
+
+    GeometryArena::GeometryArena(VertexFormat format, uint32_t vertex_capacity, uint32_t index_slot_capacity)
+        :mFormat(format), mStride(VertexQuantizer::GetStride(format)), mVertices(vertex_capacity), mIndices(index_slot_capacity) {
+        glCreateBuffers(1, &mVertexBufferID);
+        glNamedBufferStorage(mVertexBufferID, static_cast<GLsizeiptr>(vertex_capacity) * mStride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glCreateBuffers(1, &mIndexBufferID);
+        glNamedBufferStorage(mIndexBufferID, static_cast<GLsizeiptr>(index_slot_capacity) * sizeof(uint16_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        // The name only becomes a vertex array object once bound, the DSA calls below need the object
+        mVAO.Bind();
+        mVAO.UnBind();
+        uint32_t vao = mVAO.GetID();
+        uint32_t offset = 0;
+        uint32_t index = 0;
+        for (const auto& element : VertexQuantizer::GetLayout(format).GetElements()) {
+            glEnableVertexArrayAttrib(vao, index);
+            glVertexArrayAttribFormat(vao, index, element.count, element.glType, element.normalized ? GL_TRUE : GL_FALSE, offset);
+            glVertexArrayAttribBinding(vao, index, 0);
+            offset += element.size;
+            index++;
+        }
+        attachBuffers();
+
+        mCurrent = this;
+    }
+
+    GeometryArena::~GeometryArena() {
+        glDeleteBuffers(1, &mVertexBufferID);
+        glDeleteBuffers(1, &mIndexBufferID);
+        if (mCurrent == this)
+            mCurrent = nullptr;
+    }
+
+    uint32_t StagedGeometry::GetVertexBytes() const {
+        return static_cast<uint32_t>(quantized.empty() ? vertices.size_bytes() : quantized.size() * sizeof(QuantizedVertex));
+    }
+
+    GeometryRange GeometryArena::Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const MeshLOD> lods) {
+        StagedGeometry staged;
+        Prepare(mFormat, vertices, indices, lods, staged);
+        GeometryRange range = Reserve(staged);
+
+        const void* vertex_data = staged.quantized.empty() ? static_cast<const void*>(vertices.data()) : staged.quantized.data();
+        glNamedBufferSubData(mVertexBufferID, static_cast<GLintptr>(range.vertexOffset) * mStride, staged.GetVertexBytes(), vertex_data);
+        glNamedBufferSubData(mIndexBufferID, static_cast<GLintptr>(range.indexSlotOffset) * sizeof(uint16_t),
+                             staged.packed.slots.size() * sizeof(uint16_t), staged.packed.slots.data());
+        return range;
+    }
+
+    void GeometryArena::Prepare(VertexFormat format, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                std::span<const MeshLOD> lods, StagedGeometry& staged) {
+        staged.vertices = vertices;
+        staged.uploadedBytes = 0;
+        staged.quantized.clear();
+        staged.dequantization = {};
+        if (format == VertexFormat::QUANTIZED)
+            staged.dequantization = VertexQuantizer::Quantize(vertices, staged.quantized);
+        IndexPacker::Pack(indices, lods, staged.packed);
+    }
+
+    GeometryRange GeometryArena::Reserve(const StagedGeometry& staged) {
+        GeometryRange range;
+        range.vertexCount = static_cast<uint32_t>(staged.vertices.size());
+        range.indexSlotCount = static_cast<uint32_t>(staged.packed.slots.size());
+
+        range.vertexOffset = mVertices.Allocate(range.vertexCount);
+        if (range.vertexOffset == RangeAllocator::INVALID) {
+            uint32_t capacity = std::max(mVertices.GetCapacity() * 2, mVertices.GetCapacity() + range.vertexCount);
+            mVertexBufferID = growBuffer(mVertexBufferID, mVertices.GetCapacity() * mStride, capacity * mStride);
+            mVertices.Grow(capacity);
+            mStats.vertexGrows++;
+            range.vertexOffset = mVertices.Allocate(range.vertexCount);
+            attachBuffers();
+        }
+        // Even, so the 32 bit runs inside stay aligned to their own size
+        range.indexSlotOffset = mIndices.Allocate(range.indexSlotCount, 2);
+        if (range.indexSlotOffset == RangeAllocator::INVALID) {
+            uint32_t capacity = std::max(mIndices.GetCapacity() * 2, mIndices.GetCapacity() + range.indexSlotCount + 1);
+            mIndexBufferID = growBuffer(mIndexBufferID, mIndices.GetCapacity() * sizeof(uint16_t), capacity * sizeof(uint16_t));
+            mIndices.Grow(capacity);
+            mStats.indexGrows++;
+            range.indexSlotOffset = mIndices.Allocate(range.indexSlotCount, 2);
+            attachBuffers();
+        }
+
+        range.dequantization = staged.dequantization;
+        range.chunks = staged.packed.chunks;
+        range.lodChunks = staged.packed.lodChunks;
+        for (IndexChunk& chunk : range.chunks) {
+            chunk.firstIndex += range.indexSlotOffset * sizeof(uint16_t) / GetIndexSize(chunk.type);
+            chunk.baseVertex += range.vertexOffset;
+        }
+        return range;
+    }
+
+    bool GeometryArena::Upload(StagedGeometry& staged, const GeometryRange& range) {
+        uint32_t vertex_bytes = staged.GetVertexBytes();
+        if (staged.uploadedBytes < vertex_bytes) {
+            const uint8_t* vertex_data = staged.quantized.empty() ? reinterpret_cast<const uint8_t*>(staged.vertices.data())
+                                                                  : reinterpret_cast<const uint8_t*>(staged.quantized.data());
+            staged.uploadedBytes += StagingUploader::CopyToBuffer(mVertexBufferID, range.vertexOffset * mStride + staged.uploadedBytes,
+                                                                  vertex_data + staged.uploadedBytes, vertex_bytes - staged.uploadedBytes);
+            if (staged.uploadedBytes < vertex_bytes)
+                return false;
+        }
+
+        uint32_t index_offset = staged.uploadedBytes - vertex_bytes;
+        uint32_t index_bytes = static_cast<uint32_t>(staged.packed.slots.size() * sizeof(uint16_t));
+        if (index_offset < index_bytes) {
+            const uint8_t* index_data = reinterpret_cast<const uint8_t*>(staged.packed.slots.data());
+            staged.uploadedBytes += StagingUploader::CopyToBuffer(mIndexBufferID, range.indexSlotOffset * sizeof(uint16_t) + index_offset,
+                                                                  index_data + index_offset, index_bytes - index_offset);
+        }
+        return staged.uploadedBytes == staged.GetSize();
+    }
+
+    void GeometryArena::Free(const GeometryRange& range) {
+        mVertices.Free(range.vertexOffset, range.vertexCount);
+        mIndices.Free(range.indexSlotOffset, range.indexSlotCount);
+    }
+
+    uint32_t GeometryArena::growBuffer(uint32_t buffer, uint32_t old_size, uint32_t new_size) {
+        uint32_t grown = 0;
+        glCreateBuffers(1, &grown);
+        glNamedBufferStorage(grown, new_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glCopyNamedBufferSubData(buffer, grown, 0, 0, old_size);
+        glDeleteBuffers(1, &buffer);
+        return grown;
+    }
+
+    void GeometryArena::attachBuffers() {
+        glVertexArrayVertexBuffer(mVAO.GetID(), 0, mVertexBufferID, 0, mStride);
+        glVertexArrayElementBuffer(mVAO.GetID(), mIndexBufferID);
+    }
+
+}
@@ -0,0 +1,100 @@
+#include <Renderer/gl_state.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+namespace OGLR {
+
+    void GLState::UseProgram(uint32_t program) {
+        if (update(mState.program, program))
+            glUseProgram(program);
+    }
+
+    void GLState::BindVertexArray(uint32_t vertex_array) {
+        if (update(mState.vertexArray, vertex_array))
+            glBindVertexArray(vertex_array);
+    }
+
+    void GLState::BindTexture(uint32_t unit, uint32_t texture) {
+        if (unit >= MAX_TEXTURE_UNITS) {
+            mStats.issued++;
+            glBindTextureUnit(unit, texture);
+            return;
+        }
+        if (update(mState.textures[unit], texture))
+            glBindTextureUnit(unit, texture);
+    }
+
+    void GLState::BindFramebuffer(uint32_t target, uint32_t framebuffer) {
+        if (target == GL_FRAMEBUFFER) {
+            if (mState.drawFramebuffer == framebuffer && mState.readFramebuffer == framebuffer) {
+                mStats.elided++;
+                return;
+            }
+            mState.drawFramebuffer = framebuffer;
+            mState.readFramebuffer = framebuffer;
+            mStats.issued++;
+            glBindFramebuffer(target, framebuffer);
+            return;
+        }
+        uint32_t& cached = target == GL_READ_FRAMEBUFFER ? mState.readFramebuffer : mState.drawFramebuffer;
+        if (update(cached, framebuffer))
+            glBindFramebuffer(target, framebuffer);
+    }
+
+    void GLState::Viewport(int32_t x, int32_t y, int32_t width, int32_t height) {
+        if (update(mState.viewport, glm::ivec4(x, y, width, height)))
+            glViewport(x, y, width, height);
+    }
+
+    void GLState::ClearColor(const glm::vec4& color) {
+        if (update(mState.clearColor, color))
+            glClearColor(color.x, color.y, color.z, color.w);
+    }
+
+    void GLState::SetEnabled(uint32_t capability, bool enabled) {
+        auto it = std::find_if(mState.capabilities.begin(), mState.capabilities.end(),
+            [capability](const std::pair<uint32_t, bool>& entry) { return entry.first == capability; });
+        if (it == mState.capabilities.end()) {
+            mState.capabilities.push_back({ capability, !enabled });
+            it = mState.capabilities.end() - 1;
+        }
+        if (!update(it->second, enabled))
+            return;
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    void GLState::PolygonMode(uint32_t mode) {
+        if (update(mState.polygonMode, mode))
+            glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+
+    void GLState::PointSize(float size) {
+        if (update(mState.pointSize, size))
+            glPointSize(size);
+    }
+
+    void GLState::ForgetVertexArray(uint32_t vertex_array) {
+        if (mState.vertexArray == vertex_array)
+            mState.vertexArray = 0;
+    }
+
+    void GLState::ForgetTexture(uint32_t texture) {
+        for (uint32_t& bound : mState.textures) {
+            if (bound == texture)
+                bound = 0;
+        }
+    }
+
+    void GLState::ForgetFramebuffer(uint32_t framebuffer) {
+        if (mState.drawFramebuffer == framebuffer)
+            mState.drawFramebuffer = 0;
+        if (mState.readFramebuffer == framebuffer)
+            mState.readFramebuffer = 0;
+    }
+
+}
@@ -0,0 +1,43 @@
+#include <Renderer/gpu_timer.h>
+
+#include <glad/glad.h>
+
+namespace OGLR {
+
+    GpuTimer::GpuTimer() {
+        glGenQueries(LATENCY, mQueries);
+    }
+
+    GpuTimer::~GpuTimer() {
+        glDeleteQueries(LATENCY, mQueries);
+    }
+
+    void GpuTimer::Begin() {
+        if (mPending[mNext])
+            collect(mNext);
+        glBeginQuery(GL_TIME_ELAPSED, mQueries[mNext]);
+    }
+
+    void GpuTimer::End() {
+        glEndQuery(GL_TIME_ELAPSED);
+        mPending[mNext] = true;
+        mNext = (mNext + 1) % LATENCY;
+    }
+
+    void GpuTimer::Flush() {
+        // Oldest first, mNext is the slot that was used longest ago
+        for (uint32_t i = 0; i < LATENCY; i++) {
+            uint32_t slot = (mNext + i) % LATENCY;
+            if (mPending[slot])
+                collect(slot);
+        }
+    }
+
+    void GpuTimer::collect(uint32_t slot) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(mQueries[slot], GL_QUERY_RESULT, &nanoseconds);
+        mResults.push_back(nanoseconds / 1e6);
+        mPending[slot] = false;
+    }
+
+}
@@ -3,10 +3,32 @@
 
 namespace OGLR {
 
-    IndexBuffer::IndexBuffer(const std::vector<uint32_t>& buffer_data) {
+    uint32_t GetGLIndexType(IndexType type) {
+        return type == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    IndexBuffer::IndexBuffer(const std::vector<uint16_t>& buffer_data)
+    :IndexBuffer(buffer_data.data(), static_cast<uint32_t>(buffer_data.size())) {
+    }
+
+    IndexBuffer::IndexBuffer(const std::vector<uint32_t>& buffer_data)
+    :IndexBuffer(buffer_data.data(), static_cast<uint32_t>(buffer_data.size())) {
+    }
+
+    IndexBuffer::IndexBuffer(const uint16_t* data, uint32_t count) {
+        create(data, count, IndexType::UINT16);
+    }
+
+    IndexBuffer::IndexBuffer(const uint32_t* data, uint32_t count) {
+        create(data, count, IndexType::UINT32);
+    }
+
+    void IndexBuffer::create(const void* data, uint32_t count, IndexType type) {
+        mType = type;
+        mCount = count;
         glGenBuffers(1, &mRendererID);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mRendererID);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t)*buffer_data.size(), buffer_data.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, GetIndexSize(type)*count, data, GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
@@ -0,0 +1,72 @@
+#include <Renderer/index_packer.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace OGLR {
+
+    namespace {
+
+        // Cuts indices into runs of whole triangles whose vertex range fits 16 bits, false if one triangle alone doesn't
+        bool splitChunks(std::span<const uint32_t> indices, std::vector<IndexChunk>& chunks) {
+            chunks.clear();
+            uint32_t chunk_min = UINT32_MAX, chunk_max = 0;
+            uint32_t chunk_begin = 0;
+            for (uint32_t i = 0; i + 2 < indices.size(); i += 3) {
+                uint32_t triangle_min = std::min({ indices[i], indices[i + 1], indices[i + 2] });
+                uint32_t triangle_max = std::max({ indices[i], indices[i + 1], indices[i + 2] });
+                if (triangle_max - triangle_min > IndexPacker::MAX_CHUNK_VERTEX_SPAN)
+                    return false;
+
+                uint32_t new_min = std::min(chunk_min, triangle_min);
+                uint32_t new_max = std::max(chunk_max, triangle_max);
+                if (new_max - new_min > IndexPacker::MAX_CHUNK_VERTEX_SPAN) {
+                    chunks.push_back({ IndexType::UINT16, chunk_begin, i - chunk_begin, chunk_min });
+                    chunk_begin = i;
+                    new_min = triangle_min;
+                    new_max = triangle_max;
+                }
+                chunk_min = new_min;
+                chunk_max = new_max;
+            }
+            if (chunk_begin < indices.size())
+                chunks.push_back({ IndexType::UINT16, chunk_begin, static_cast<uint32_t>(indices.size()) - chunk_begin, chunk_min });
+            return true;
+        }
+
+    }
+
+    void IndexPacker::Pack(std::span<const uint32_t> indices, std::span<const MeshLOD> lods, PackedIndices& packed) {
+        packed.slots.clear();
+        packed.chunks.clear();
+        packed.lodChunks.assign(1, 0);
+
+        std::vector<IndexChunk> split;
+        for (const MeshLOD& lod : lods) {
+            std::span<const uint32_t> lod_indices = indices.subspan(lod.indexOffset, lod.indexCount);
+            bool fits = splitChunks(lod_indices, split);
+            if (fits && split.size() > 1 && lod_indices.size() / split.size() < MIN_INDICES_PER_CHUNK)
+                fits = false;
+
+            if (fits) {
+                // Chunk offsets still point into lod_indices, they move to their slots here
+                for (IndexChunk chunk : split) {
+                    uint32_t first_slot = static_cast<uint32_t>(packed.slots.size());
+                    for (uint32_t index : lod_indices.subspan(chunk.firstIndex, chunk.indexCount))
+                        packed.slots.push_back(static_cast<uint16_t>(index - chunk.baseVertex));
+                    chunk.firstIndex = first_slot;
+                    packed.chunks.push_back(chunk);
+                }
+            } else if (!lod_indices.empty()) {
+                if (packed.slots.size() % 2)
+                    packed.slots.push_back(0);
+                uint32_t first_slot = static_cast<uint32_t>(packed.slots.size());
+                packed.slots.resize(first_slot + lod_indices.size() * 2);
+                std::memcpy(packed.slots.data() + first_slot, lod_indices.data(), lod_indices.size_bytes());
+                packed.chunks.push_back({ IndexType::UINT32, first_slot / 2, static_cast<uint32_t>(lod_indices.size()), 0 });
+            }
+            packed.lodChunks.push_back(static_cast<uint32_t>(packed.chunks.size()));
+        }
+    }
+
+}
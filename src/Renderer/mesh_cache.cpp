@@ -0,0 +1,281 @@
+#include <Renderer/mesh_cache.h>
+#include <hash.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+namespace OGLR {
+
+    namespace {
+
+        // Everything below is written verbatim, so only fixed size types and explicit padding
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;
+            uint32_t importFlags;
+            uint32_t meshCount;
+            uint32_t materialCount;
+            uint32_t textureCount;
+            uint32_t lodCount;
+            uint32_t padding;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint64_t meshTableOffset;
+            uint64_t lodTableOffset;
+            uint64_t textureTableOffset;
+            uint64_t stringTableOffset;
+            uint64_t vertexBlobOffset;
+            uint64_t indexBlobOffset;
+            uint64_t fileSize;
+        };
+
+        struct MeshRecord {
+            uint32_t vertexOffset, vertexCount;
+            uint32_t indexOffset, indexCount;
+            uint32_t materialIndex;
+            uint32_t lodOffset, lodCount;
+            uint32_t padding;
+        };
+
+        struct LODRecord {
+            uint32_t indexOffset, indexCount;
+            float error;
+            uint32_t padding;
+        };
+
+        struct TextureRecord {
+            uint32_t materialIndex;
+            uint32_t typeOffset;
+            uint32_t pathOffset;
+            uint32_t padding;
+        };
+
+        // The vertex blob is a straight copy of Vertex, bump VERSION whenever it changes
+        static_assert(sizeof(Vertex) == 32, "Vertex layout changed, bump MeshCache::VERSION");
+
+        const uint64_t BLOB_ALIGNMENT = 16;
+
+        uint64_t alignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        bool inFile(uint64_t offset, uint64_t size, uint64_t file_size) {
+            return offset <= file_size && size <= file_size - offset;
+        }
+
+        std::string_view trim(std::string_view text) {
+            size_t start = text.find_first_not_of(" \t\r");
+            if (start == std::string_view::npos)
+                return {};
+            return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+        }
+
+        // The string starting at offset has to end inside the table
+        bool inStringTable(const char* strings, uint64_t table_size, uint32_t offset) {
+            return offset < table_size && std::memchr(strings + offset, '\0', table_size - offset) != nullptr;
+        }
+
+    }
+
+    uint64_t MeshCache::HashSource(const std::string& path) {
+        MappedFile file(path);
+        if (!file.IsOpen())
+            return 0;
+        uint64_t hash = HashBytes(file.GetData(), file.GetSize());
+
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (extension != ".obj")
+            return hash;
+
+        // Materials come from the libraries the .obj names, like Assimp the rest of the line is one file name
+        std::string_view text(reinterpret_cast<const char*>(file.GetData()), file.GetSize());
+        std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        for (size_t line_start = 0; line_start < text.size();) {
+            size_t line_end = std::min(text.find('\n', line_start), text.size());
+            std::string_view line = trim(text.substr(line_start, line_end - line_start));
+            line_start = line_end + 1;
+            if (!line.starts_with("mtllib") || line.size() < 7 || (line[6] != ' ' && line[6] != '\t'))
+                continue;
+
+            std::string library = (directory / std::string(trim(line.substr(6)))).generic_string();
+            hash = HashString(library, hash);
+            std::error_code error;
+            uintmax_t size = std::filesystem::file_size(library, error);
+            if (error)
+                size = UINTMAX_MAX;
+            int64_t ticks = error ? 0 : std::filesystem::last_write_time(library, error).time_since_epoch().count();
+            hash = HashBytes(&size, sizeof(size), hash);
+            hash = HashBytes(&ticks, sizeof(ticks), hash);
+        }
+        return hash;
+    }
+
+    bool MeshCache::Load(const std::string& cache_path, uint64_t source_hash, uint32_t import_flags, ModelData& data) {
+        MappedFile file(cache_path);
+        if (!file.IsOpen() || file.GetSize() < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, file.GetData(), sizeof(FileHeader));
+        if (header.magic != MAGIC || header.version != VERSION)
+            return false;
+        if (header.sourceHash != source_hash || header.importFlags != import_flags)
+            return false;
+
+        uint64_t size = file.GetSize();
+        if (header.fileSize != size ||
+            !inFile(header.meshTableOffset, uint64_t(header.meshCount) * sizeof(MeshRecord), size) ||
+            !inFile(header.lodTableOffset, uint64_t(header.lodCount) * sizeof(LODRecord), size) ||
+            !inFile(header.textureTableOffset, uint64_t(header.textureCount) * sizeof(TextureRecord), size) ||
+            !inFile(header.vertexBlobOffset, uint64_t(header.vertexCount) * sizeof(Vertex), size) ||
+            !inFile(header.indexBlobOffset, uint64_t(header.indexCount) * sizeof(uint32_t), size) ||
+            header.stringTableOffset > header.vertexBlobOffset) {
+            std::cerr << "ERROR::MESH_CACHE:: corrupt cache file " << cache_path << '\n';
+            return false;
+        }
+
+        const uint8_t* base = file.GetData();
+        const char* strings = reinterpret_cast<const char*>(base + header.stringTableOffset);
+        uint64_t string_table_size = header.vertexBlobOffset - header.stringTableOffset;
+
+        data.lods.resize(header.lodCount);
+        const LODRecord* lod_records = reinterpret_cast<const LODRecord*>(base + header.lodTableOffset);
+        for (uint32_t i = 0; i < header.lodCount; i++)
+            data.lods[i] = { lod_records[i].indexOffset, lod_records[i].indexCount, lod_records[i].error };
+
+        data.meshes.resize(header.meshCount);
+        const MeshRecord* mesh_records = reinterpret_cast<const MeshRecord*>(base + header.meshTableOffset);
+        for (uint32_t i = 0; i < header.meshCount; i++) {
+            const MeshRecord& record = mesh_records[i];
+            if (uint64_t(record.vertexOffset) + record.vertexCount > header.vertexCount ||
+                uint64_t(record.indexOffset) + record.indexCount > header.indexCount ||
+                record.materialIndex >= header.materialCount ||
+                record.lodCount == 0 || uint64_t(record.lodOffset) + record.lodCount > header.lodCount) {
+                std::cerr << "ERROR::MESH_CACHE:: corrupt mesh table in " << cache_path << '\n';
+                return false;
+            }
+            for (uint32_t lod = record.lodOffset; lod < record.lodOffset + record.lodCount; lod++) {
+                if (uint64_t(data.lods[lod].indexOffset) + data.lods[lod].indexCount > record.indexCount) {
+                    std::cerr << "ERROR::MESH_CACHE:: corrupt LOD table in " << cache_path << '\n';
+                    return false;
+                }
+            }
+            data.meshes[i] = { record.vertexOffset, record.vertexCount, record.indexOffset, record.indexCount, record.materialIndex,
+                               record.lodOffset, record.lodCount };
+        }
+
+        data.materials.clear();
+        data.materials.resize(header.materialCount);
+        const TextureRecord* texture_records = reinterpret_cast<const TextureRecord*>(base + header.textureTableOffset);
+        for (uint32_t i = 0; i < header.textureCount; i++) {
+            const TextureRecord& record = texture_records[i];
+            if (record.materialIndex >= header.materialCount ||
+                !inStringTable(strings, string_table_size, record.typeOffset) ||
+                !inStringTable(strings, string_table_size, record.pathOffset)) {
+                std::cerr << "ERROR::MESH_CACHE:: corrupt texture table in " << cache_path << '\n';
+                return false;
+            }
+            data.materials[record.materialIndex].textures.push_back({ strings + record.typeOffset, strings + record.pathOffset });
+        }
+
+        data.vertices = { reinterpret_cast<const Vertex*>(base + header.vertexBlobOffset), header.vertexCount };
+        data.indices = { reinterpret_cast<const uint32_t*>(base + header.indexBlobOffset), header.indexCount };
+        data.importedVertices.clear();
+        data.importedIndices.clear();
+        data.mapping = std::move(file);
+        return true;
+    }
+
+    bool MeshCache::Write(const std::string& cache_path, uint64_t source_hash, uint32_t import_flags, const ModelData& data) {
+        std::vector<TextureRecord> texture_records;
+        std::string strings;
+        for (uint32_t i = 0; i < data.materials.size(); i++) {
+            for (const MaterialTextureRef& texture : data.materials[i].textures) {
+                TextureRecord record{};
+                record.materialIndex = i;
+                record.typeOffset = static_cast<uint32_t>(strings.size());
+                strings.append(texture.type).push_back('\0');
+                record.pathOffset = static_cast<uint32_t>(strings.size());
+                strings.append(texture.path).push_back('\0');
+                texture_records.push_back(record);
+            }
+        }
+
+        std::vector<MeshRecord> mesh_records;
+        mesh_records.reserve(data.meshes.size());
+        for (const MeshData& mesh : data.meshes)
+            mesh_records.push_back({ mesh.vertexOffset, mesh.vertexCount, mesh.indexOffset, mesh.indexCount, mesh.materialIndex,
+                                     mesh.lodOffset, mesh.lodCount, 0 });
+
+        std::vector<LODRecord> lod_records;
+        lod_records.reserve(data.lods.size());
+        for (const MeshLOD& lod : data.lods)
+            lod_records.push_back({ lod.indexOffset, lod.indexCount, lod.error, 0 });
+
+        FileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.sourceHash = source_hash;
+        header.importFlags = import_flags;
+        header.meshCount = static_cast<uint32_t>(mesh_records.size());
+        header.materialCount = static_cast<uint32_t>(data.materials.size());
+        header.textureCount = static_cast<uint32_t>(texture_records.size());
+        header.lodCount = static_cast<uint32_t>(lod_records.size());
+        header.vertexCount = static_cast<uint32_t>(data.vertices.size());
+        header.indexCount = static_cast<uint32_t>(data.indices.size());
+        header.meshTableOffset = alignUp(sizeof(FileHeader), BLOB_ALIGNMENT);
+        header.lodTableOffset = alignUp(header.meshTableOffset + mesh_records.size() * sizeof(MeshRecord), BLOB_ALIGNMENT);
+        header.textureTableOffset = alignUp(header.lodTableOffset + lod_records.size() * sizeof(LODRecord), BLOB_ALIGNMENT);
+        header.stringTableOffset = alignUp(header.textureTableOffset + texture_records.size() * sizeof(TextureRecord), BLOB_ALIGNMENT);
+        header.vertexBlobOffset = alignUp(header.stringTableOffset + strings.size(), BLOB_ALIGNMENT);
+        header.indexBlobOffset = alignUp(header.vertexBlobOffset + data.vertices.size_bytes(), BLOB_ALIGNMENT);
+        header.fileSize = header.indexBlobOffset + data.indices.size_bytes();
+
+        // Write next to the destination and rename, so a crash never leaves a half written cache behind
+        std::string temp_path = cache_path + ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::cerr << "ERROR::MESH_CACHE:: couldn't open " << temp_path << " for writing\n";
+                return false;
+            }
+
+            auto write_at = [&out](uint64_t offset, const void* bytes, size_t size) {
+                static const char zeros[BLOB_ALIGNMENT] = {};
+                uint64_t position = static_cast<uint64_t>(out.tellp());
+                out.write(zeros, static_cast<std::streamsize>(offset - position));
+                out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+            };
+            write_at(0, &header, sizeof(FileHeader));
+            write_at(header.meshTableOffset, mesh_records.data(), mesh_records.size() * sizeof(MeshRecord));
+            write_at(header.lodTableOffset, lod_records.data(), lod_records.size() * sizeof(LODRecord));
+            write_at(header.textureTableOffset, texture_records.data(), texture_records.size() * sizeof(TextureRecord));
+            write_at(header.stringTableOffset, strings.data(), strings.size());
+            write_at(header.vertexBlobOffset, data.vertices.data(), data.vertices.size_bytes());
+            write_at(header.indexBlobOffset, data.indices.data(), data.indices.size_bytes());
+            if (!out) {
+                std::cerr << "ERROR::MESH_CACHE:: failed writing " << temp_path << '\n';
+                out.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        std::remove(cache_path.c_str());
+        if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+            std::cerr << "ERROR::MESH_CACHE:: couldn't move " << temp_path << " to " << cache_path << '\n';
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+}
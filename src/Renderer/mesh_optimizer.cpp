@@ -0,0 +1,249 @@
+#include <Renderer/mesh_optimizer.h>
+#include <hash.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace OGLR {
+
+    namespace {
+
+        struct VertexHasher {
+            size_t operator()(const Vertex& vertex) const { return static_cast<size_t>(HashBytes(&vertex, sizeof(Vertex))); }
+        };
+
+        struct VertexEqual {
+            bool operator()(const Vertex& a, const Vertex& b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+        };
+
+        // FIFO like most hardware, a hit doesn't move the vertex
+        class CacheSimulator {
+        public:
+            CacheSimulator(uint32_t vertex_count, uint32_t cache_size)
+                :mInsertedAt(vertex_count, 0), mCacheSize(cache_size) {
+            }
+
+            // Everything inserted before this counts as evicted
+            void Flush() { mFlushedAt = mTime; }
+
+            bool Access(uint32_t vertex) {
+                uint32_t inserted = mInsertedAt[vertex];
+                if (inserted > mFlushedAt && mTime - inserted < mCacheSize)
+                    return true;
+                mInsertedAt[vertex] = ++mTime;
+                return false;
+            }
+        private:
+            std::vector<uint32_t> mInsertedAt;
+            uint32_t mCacheSize;
+            uint32_t mTime = 0;
+            uint32_t mFlushedAt = 0;
+        };
+
+    }
+
+    void MeshOptimizer::WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        std::unordered_map<Vertex, uint32_t, VertexHasher, VertexEqual> unique;
+        unique.reserve(vertices.size());
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for (uint32_t i = 0; i < vertices.size(); i++) {
+            auto [it, inserted] = unique.try_emplace(vertices[i], static_cast<uint32_t>(welded.size()));
+            if (inserted)
+                welded.push_back(vertices[i]);
+            remap[i] = it->second;
+        }
+        for (uint32_t& index : indices)
+            index = remap[index];
+        vertices = std::move(welded);
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count, std::vector<uint32_t>* clusters) {
+        uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        if (clusters)
+            clusters->clear();
+        if (triangle_count == 0)
+            return;
+
+        // Triangles around each vertex, packed
+        std::vector<uint32_t> live(vertex_count, 0);
+        for (uint32_t i = 0; i < triangle_count * 3; i++)
+            live[indices[i]]++;
+        std::vector<uint32_t> first(vertex_count + 1, 0);
+        for (uint32_t v = 0; v < vertex_count; v++)
+            first[v + 1] = first[v] + live[v];
+        std::vector<uint32_t> adjacency(first[vertex_count]);
+        std::vector<uint32_t> filled(first.begin(), first.end() - 1);
+        for (uint32_t i = 0; i < triangle_count * 3; i++)
+            adjacency[filled[indices[i]]++] = i / 3;
+
+        std::vector<uint32_t> cache_time(vertex_count, 0);
+        std::vector<uint8_t> emitted(triangle_count, 0);
+        std::vector<uint32_t> dead_end;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> result;
+        result.reserve(triangle_count * 3);
+        uint32_t time = CACHE_SIZE + 1;
+        uint32_t cursor = 0;
+
+        auto skip_dead_end = [&]() -> int64_t {
+            while (!dead_end.empty()) {
+                uint32_t vertex = dead_end.back();
+                dead_end.pop_back();
+                if (live[vertex] > 0)
+                    return vertex;
+            }
+            while (cursor < vertex_count) {
+                if (live[cursor] > 0)
+                    return cursor;
+                cursor++;
+            }
+            return -1;
+        };
+
+        int64_t fan = skip_dead_end();
+        while (fan >= 0) {
+            candidates.clear();
+            for (uint32_t a = first[fan]; a < first[fan + 1]; a++) {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                    continue;
+                emitted[triangle] = 1;
+                for (uint32_t i = 0; i < 3; i++) {
+                    uint32_t vertex = indices[triangle * 3 + i];
+                    result.push_back(vertex);
+                    dead_end.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+                    if (time - cache_time[vertex] > CACHE_SIZE)
+                        cache_time[vertex] = time++;
+                }
+            }
+
+            // Prefers the candidate that entered the cache earliest but will still be there after its own fan
+            int64_t next = -1;
+            int64_t best_priority = -1;
+            for (uint32_t vertex : candidates) {
+                if (live[vertex] == 0)
+                    continue;
+                int64_t priority = 0;
+                if (time - cache_time[vertex] + 2 * live[vertex] <= CACHE_SIZE)
+                    priority = time - cache_time[vertex];
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    next = vertex;
+                }
+            }
+            if (next < 0) {
+                next = skip_dead_end();
+                if (clusters && next >= 0)
+                    clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+            }
+            fan = next;
+        }
+
+        if (clusters)
+            clusters->insert(clusters->begin(), 0u);
+        indices = std::move(result);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, std::span<const Vertex> vertices, std::span<const uint32_t> clusters) {
+        uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        if (triangle_count == 0 || clusters.size() < 2)
+            return;
+
+        // Each merged cluster starts with a cold cache once moved, grow it until that stops hurting
+        float acmr_limit = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size())).acmr * OVERDRAW_ACMR_THRESHOLD;
+        CacheSimulator cache(static_cast<uint32_t>(vertices.size()), CACHE_SIZE);
+        std::vector<uint32_t> merged;
+        uint32_t misses = 0;
+        for (uint32_t cluster = 0; cluster < clusters.size(); cluster++) {
+            uint32_t begin = clusters[cluster];
+            uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count;
+            if (merged.empty() || misses <= acmr_limit * (begin - merged.back())) {
+                merged.push_back(begin);
+                cache.Flush();
+                misses = 0;
+            }
+            for (uint32_t i = begin * 3; i < end * 3; i++)
+                misses += !cache.Access(indices[i]);
+        }
+
+        glm::vec3 mesh_center(0.0f);
+        for (uint32_t index : indices)
+            mesh_center += vertices[index].position;
+        mesh_center /= static_cast<float>(indices.size());
+
+        std::vector<float> sort_keys(merged.size());
+        for (uint32_t cluster = 0; cluster < merged.size(); cluster++) {
+            uint32_t end = cluster + 1 < merged.size() ? merged[cluster + 1] : triangle_count;
+            glm::vec3 center(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (uint32_t triangle = merged[cluster]; triangle < end; triangle++) {
+                const glm::vec3& a = vertices[indices[triangle * 3]].position;
+                const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+                const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+                glm::vec3 cross = glm::cross(b - a, c - a);
+                float triangle_area = glm::length(cross);
+                center += (a + b + c) * (triangle_area / 3.0f);
+                normal += cross;
+                area += triangle_area;
+            }
+            float normal_length = glm::length(normal);
+            if (area == 0.0f || normal_length == 0.0f)
+                continue;
+            sort_keys[cluster] = glm::dot(center / area - mesh_center, normal / normal_length);
+        }
+
+        std::vector<uint32_t> order(merged.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&sort_keys](uint32_t a, uint32_t b) { return sort_keys[a] > sort_keys[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (uint32_t cluster : order) {
+            uint32_t end = cluster + 1 < merged.size() ? merged[cluster + 1] : triangle_count;
+            result.insert(result.end(), indices.begin() + merged[cluster] * 3, indices.begin() + end * 3);
+        }
+        indices = std::move(result);
+    }
+
+    void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        const uint32_t UNUSED = UINT32_MAX;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (uint32_t& index : indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<uint32_t>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices = std::move(ordered);
+    }
+
+    VertexCacheStats MeshOptimizer::AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertex_count, uint32_t cache_size) {
+        VertexCacheStats stats;
+        if (indices.empty())
+            return stats;
+
+        CacheSimulator cache(vertex_count, cache_size);
+        std::vector<uint8_t> referenced(vertex_count, 0);
+        uint32_t unique = 0;
+        for (uint32_t index : indices) {
+            stats.transformed += !cache.Access(index);
+            unique += !referenced[index];
+            referenced[index] = 1;
+        }
+        stats.acmr = static_cast<float>(stats.transformed) / (indices.size() / 3);
+        stats.atvr = static_cast<float>(stats.transformed) / unique;
+        return stats;
+    }
+
+}
@@ -0,0 +1,363 @@
+#include <Renderer/mesh_simplifier.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+namespace OGLR {
+
+    namespace {
+
+        // Sum of squared distances to a set of planes, evaluated as p^T Q p on homogeneous positions
+        struct Quadric {
+            double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+            double b2 = 0.0, bc = 0.0, bd = 0.0;
+            double c2 = 0.0, cd = 0.0;
+            double d2 = 0.0;
+
+            static Quadric FromPlane(const glm::vec3& normal, float distance) {
+                double a = normal.x, b = normal.y, c = normal.z, d = distance;
+                return { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+            }
+
+            Quadric& operator+=(const Quadric& other) {
+                a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+                b2 += other.b2; bc += other.bc; bd += other.bd;
+                c2 += other.c2; cd += other.cd;
+                d2 += other.d2;
+                return *this;
+            }
+
+            double Evaluate(const glm::vec3& position) const {
+                double x = position.x, y = position.y, z = position.z;
+                double error = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+                               b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+                               c2 * z * z + 2.0 * cd * z + d2;
+                return std::max(error, 0.0);
+            }
+        };
+
+        struct Collapse {
+            double cost;
+            uint32_t from, to;
+            uint32_t fromVersion, toVersion;
+
+            bool operator>(const Collapse& other) const { return cost > other.cost; }
+        };
+
+        // Works on positions welded across attribute seams, triangles keep pointing at the original
+        // vertices and get redirected to the best matching copy of the vertex they collapse onto
+        class EdgeCollapser {
+        public:
+            EdgeCollapser(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+                :mVertices(vertices) {
+                weld();
+
+                uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+                mCorners.assign(indices.begin(), indices.begin() + triangle_count * 3);
+                mAlive.assign(triangle_count, 0);
+                mTriangles.resize(mPositions.size());
+                mQuadrics.resize(mPositions.size());
+                mVersions.assign(mPositions.size(), 0);
+                mDead.assign(mPositions.size(), 0);
+
+                std::unordered_map<uint64_t, uint32_t> edge_uses;
+                for (uint32_t triangle = 0; triangle < triangle_count; triangle++) {
+                    uint32_t a = corner(triangle, 0), b = corner(triangle, 1), c = corner(triangle, 2);
+                    if (a == b || b == c || c == a)
+                        continue;
+                    mAlive[triangle] = 1;
+                    mTriangleCount++;
+                    for (uint32_t i = 0; i < 3; i++) {
+                        uint32_t from = corner(triangle, i), to = corner(triangle, (i + 1) % 3);
+                        mTriangles[from].push_back(triangle);
+                        edge_uses[edgeKey(from, to)]++;
+                    }
+
+                    glm::vec3 normal = glm::cross(mPositions[b] - mPositions[a], mPositions[c] - mPositions[a]);
+                    float length = glm::length(normal);
+                    if (length == 0.0f)
+                        continue;
+                    normal /= length;
+                    Quadric plane = Quadric::FromPlane(normal, -glm::dot(normal, mPositions[a]));
+                    mQuadrics[a] += plane;
+                    mQuadrics[b] += plane;
+                    mQuadrics[c] += plane;
+                }
+
+                // Open borders get a plane standing on the edge, so they can't shrink away for free
+                for (uint32_t triangle = 0; triangle < triangle_count; triangle++) {
+                    if (!mAlive[triangle])
+                        continue;
+                    glm::vec3 normal = triangleNormal(triangle);
+                    for (uint32_t i = 0; i < 3; i++) {
+                        uint32_t from = corner(triangle, i), to = corner(triangle, (i + 1) % 3);
+                        if (edge_uses[edgeKey(from, to)] != 1)
+                            continue;
+                        glm::vec3 border = glm::cross(mPositions[to] - mPositions[from], normal);
+                        float length = glm::length(border);
+                        if (length == 0.0f)
+                            continue;
+                        border /= length;
+                        Quadric plane = Quadric::FromPlane(border, -glm::dot(border, mPositions[from]));
+                        mQuadrics[from] += plane;
+                        mQuadrics[to] += plane;
+                    }
+                }
+
+                for (uint32_t triangle = 0; triangle < triangle_count; triangle++) {
+                    if (!mAlive[triangle])
+                        continue;
+                    for (uint32_t i = 0; i < 3; i++)
+                        pushCollapse(corner(triangle, i), corner(triangle, (i + 1) % 3));
+                }
+            }
+
+            void CollapseTo(uint32_t target_triangles) {
+                while (mTriangleCount > target_triangles && !mCollapses.empty()) {
+                    Collapse collapse = mCollapses.top();
+                    mCollapses.pop();
+                    if (mDead[collapse.from] || mDead[collapse.to] ||
+                        mVersions[collapse.from] != collapse.fromVersion || mVersions[collapse.to] != collapse.toVersion)
+                        continue;
+                    if (!canCollapse(collapse.from, collapse.to))
+                        continue;
+                    collapseEdge(collapse.from, collapse.to);
+                    mMaxCost = std::max(mMaxCost, collapse.cost);
+                }
+            }
+
+            uint32_t GetTriangleCount() const { return mTriangleCount; }
+            // The quadrics sum squared plane distances, so this bounds the largest single distance
+            float GetError() const { return static_cast<float>(std::sqrt(mMaxCost)); }
+
+            void Write(std::vector<uint32_t>& indices) const {
+                for (uint32_t triangle = 0; triangle < mAlive.size(); triangle++) {
+                    if (mAlive[triangle])
+                        indices.insert(indices.end(), mCorners.begin() + triangle * 3, mCorners.begin() + triangle * 3 + 3);
+                }
+            }
+        private:
+            // Sorting by position keeps the welding deterministic without hashing floats
+            void weld() {
+                std::vector<uint32_t> order(mVertices.size());
+                std::iota(order.begin(), order.end(), 0u);
+                auto less = [this](uint32_t a, uint32_t b) {
+                    const glm::vec3& pa = mVertices[a].position;
+                    const glm::vec3& pb = mVertices[b].position;
+                    if (pa.x != pb.x) return pa.x < pb.x;
+                    if (pa.y != pb.y) return pa.y < pb.y;
+                    if (pa.z != pb.z) return pa.z < pb.z;
+                    return a < b;
+                };
+                std::sort(order.begin(), order.end(), less);
+
+                mRemap.resize(mVertices.size());
+                for (uint32_t i = 0; i < order.size(); i++) {
+                    const glm::vec3& position = mVertices[order[i]].position;
+                    if (i == 0 || !(mVertices[order[i - 1]].position == position)) {
+                        mPositions.push_back(position);
+                        mOriginals.emplace_back();
+                    }
+                    uint32_t welded = static_cast<uint32_t>(mPositions.size() - 1);
+                    mRemap[order[i]] = welded;
+                    mOriginals[welded].push_back(order[i]);
+                }
+            }
+
+            uint32_t corner(uint32_t triangle, uint32_t i) const { return mRemap[mCorners[triangle * 3 + i]]; }
+
+            static uint64_t edgeKey(uint32_t a, uint32_t b) {
+                return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+            }
+
+            glm::vec3 triangleNormal(uint32_t triangle) const {
+                const glm::vec3& a = mPositions[corner(triangle, 0)];
+                glm::vec3 normal = glm::cross(mPositions[corner(triangle, 1)] - a, mPositions[corner(triangle, 2)] - a);
+                float length = glm::length(normal);
+                return length > 0.0f ? normal / length : normal;
+            }
+
+            bool contains(uint32_t triangle, uint32_t vertex) const {
+                return corner(triangle, 0) == vertex || corner(triangle, 1) == vertex || corner(triangle, 2) == vertex;
+            }
+
+            // Keeps the cheaper direction, the survivor stays where it is
+            void pushCollapse(uint32_t a, uint32_t b) {
+                Quadric sum = mQuadrics[a];
+                sum += mQuadrics[b];
+                double a_into_b = sum.Evaluate(mPositions[b]);
+                double b_into_a = sum.Evaluate(mPositions[a]);
+                if (a_into_b <= b_into_a)
+                    mCollapses.push({ a_into_b, a, b, mVersions[a], mVersions[b] });
+                else
+                    mCollapses.push({ b_into_a, b, a, mVersions[b], mVersions[a] });
+            }
+
+            void gatherNeighbors(uint32_t vertex, std::vector<uint32_t>& neighbors) const {
+                neighbors.clear();
+                for (uint32_t triangle : mTriangles[vertex]) {
+                    if (!mAlive[triangle])
+                        continue;
+                    for (uint32_t i = 0; i < 3; i++) {
+                        if (corner(triangle, i) != vertex)
+                            neighbors.push_back(corner(triangle, i));
+                    }
+                }
+                std::sort(neighbors.begin(), neighbors.end());
+                neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+            }
+
+            bool canCollapse(uint32_t from, uint32_t to) {
+                uint32_t shared = 0;
+                for (uint32_t triangle : mTriangles[from]) {
+                    if (mAlive[triangle] && contains(triangle, to))
+                        shared++;
+                }
+                if (shared == 0)
+                    return false;
+
+                // Link condition, more common neighbors than shared triangles would pinch the surface
+                gatherNeighbors(from, mFromNeighbors);
+                gatherNeighbors(to, mToNeighbors);
+                uint32_t common = 0;
+                for (uint32_t i = 0, j = 0; i < mFromNeighbors.size() && j < mToNeighbors.size();) {
+                    if (mFromNeighbors[i] < mToNeighbors[j])
+                        i++;
+                    else if (mFromNeighbors[i] > mToNeighbors[j])
+                        j++;
+                    else {
+                        common++;
+                        i++;
+                        j++;
+                    }
+                }
+                if (common > shared)
+                    return false;
+
+                // Rejects moves that fold a surviving triangle over or squash it flat
+                for (uint32_t triangle : mTriangles[from]) {
+                    if (!mAlive[triangle] || contains(triangle, to))
+                        continue;
+                    glm::vec3 before[3], after[3];
+                    for (uint32_t i = 0; i < 3; i++) {
+                        before[i] = mPositions[corner(triangle, i)];
+                        after[i] = corner(triangle, i) == from ? mPositions[to] : before[i];
+                    }
+                    glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    float length_before = glm::length(normal_before);
+                    if (length_before == 0.0f)
+                        continue;
+                    if (glm::dot(normal_before, normal_after) <= 0.25f * length_before * glm::length(normal_after))
+                        return false;
+                }
+                return true;
+            }
+
+            void collapseEdge(uint32_t from, uint32_t to) {
+                // Each copy of the removed vertex takes over the copy of the survivor with the closest attributes
+                mRedirects.clear();
+                for (uint32_t original : mOriginals[from]) {
+                    const Vertex& vertex = mVertices[original];
+                    uint32_t best = mOriginals[to][0];
+                    float best_distance = FLT_MAX;
+                    for (uint32_t candidate : mOriginals[to]) {
+                        glm::vec2 uv = mVertices[candidate].tex_coords - vertex.tex_coords;
+                        glm::vec3 normal = mVertices[candidate].normal - vertex.normal;
+                        float distance = glm::dot(uv, uv) + glm::dot(normal, normal);
+                        if (distance < best_distance) {
+                            best_distance = distance;
+                            best = candidate;
+                        }
+                    }
+                    mRedirects.push_back({ original, best });
+                }
+
+                for (uint32_t triangle : mTriangles[from]) {
+                    if (!mAlive[triangle])
+                        continue;
+                    if (contains(triangle, to)) {
+                        mAlive[triangle] = 0;
+                        mTriangleCount--;
+                        continue;
+                    }
+                    for (uint32_t i = 0; i < 3; i++) {
+                        uint32_t& original = mCorners[triangle * 3 + i];
+                        if (mRemap[original] != from)
+                            continue;
+                        for (const auto& [removed, survivor] : mRedirects) {
+                            if (removed == original) {
+                                original = survivor;
+                                break;
+                            }
+                        }
+                    }
+                    mTriangles[to].push_back(triangle);
+                }
+                std::erase_if(mTriangles[to], [this](uint32_t triangle) { return !mAlive[triangle]; });
+                mTriangles[from].clear();
+                mTriangles[from].shrink_to_fit();
+
+                mQuadrics[to] += mQuadrics[from];
+                mDead[from] = 1;
+                mVersions[to]++;
+
+                gatherNeighbors(to, mToNeighbors);
+                for (uint32_t neighbor : mToNeighbors)
+                    pushCollapse(to, neighbor);
+            }
+        private:
+            std::span<const Vertex> mVertices;
+            std::vector<uint32_t> mRemap;
+            std::vector<glm::vec3> mPositions;
+            std::vector<std::vector<uint32_t>> mOriginals;
+
+            std::vector<uint32_t> mCorners;
+            std::vector<uint8_t> mAlive;
+            uint32_t mTriangleCount = 0;
+            std::vector<std::vector<uint32_t>> mTriangles;
+
+            std::vector<Quadric> mQuadrics;
+            std::vector<uint32_t> mVersions;
+            std::vector<uint8_t> mDead;
+            std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> mCollapses;
+            double mMaxCost = 0.0;
+
+            std::vector<uint32_t> mFromNeighbors, mToNeighbors;
+            std::vector<std::pair<uint32_t, uint32_t>> mRedirects;
+        };
+
+    }
+
+    void MeshSimplifier::GenerateLODs(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                                      std::vector<uint32_t>& lod_indices, std::vector<MeshLOD>& lods) {
+        lod_indices.assign(indices.begin(), indices.end());
+        lods.clear();
+        lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+        uint32_t previous = static_cast<uint32_t>(indices.size() / 3);
+        if (previous < MIN_TRIANGLES)
+            return;
+
+        EdgeCollapser collapser(vertices, indices);
+        while (lods.size() < MAX_LODS) {
+            collapser.CollapseTo(static_cast<uint32_t>(previous * LOD_RATIO));
+            // Stuck on locked or folding collapses, another level would barely differ
+            uint32_t count = collapser.GetTriangleCount();
+            if (count == 0 || count > previous * 0.8f)
+                break;
+
+            uint32_t offset = static_cast<uint32_t>(lod_indices.size());
+            collapser.Write(lod_indices);
+            lods.push_back({ offset, count * 3, collapser.GetError() });
+            previous = count;
+        }
+    }
+
+}
@@ -0,0 +1,504 @@
+#include <Renderer/null_gl.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace OGLR {
+
+    namespace {
+
+        // Same order as FUNCTIONS below
+        enum class Function : uint16_t {
+            AttachShader, BeginQuery, BindBuffer, BindBufferBase, BindBufferRange, BindFramebuffer, BindRenderbuffer,
+            BindTextureUnit, BindVertexArray, BufferData, BufferSubData, CheckFramebufferStatus, Clear,
+            ClearColor, ClientWaitSync, CompileShader, CompressedTexImage2D, CompressedTextureSubImage2D,
+            CopyNamedBufferSubData, CreateBuffers, CreateProgram, CreateShader, CreateTextures, CullFace, DeleteBuffers,
+            DeleteFramebuffers, DeleteProgram, DeleteQueries, DeleteRenderbuffers, DeleteShader,
+            DeleteSync, DeleteTextures, DeleteVertexArrays, Disable, DrawBuffers, DrawElementsInstancedBaseInstance,
+            Enable, EndQuery, EnableVertexArrayAttrib, EnableVertexAttribArray, FenceSync, FramebufferRenderbuffer,
+            FramebufferTexture, GenBuffers, GenFramebuffers, GenQueries, GenRenderbuffers, GenTextures, GenVertexArrays,
+            GenerateMipmap, GenerateTextureMipmap, GetActiveUniform, GetInteger64v, GetIntegerv, GetProgramBinary,
+            GetProgramInfoLog, GetProgramResourceIndex, GetProgramiv, GetQueryObjectiv, GetQueryObjectui64v, GetShaderInfoLog, GetShaderiv, GetString, GetStringi,
+            GetUniformBlockIndex, GetUniformLocation, LinkProgram, MapNamedBufferRange, MultiDrawElementsIndirect,
+            NamedBufferStorage, NamedBufferSubData, PixelStorei, PointSize, PolygonMode, ProgramBinary, ProgramParameteri,
+            QueryCounter, ReadPixels, RenderbufferStorage,
+            ShaderSource, ShaderStorageBlockBinding, TexImage2D, TexParameteri, TextureParameteri, TextureStorage2D,
+            TextureSubImage2D, Uniform1f, Uniform1i, Uniform3f, Uniform4f, UniformBlockBinding, UniformMatrix3fv,
+            UniformMatrix4fv, UseProgram, ValidateProgram,
+            VertexArrayAttribBinding, VertexArrayAttribFormat, VertexArrayElementBuffer, VertexArrayVertexBuffer,
+            VertexAttribPointer, Viewport,
+            Count
+        };
+
+        void record(Function function, uint64_t value = 0) {
+            NullGL::Record(static_cast<uint32_t>(function), value);
+        }
+
+        // Names are never reused, so a stale name in the engine shows up as an unknown object
+        uint32_t mNextName = 1;
+        uint64_t mNextSync = 1;
+        std::unordered_map<GLuint, uint64_t> mBufferSizes;
+        std::unordered_map<GLuint, std::vector<uint8_t>> mMappedBuffers;
+        // Texture data read from a bound unpack buffer came through mapped memory, it isn't counted again
+        GLuint mUnpackBuffer = 0;
+
+        void generate(GLsizei n, GLuint* names) {
+            for (GLsizei i = 0; i < n; i++)
+                names[i] = mNextName++;
+        }
+
+        void emptyLog(GLsizei size, GLsizei* length, GLchar* log) {
+            if (length)
+                *length = 0;
+            if (log && size > 0)
+                log[0] = '\0';
+        }
+
+        uint64_t texelBytes(GLenum format, GLenum type) {
+            uint64_t components = 4;
+            switch (format) {
+                case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+                case GL_RG:  components = 2; break;
+                case GL_RGB: components = 3; break;
+            }
+            uint64_t size = 1;
+            switch (type) {
+                case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: size = 2; break;
+                case GL_FLOAT: case GL_UNSIGNED_INT: size = 4; break;
+            }
+            return components * size;
+        }
+
+        void APIENTRY attachShader(GLuint, GLuint) { record(Function::AttachShader); }
+        void APIENTRY beginQuery(GLenum, GLuint) { record(Function::BeginQuery); }
+        void APIENTRY bindBuffer(GLenum target, GLuint buffer) {
+            record(Function::BindBuffer);
+            if (target == GL_PIXEL_UNPACK_BUFFER)
+                mUnpackBuffer = buffer;
+        }
+        void APIENTRY bindBufferBase(GLenum, GLuint, GLuint) { record(Function::BindBufferBase); }
+        void APIENTRY bindBufferRange(GLenum, GLuint, GLuint, GLintptr, GLsizeiptr) { record(Function::BindBufferRange); }
+        void APIENTRY bindFramebuffer(GLenum, GLuint) { record(Function::BindFramebuffer); }
+        void APIENTRY bindRenderbuffer(GLenum, GLuint) { record(Function::BindRenderbuffer); }
+        void APIENTRY bindTextureUnit(GLuint, GLuint) { record(Function::BindTextureUnit); }
+        void APIENTRY bindVertexArray(GLuint) { record(Function::BindVertexArray); }
+        void APIENTRY bufferData(GLenum, GLsizeiptr size, const void* data, GLenum) { record(Function::BufferData, data ? size : 0); }
+        void APIENTRY bufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*) { record(Function::BufferSubData, size); }
+        GLenum APIENTRY checkFramebufferStatus(GLenum) { record(Function::CheckFramebufferStatus); return GL_FRAMEBUFFER_COMPLETE; }
+        void APIENTRY clear(GLbitfield) { record(Function::Clear); }
+        void APIENTRY clearColor(GLfloat, GLfloat, GLfloat, GLfloat) { record(Function::ClearColor); }
+        GLenum APIENTRY clientWaitSync(GLsync, GLbitfield, GLuint64) { record(Function::ClientWaitSync); return GL_ALREADY_SIGNALED; }
+        void APIENTRY compileShader(GLuint) { record(Function::CompileShader); }
+        void APIENTRY compressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei size, const void* data) {
+            record(Function::CompressedTexImage2D, data ? size : 0);
+        }
+        void APIENTRY compressedTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei size, const void*) {
+            record(Function::CompressedTextureSubImage2D, mUnpackBuffer ? 0 : size);
+        }
+        void APIENTRY copyNamedBufferSubData(GLuint, GLuint, GLintptr, GLintptr, GLsizeiptr) { record(Function::CopyNamedBufferSubData); }
+        void APIENTRY createBuffers(GLsizei n, GLuint* buffers) { record(Function::CreateBuffers); generate(n, buffers); }
+        GLuint APIENTRY createProgram() { record(Function::CreateProgram); return mNextName++; }
+        GLuint APIENTRY createShader(GLenum) { record(Function::CreateShader); return mNextName++; }
+        void APIENTRY createTextures(GLenum, GLsizei n, GLuint* textures) { record(Function::CreateTextures); generate(n, textures); }
+        void APIENTRY cullFace(GLenum) { record(Function::CullFace); }
+        void APIENTRY deleteBuffers(GLsizei n, const GLuint* buffers) {
+            record(Function::DeleteBuffers);
+            for (GLsizei i = 0; i < n; i++) {
+                mBufferSizes.erase(buffers[i]);
+                mMappedBuffers.erase(buffers[i]);
+            }
+        }
+        void APIENTRY deleteFramebuffers(GLsizei, const GLuint*) { record(Function::DeleteFramebuffers); }
+        void APIENTRY deleteProgram(GLuint) { record(Function::DeleteProgram); }
+        void APIENTRY deleteQueries(GLsizei, const GLuint*) { record(Function::DeleteQueries); }
+        void APIENTRY deleteRenderbuffers(GLsizei, const GLuint*) { record(Function::DeleteRenderbuffers); }
+        void APIENTRY deleteShader(GLuint) { record(Function::DeleteShader); }
+        void APIENTRY deleteSync(GLsync) { record(Function::DeleteSync); }
+        void APIENTRY deleteTextures(GLsizei, const GLuint*) { record(Function::DeleteTextures); }
+        void APIENTRY deleteVertexArrays(GLsizei, const GLuint*) { record(Function::DeleteVertexArrays); }
+        void APIENTRY disable(GLenum) { record(Function::Disable); }
+        void APIENTRY drawBuffers(GLsizei, const GLenum*) { record(Function::DrawBuffers); }
+        void APIENTRY drawElementsInstancedBaseInstance(GLenum, GLsizei, GLenum, const void*, GLsizei, GLuint) {
+            record(Function::DrawElementsInstancedBaseInstance, 1);
+        }
+        void APIENTRY enable(GLenum) { record(Function::Enable); }
+        void APIENTRY endQuery(GLenum) { record(Function::EndQuery); }
+        void APIENTRY enableVertexArrayAttrib(GLuint, GLuint) { record(Function::EnableVertexArrayAttrib); }
+        void APIENTRY enableVertexAttribArray(GLuint) { record(Function::EnableVertexAttribArray); }
+        GLsync APIENTRY fenceSync(GLenum, GLbitfield) { record(Function::FenceSync); return reinterpret_cast<GLsync>(mNextSync++); }
+        void APIENTRY framebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint) { record(Function::FramebufferRenderbuffer); }
+        void APIENTRY framebufferTexture(GLenum, GLenum, GLuint, GLint) { record(Function::FramebufferTexture); }
+        void APIENTRY genBuffers(GLsizei n, GLuint* buffers) { record(Function::GenBuffers); generate(n, buffers); }
+        void APIENTRY genFramebuffers(GLsizei n, GLuint* framebuffers) { record(Function::GenFramebuffers); generate(n, framebuffers); }
+        void APIENTRY genQueries(GLsizei n, GLuint* queries) { record(Function::GenQueries); generate(n, queries); }
+        void APIENTRY genRenderbuffers(GLsizei n, GLuint* renderbuffers) { record(Function::GenRenderbuffers); generate(n, renderbuffers); }
+        void APIENTRY genTextures(GLsizei n, GLuint* textures) { record(Function::GenTextures); generate(n, textures); }
+        void APIENTRY genVertexArrays(GLsizei n, GLuint* arrays) { record(Function::GenVertexArrays); generate(n, arrays); }
+        void APIENTRY generateMipmap(GLenum) { record(Function::GenerateMipmap); }
+        void APIENTRY generateTextureMipmap(GLuint) { record(Function::GenerateTextureMipmap); }
+        void APIENTRY getActiveUniform(GLuint, GLuint, GLsizei size, GLsizei* length, GLint* uniform_size, GLenum* type, GLchar* name) {
+            record(Function::GetActiveUniform);
+            emptyLog(size, length, name);
+            *uniform_size = 0;
+            *type = GL_FLOAT;
+        }
+        void APIENTRY getInteger64v(GLenum, GLint64* data) { record(Function::GetInteger64v); *data = 0; }
+        void APIENTRY getIntegerv(GLenum name, GLint* data) {
+            record(Function::GetIntegerv);
+            switch (name) {
+                // glad refuses a context without extensions
+                case GL_NUM_EXTENSIONS: *data = 1; break;
+                case GL_MAJOR_VERSION: *data = 4; break;
+                case GL_MINOR_VERSION: *data = 6; break;
+                case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+                case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+                case GL_MAX_TEXTURE_SIZE: *data = 16384; break;
+                default: *data = 0; break;
+            }
+        }
+        void APIENTRY getProgramBinary(GLuint, GLsizei, GLsizei* length, GLenum*, void*) { record(Function::GetProgramBinary); *length = 0; }
+        void APIENTRY getProgramInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log) { record(Function::GetProgramInfoLog); emptyLog(size, length, log); }
+        GLuint APIENTRY getProgramResourceIndex(GLuint, GLenum, const GLchar*) { record(Function::GetProgramResourceIndex); return GL_INVALID_INDEX; }
+        void APIENTRY getProgramiv(GLuint, GLenum name, GLint* params) {
+            record(Function::GetProgramiv);
+            *params = name == GL_LINK_STATUS || name == GL_VALIDATE_STATUS ? GL_TRUE : 0;
+        }
+        void APIENTRY getQueryObjectiv(GLuint, GLenum name, GLint* params) {
+            record(Function::GetQueryObjectiv);
+            *params = name == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+        }
+        void APIENTRY getQueryObjectui64v(GLuint, GLenum, GLuint64* params) { record(Function::GetQueryObjectui64v); *params = 0; }
+        void APIENTRY getShaderInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log) { record(Function::GetShaderInfoLog); emptyLog(size, length, log); }
+        void APIENTRY getShaderiv(GLuint, GLenum name, GLint* params) {
+            record(Function::GetShaderiv);
+            *params = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+        }
+        const GLubyte* APIENTRY getString(GLenum name) {
+            record(Function::GetString);
+            switch (name) {
+                case GL_VERSION: return reinterpret_cast<const GLubyte*>("4.6.0 NullGL");
+                case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("4.60 NullGL");
+                case GL_RENDERER: return reinterpret_cast<const GLubyte*>("NullGL");
+                default: return reinterpret_cast<const GLubyte*>("");
+            }
+        }
+        const GLubyte* APIENTRY getStringi(GLenum, GLuint) {
+            record(Function::GetStringi);
+            return reinterpret_cast<const GLubyte*>("GL_ARB_direct_state_access");
+        }
+        GLuint APIENTRY getUniformBlockIndex(GLuint, const GLchar*) { record(Function::GetUniformBlockIndex); return GL_INVALID_INDEX; }
+        GLint APIENTRY getUniformLocation(GLuint, const GLchar*) { record(Function::GetUniformLocation); return -1; }
+        void APIENTRY linkProgram(GLuint) { record(Function::LinkProgram); }
+        void* APIENTRY mapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield) {
+            record(Function::MapNamedBufferRange);
+            std::vector<uint8_t>& memory = mMappedBuffers[buffer];
+            memory.resize(std::max<uint64_t>(mBufferSizes[buffer], offset + length));
+            return memory.data() + offset;
+        }
+        void APIENTRY multiDrawElementsIndirect(GLenum, GLenum, const void*, GLsizei count, GLsizei) {
+            record(Function::MultiDrawElementsIndirect, count);
+        }
+        void APIENTRY namedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield) {
+            record(Function::NamedBufferStorage, data ? size : 0);
+            mBufferSizes[buffer] = size;
+        }
+        void APIENTRY namedBufferSubData(GLuint, GLintptr, GLsizeiptr size, const void*) { record(Function::NamedBufferSubData, size); }
+        void APIENTRY pixelStorei(GLenum, GLint) { record(Function::PixelStorei); }
+        void APIENTRY pointSize(GLfloat) { record(Function::PointSize); }
+        void APIENTRY polygonMode(GLenum, GLenum) { record(Function::PolygonMode); }
+        void APIENTRY programBinary(GLuint, GLenum, const void*, GLsizei size) { record(Function::ProgramBinary, size); }
+        void APIENTRY programParameteri(GLuint, GLenum, GLint) { record(Function::ProgramParameteri); }
+        void APIENTRY queryCounter(GLuint, GLenum) { record(Function::QueryCounter); }
+        void APIENTRY readPixels(GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+            record(Function::ReadPixels);
+            std::memset(pixels, 0, static_cast<size_t>(width) * height * texelBytes(format, type));
+        }
+        void APIENTRY renderbufferStorage(GLenum, GLenum, GLsizei, GLsizei) { record(Function::RenderbufferStorage); }
+        void APIENTRY shaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) { record(Function::ShaderSource); }
+        void APIENTRY shaderStorageBlockBinding(GLuint, GLuint, GLuint) { record(Function::ShaderStorageBlockBinding); }
+        void APIENTRY texImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels) {
+            record(Function::TexImage2D, pixels ? static_cast<uint64_t>(width) * height * texelBytes(format, type) : 0);
+        }
+        void APIENTRY texParameteri(GLenum, GLenum, GLint) { record(Function::TexParameteri); }
+        void APIENTRY textureParameteri(GLuint, GLenum, GLint) { record(Function::TextureParameteri); }
+        void APIENTRY textureStorage2D(GLuint, GLsizei, GLenum, GLsizei, GLsizei) { record(Function::TextureStorage2D); }
+        void APIENTRY textureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*) {
+            record(Function::TextureSubImage2D, mUnpackBuffer ? 0 : static_cast<uint64_t>(width) * height * texelBytes(format, type));
+        }
+        void APIENTRY uniform1f(GLint, GLfloat) { record(Function::Uniform1f); }
+        void APIENTRY uniform1i(GLint, GLint) { record(Function::Uniform1i); }
+        void APIENTRY uniform3f(GLint, GLfloat, GLfloat, GLfloat) { record(Function::Uniform3f); }
+        void APIENTRY uniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { record(Function::Uniform4f); }
+        void APIENTRY uniformBlockBinding(GLuint, GLuint, GLuint) { record(Function::UniformBlockBinding); }
+        void APIENTRY uniformMatrix3fv(GLint, GLsizei, GLboolean, const GLfloat*) { record(Function::UniformMatrix3fv); }
+        void APIENTRY uniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { record(Function::UniformMatrix4fv); }
+        void APIENTRY useProgram(GLuint) { record(Function::UseProgram); }
+        void APIENTRY validateProgram(GLuint) { record(Function::ValidateProgram); }
+        void APIENTRY vertexArrayAttribBinding(GLuint, GLuint, GLuint) { record(Function::VertexArrayAttribBinding); }
+        void APIENTRY vertexArrayAttribFormat(GLuint, GLuint, GLint, GLenum, GLboolean, GLuint) { record(Function::VertexArrayAttribFormat); }
+        void APIENTRY vertexArrayElementBuffer(GLuint, GLuint) { record(Function::VertexArrayElementBuffer); }
+        void APIENTRY vertexArrayVertexBuffer(GLuint, GLuint, GLuint, GLintptr, GLsizei) { record(Function::VertexArrayVertexBuffer); }
+        void APIENTRY vertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) { record(Function::VertexAttribPointer); }
+        void APIENTRY viewport(GLint, GLint, GLsizei, GLsizei) { record(Function::Viewport); }
+
+        struct FunctionEntry {
+            const char* name;
+            GLCallKind kind;
+            void* proc;
+        };
+
+        template <typename T>
+        void* proc(T function) { return reinterpret_cast<void*>(function); }
+
+        const FunctionEntry FUNCTIONS[] = {
+            { "glAttachShader", GLCallKind::OBJECT, proc(attachShader) },
+            { "glBeginQuery", GLCallKind::OTHER, proc(beginQuery) },
+            { "glBindBuffer", GLCallKind::STATE, proc(bindBuffer) },
+            { "glBindBufferBase", GLCallKind::STATE, proc(bindBufferBase) },
+            { "glBindBufferRange", GLCallKind::STATE, proc(bindBufferRange) },
+            { "glBindFramebuffer", GLCallKind::STATE, proc(bindFramebuffer) },
+            { "glBindRenderbuffer", GLCallKind::STATE, proc(bindRenderbuffer) },
+            { "glBindTextureUnit", GLCallKind::STATE, proc(bindTextureUnit) },
+            { "glBindVertexArray", GLCallKind::STATE, proc(bindVertexArray) },
+            { "glBufferData", GLCallKind::UPLOAD, proc(bufferData) },
+            { "glBufferSubData", GLCallKind::UPLOAD, proc(bufferSubData) },
+            { "glCheckFramebufferStatus", GLCallKind::QUERY, proc(checkFramebufferStatus) },
+            { "glClear", GLCallKind::OTHER, proc(clear) },
+            { "glClearColor", GLCallKind::STATE, proc(clearColor) },
+            { "glClientWaitSync", GLCallKind::QUERY, proc(clientWaitSync) },
+            { "glCompileShader", GLCallKind::OBJECT, proc(compileShader) },
+            { "glCompressedTexImage2D", GLCallKind::UPLOAD, proc(compressedTexImage2D) },
+            { "glCompressedTextureSubImage2D", GLCallKind::UPLOAD, proc(compressedTextureSubImage2D) },
+            { "glCopyNamedBufferSubData", GLCallKind::OTHER, proc(copyNamedBufferSubData) },
+            { "glCreateBuffers", GLCallKind::OBJECT, proc(createBuffers) },
+            { "glCreateProgram", GLCallKind::OBJECT, proc(createProgram) },
+            { "glCreateShader", GLCallKind::OBJECT, proc(createShader) },
+            { "glCreateTextures", GLCallKind::OBJECT, proc(createTextures) },
+            { "glCullFace", GLCallKind::STATE, proc(cullFace) },
+            { "glDeleteBuffers", GLCallKind::OBJECT, proc(deleteBuffers) },
+            { "glDeleteFramebuffers", GLCallKind::OBJECT, proc(deleteFramebuffers) },
+            { "glDeleteProgram", GLCallKind::OBJECT, proc(deleteProgram) },
+            { "glDeleteQueries", GLCallKind::OBJECT, proc(deleteQueries) },
+            { "glDeleteRenderbuffers", GLCallKind::OBJECT, proc(deleteRenderbuffers) },
+            { "glDeleteShader", GLCallKind::OBJECT, proc(deleteShader) },
+            { "glDeleteSync", GLCallKind::OBJECT, proc(deleteSync) },
+            { "glDeleteTextures", GLCallKind::OBJECT, proc(deleteTextures) },
+            { "glDeleteVertexArrays", GLCallKind::OBJECT, proc(deleteVertexArrays) },
+            { "glDisable", GLCallKind::STATE, proc(disable) },
+            { "glDrawBuffers", GLCallKind::STATE, proc(drawBuffers) },
+            { "glDrawElementsInstancedBaseInstance", GLCallKind::DRAW, proc(drawElementsInstancedBaseInstance) },
+            { "glEnable", GLCallKind::STATE, proc(enable) },
+            { "glEndQuery", GLCallKind::OTHER, proc(endQuery) },
+            { "glEnableVertexArrayAttrib", GLCallKind::STATE, proc(enableVertexArrayAttrib) },
+            { "glEnableVertexAttribArray", GLCallKind::STATE, proc(enableVertexAttribArray) },
+            { "glFenceSync", GLCallKind::OBJECT, proc(fenceSync) },
+            { "glFramebufferRenderbuffer", GLCallKind::STATE, proc(framebufferRenderbuffer) },
+            { "glFramebufferTexture", GLCallKind::STATE, proc(framebufferTexture) },
+            { "glGenBuffers", GLCallKind::OBJECT, proc(genBuffers) },
+            { "glGenFramebuffers", GLCallKind::OBJECT, proc(genFramebuffers) },
+            { "glGenQueries", GLCallKind::OBJECT, proc(genQueries) },
+            { "glGenRenderbuffers", GLCallKind::OBJECT, proc(genRenderbuffers) },
+            { "glGenTextures", GLCallKind::OBJECT, proc(genTextures) },
+            { "glGenVertexArrays", GLCallKind::OBJECT, proc(genVertexArrays) },
+            { "glGenerateMipmap", GLCallKind::OTHER, proc(generateMipmap) },
+            { "glGenerateTextureMipmap", GLCallKind::OTHER, proc(generateTextureMipmap) },
+            { "glGetActiveUniform", GLCallKind::QUERY, proc(getActiveUniform) },
+            { "glGetInteger64v", GLCallKind::QUERY, proc(getInteger64v) },
+            { "glGetIntegerv", GLCallKind::QUERY, proc(getIntegerv) },
+            { "glGetProgramBinary", GLCallKind::QUERY, proc(getProgramBinary) },
+            { "glGetProgramInfoLog", GLCallKind::QUERY, proc(getProgramInfoLog) },
+            { "glGetProgramResourceIndex", GLCallKind::QUERY, proc(getProgramResourceIndex) },
+            { "glGetProgramiv", GLCallKind::QUERY, proc(getProgramiv) },
+            { "glGetQueryObjectiv", GLCallKind::QUERY, proc(getQueryObjectiv) },
+            { "glGetQueryObjectui64v", GLCallKind::QUERY, proc(getQueryObjectui64v) },
+            { "glGetShaderInfoLog", GLCallKind::QUERY, proc(getShaderInfoLog) },
+            { "glGetShaderiv", GLCallKind::QUERY, proc(getShaderiv) },
+            { "glGetString", GLCallKind::QUERY, proc(getString) },
+            { "glGetStringi", GLCallKind::QUERY, proc(getStringi) },
+            { "glGetUniformBlockIndex", GLCallKind::QUERY, proc(getUniformBlockIndex) },
+            { "glGetUniformLocation", GLCallKind::QUERY, proc(getUniformLocation) },
+            { "glLinkProgram", GLCallKind::OBJECT, proc(linkProgram) },
+            { "glMapNamedBufferRange", GLCallKind::OTHER, proc(mapNamedBufferRange) },
+            { "glMultiDrawElementsIndirect", GLCallKind::DRAW, proc(multiDrawElementsIndirect) },
+            { "glNamedBufferStorage", GLCallKind::UPLOAD, proc(namedBufferStorage) },
+            { "glNamedBufferSubData", GLCallKind::UPLOAD, proc(namedBufferSubData) },
+            { "glPixelStorei", GLCallKind::STATE, proc(pixelStorei) },
+            { "glPointSize", GLCallKind::STATE, proc(pointSize) },
+            { "glPolygonMode", GLCallKind::STATE, proc(polygonMode) },
+            { "glProgramBinary", GLCallKind::UPLOAD, proc(programBinary) },
+            { "glProgramParameteri", GLCallKind::STATE, proc(programParameteri) },
+            { "glQueryCounter", GLCallKind::OTHER, proc(queryCounter) },
+            { "glReadPixels", GLCallKind::QUERY, proc(readPixels) },
+            { "glRenderbufferStorage", GLCallKind::OBJECT, proc(renderbufferStorage) },
+            { "glShaderSource", GLCallKind::OBJECT, proc(shaderSource) },
+            { "glShaderStorageBlockBinding", GLCallKind::STATE, proc(shaderStorageBlockBinding) },
+            { "glTexImage2D", GLCallKind::UPLOAD, proc(texImage2D) },
+            { "glTexParameteri", GLCallKind::STATE, proc(texParameteri) },
+            { "glTextureParameteri", GLCallKind::STATE, proc(textureParameteri) },
+            { "glTextureStorage2D", GLCallKind::OBJECT, proc(textureStorage2D) },
+            { "glTextureSubImage2D", GLCallKind::UPLOAD, proc(textureSubImage2D) },
+            { "glUniform1f", GLCallKind::STATE, proc(uniform1f) },
+            { "glUniform1i", GLCallKind::STATE, proc(uniform1i) },
+            { "glUniform3f", GLCallKind::STATE, proc(uniform3f) },
+            { "glUniform4f", GLCallKind::STATE, proc(uniform4f) },
+            { "glUniformBlockBinding", GLCallKind::STATE, proc(uniformBlockBinding) },
+            { "glUniformMatrix3fv", GLCallKind::STATE, proc(uniformMatrix3fv) },
+            { "glUniformMatrix4fv", GLCallKind::STATE, proc(uniformMatrix4fv) },
+            { "glUseProgram", GLCallKind::STATE, proc(useProgram) },
+            { "glValidateProgram", GLCallKind::OBJECT, proc(validateProgram) },
+            { "glVertexArrayAttribBinding", GLCallKind::STATE, proc(vertexArrayAttribBinding) },
+            { "glVertexArrayAttribFormat", GLCallKind::STATE, proc(vertexArrayAttribFormat) },
+            { "glVertexArrayElementBuffer", GLCallKind::STATE, proc(vertexArrayElementBuffer) },
+            { "glVertexArrayVertexBuffer", GLCallKind::STATE, proc(vertexArrayVertexBuffer) },
+            { "glVertexAttribPointer", GLCallKind::STATE, proc(vertexAttribPointer) },
+            { "glViewport", GLCallKind::STATE, proc(viewport) },
+        };
+        static_assert(std::size(FUNCTIONS) == static_cast<size_t>(Function::Count), "FUNCTIONS must list every Function in order");
+
+        void* getProcAddress(const char* name) {
+            for (const FunctionEntry& entry : FUNCTIONS) {
+                if (std::strcmp(entry.name, name) == 0)
+                    return entry.proc;
+            }
+            return nullptr;
+        }
+
+    }
+
+    bool NullGL::Load() {
+        mFrame.callCounts.assign(GetFunctionCount(), 0);
+        if (!gladLoadGLLoader(getProcAddress)) {
+            std::cerr << "NullGL couldn't be loaded through glad\n";
+            return false;
+        }
+        mLoaded = true;
+        return true;
+    }
+
+    void NullGL::EndFrame() {
+        mFrames.push_back(mFrame);
+        mFrame = {};
+        mFrame.callCounts.assign(GetFunctionCount(), 0);
+        if (mRecording)
+            mTrace.push_back({ FRAME_END, 0, 0 });
+    }
+
+    uint32_t NullGL::GetFunctionCount() {
+        return static_cast<uint32_t>(Function::Count);
+    }
+
+    const char* NullGL::GetFunctionName(uint32_t function) {
+        return FUNCTIONS[function].name;
+    }
+
+    GLCallKind NullGL::GetFunctionKind(uint32_t function) {
+        return FUNCTIONS[function].kind;
+    }
+
+    void NullGL::Record(uint32_t function, uint64_t value) {
+        accumulate(mFrame, FUNCTIONS[function].kind, function, value);
+        if (mRecording)
+            mTrace.push_back({ static_cast<uint16_t>(function), 0, static_cast<uint32_t>(std::min<uint64_t>(value, UINT32_MAX)) });
+    }
+
+    void NullGL::accumulate(NullGLFrame& frame, GLCallKind kind, uint32_t function, uint64_t value) {
+        frame.calls++;
+        if (function < frame.callCounts.size())
+            frame.callCounts[function]++;
+        switch (kind) {
+            case GLCallKind::STATE: frame.stateChanges++; break;
+            case GLCallKind::UPLOAD: frame.bytesUploaded += value; break;
+            case GLCallKind::DRAW: frame.draws++; frame.drawCommands += value; break;
+            case GLCallKind::QUERY: frame.queries++; break;
+            default: break;
+        }
+    }
+
+    // Layout: magic, version, function count, then per function its kind, name length and name,
+    // then one TraceRecord per call with FRAME_END closing every frame
+    bool NullGL::WriteTrace(const std::string& path) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Couldn't write trace " << path << '\n';
+            return false;
+        }
+        uint32_t header[3] = { TRACE_MAGIC, TRACE_VERSION, GetFunctionCount() };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (const FunctionEntry& entry : FUNCTIONS) {
+            uint8_t kind = static_cast<uint8_t>(entry.kind);
+            uint16_t length = static_cast<uint16_t>(std::strlen(entry.name));
+            file.write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(entry.name, length);
+        }
+        file.write(reinterpret_cast<const char*>(mTrace.data()), static_cast<std::streamsize>(mTrace.size() * sizeof(TraceRecord)));
+        return static_cast<bool>(file);
+    }
+
+    bool NullGL::ReplayTrace(const std::string& path, std::ostream& json) {
+        std::ifstream file(path, std::ios::binary);
+        uint32_t header[3] = {};
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != TRACE_MAGIC || header[1] != TRACE_VERSION) {
+            std::cerr << path << " isn't a trace written by this version\n";
+            return false;
+        }
+
+        // The trace carries its own function table, so older traces still replay after functions are added
+        std::vector<std::string> names(header[2]);
+        std::vector<GLCallKind> kinds(header[2]);
+        for (uint32_t i = 0; i < header[2]; i++) {
+            uint8_t kind = 0;
+            uint16_t length = 0;
+            file.read(reinterpret_cast<char*>(&kind), sizeof(kind));
+            file.read(reinterpret_cast<char*>(&length), sizeof(length));
+            names[i].resize(length);
+            file.read(names[i].data(), length);
+            kinds[i] = static_cast<GLCallKind>(kind);
+        }
+        if (!file) {
+            std::cerr << path << " is truncated\n";
+            return false;
+        }
+
+        std::vector<NullGLFrame> frames;
+        NullGLFrame frame;
+        frame.callCounts.assign(names.size(), 0);
+        TraceRecord record;
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            if (record.function == FRAME_END) {
+                frames.push_back(frame);
+                frame = {};
+                frame.callCounts.assign(names.size(), 0);
+            } else if (record.function < names.size()) {
+                accumulate(frame, kinds[record.function], record.function, record.value);
+            }
+        }
+        WriteJSON(frames, names, json);
+        return true;
+    }
+
+    void NullGL::WriteJSON(const std::vector<NullGLFrame>& frames, const std::vector<std::string>& names, std::ostream& json) {
+        json << "[\n";
+        for (size_t i = 0; i < frames.size(); i++) {
+            const NullGLFrame& frame = frames[i];
+            json << "  { \"frame\": " << i << ", \"calls\": " << frame.calls << ", \"draws\": " << frame.draws
+                 << ", \"drawCommands\": " << frame.drawCommands << ", \"stateChanges\": " << frame.stateChanges
+                 << ", \"queries\": " << frame.queries << ", \"bytesUploaded\": " << frame.bytesUploaded << ", \"callCounts\": {";
+            bool first = true;
+            for (size_t function = 0; function < frame.callCounts.size() && function < names.size(); function++) {
+                if (frame.callCounts[function] == 0)
+                    continue;
+                json << (first ? " " : ", ") << '"' << names[function] << "\": " << frame.callCounts[function];
+                first = false;
+            }
+            json << (first ? "} }" : " } }") << (i + 1 < frames.size() ? ",\n" : "\n");
+        }
+        json << "]\n";
+    }
+
+}
@@ -0,0 +1,238 @@
+#include <Renderer/occlusion_buffer.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define OGLR_RASTER_SSE
+#endif
+
+namespace OGLR {
+
+    OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+        :mWidth((std::max(width, 4u) + 3) & ~3u), mHeight(std::max(height, 1u)) {
+        uint32_t level_width = mWidth;
+        uint32_t level_height = mHeight;
+        while (true) {
+            mLevels.push_back({ level_width, level_height, std::vector<float>(level_width * level_height, 1.0f) });
+            if (level_width == 1 && level_height == 1)
+                break;
+            level_width = (level_width + 1) / 2;
+            level_height = (level_height + 1) / 2;
+        }
+    }
+
+    void OcclusionBuffer::Begin(const glm::mat4& view_proj) {
+        mViewProj = view_proj;
+        std::fill(mLevels[0].depth.begin(), mLevels[0].depth.end(), 1.0f);
+    }
+
+    void OcclusionBuffer::RasterizeOccluder(const OccluderMesh& occluder, const glm::mat4& model) {
+        glm::mat4 model_view_proj = mViewProj * model;
+        mClipPositions.resize(occluder.positions.size());
+        for (size_t i = 0; i < occluder.positions.size(); i++)
+            mClipPositions[i] = model_view_proj * glm::vec4(occluder.positions[i], 1.0f);
+
+        for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+            rasterizeClipped(mClipPositions[occluder.indices[i]], mClipPositions[occluder.indices[i + 1]], mClipPositions[occluder.indices[i + 2]]);
+            mStats.occluderTriangles++;
+        }
+    }
+
+    void OcclusionBuffer::End() {
+        // Each texel keeps the farthest depth below it, so one texel bounds every occluder in its area
+        for (size_t level = 1; level < mLevels.size(); level++) {
+            const Level& source = mLevels[level - 1];
+            Level& target = mLevels[level];
+            for (uint32_t y = 0; y < target.height; y++) {
+                uint32_t y0 = std::min(2 * y, source.height - 1);
+                uint32_t y1 = std::min(2 * y + 1, source.height - 1);
+                for (uint32_t x = 0; x < target.width; x++) {
+                    uint32_t x0 = std::min(2 * x, source.width - 1);
+                    uint32_t x1 = std::min(2 * x + 1, source.width - 1);
+                    target.depth[y * target.width + x] = std::max(
+                        std::max(source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1]),
+                        std::max(source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1]));
+                }
+            }
+        }
+    }
+
+    bool OcclusionBuffer::IsVisible(const AABB& bounds, OcclusionStats& stats) const {
+        stats.tested++;
+        if (!bounds.IsValid())
+            return true;
+
+        glm::vec2 screen_min(FLT_MAX);
+        glm::vec2 screen_max(-FLT_MAX);
+        float nearest = FLT_MAX;
+        for (uint32_t corner = 0; corner < 8; corner++) {
+            glm::vec3 position((corner & 1) ? bounds.max.x : bounds.min.x,
+                               (corner & 2) ? bounds.max.y : bounds.min.y,
+                               (corner & 4) ? bounds.max.z : bounds.min.z);
+            glm::vec4 clip = mViewProj * glm::vec4(position, 1.0f);
+            if (clip.z < -clip.w || clip.w <= 0.0f)
+                return true;
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            glm::vec2 screen((ndc.x * 0.5f + 0.5f) * mWidth, (ndc.y * 0.5f + 0.5f) * mHeight);
+            screen_min = glm::min(screen_min, screen);
+            screen_max = glm::max(screen_max, screen);
+            nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+        }
+        if (screen_max.x < 0.0f || screen_max.y < 0.0f || screen_min.x >= mWidth || screen_min.y >= mHeight)
+            return true;
+
+        int x0 = std::max(0, static_cast<int>(std::floor(screen_min.x)));
+        int y0 = std::max(0, static_cast<int>(std::floor(screen_min.y)));
+        int x1 = std::min(static_cast<int>(mWidth) - 1, static_cast<int>(std::floor(screen_max.x)));
+        int y1 = std::min(static_cast<int>(mHeight) - 1, static_cast<int>(std::floor(screen_max.y)));
+
+        // Smallest level where the rectangle spans at most 3x3 texels
+        uint32_t size = static_cast<uint32_t>(std::max(x1 - x0, y1 - y0) + 1);
+        uint32_t level = std::min<uint32_t>(std::max(static_cast<int>(std::bit_width(size - 1)) - 1, 0), GetLevelCount() - 1);
+        const Level& pyramid = mLevels[level];
+
+        float farthest = 0.0f;
+        for (int y = y0 >> level; y <= (y1 >> level); y++) {
+            for (int x = x0 >> level; x <= (x1 >> level); x++)
+                farthest = std::max(farthest, pyramid.depth[y * pyramid.width + x]);
+        }
+        if (nearest > farthest) {
+            stats.occluded++;
+            return false;
+        }
+        return true;
+    }
+
+    bool OcclusionBuffer::WriteDebugImage(const std::string& path, uint32_t level) const {
+        const Level& image = mLevels[std::min<uint32_t>(level, GetLevelCount() - 1)];
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "ERROR::OCCLUSION::COULDN'T_WRITE " << path << '\n';
+            return false;
+        }
+
+        // Perspective depth bunches up near 1, stretch whatever range is covered to the full grey scale
+        float nearest = 1.0f;
+        for (float depth : image.depth)
+            nearest = std::min(nearest, depth);
+        float scale = nearest < 1.0f ? 255.0f / (1.0f - nearest) : 0.0f;
+
+        file << "P5\n" << image.width << ' ' << image.height << "\n255\n";
+        std::vector<uint8_t> row(image.width);
+        for (uint32_t y = 0; y < image.height; y++) {
+            const float* source = &image.depth[(image.height - 1 - y) * image.width];
+            for (uint32_t x = 0; x < image.width; x++)
+                row[x] = static_cast<uint8_t>(std::clamp((1.0f - source[x]) * scale, 0.0f, 255.0f));
+            file.write(reinterpret_cast<const char*>(row.data()), row.size());
+        }
+        return static_cast<bool>(file);
+    }
+
+    void OcclusionBuffer::rasterizeClipped(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+        // Entirely outside one side of the frustum, the near plane is handled by clipping below
+        if ((a.x < -a.w && b.x < -b.w && c.x < -c.w) || (a.x > a.w && b.x > b.w && c.x > c.w) ||
+            (a.y < -a.w && b.y < -b.w && c.y < -c.w) || (a.y > a.w && b.y > b.w && c.y > c.w) ||
+            (a.z > a.w && b.z > b.w && c.z > c.w))
+            return;
+
+        // Sutherland-Hodgman against z >= -w, a triangle comes out with at most 4 vertices
+        const glm::vec4 input[3] = { a, b, c };
+        glm::vec4 clipped[4];
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < 3; i++) {
+            const glm::vec4& current = input[i];
+            const glm::vec4& next = input[(i + 1) % 3];
+            float current_distance = current.z + current.w;
+            float next_distance = next.z + next.w;
+            if (current_distance >= 0.0f)
+                clipped[count++] = current;
+            if ((current_distance >= 0.0f) != (next_distance >= 0.0f)) {
+                float t = current_distance / (current_distance - next_distance);
+                clipped[count++] = current + (next - current) * t;
+            }
+        }
+        if (count < 3)
+            return;
+
+        glm::vec3 screen[4];
+        for (uint32_t i = 0; i < count; i++) {
+            glm::vec3 ndc = glm::vec3(clipped[i]) / clipped[i].w;
+            screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * mWidth, (ndc.y * 0.5f + 0.5f) * mHeight, ndc.z * 0.5f + 0.5f);
+        }
+        rasterizeTriangle(screen[0], screen[1], screen[2]);
+        if (count == 4)
+            rasterizeTriangle(screen[0], screen[2], screen[3]);
+    }
+
+    void OcclusionBuffer::rasterizeTriangle(const glm::vec3& a, const glm::vec3& b_in, const glm::vec3& c_in) {
+        // Occluders are often double sided, so both windings are drawn, turned counter clockwise here
+        float area = (b_in.x - a.x) * (c_in.y - a.y) - (b_in.y - a.y) * (c_in.x - a.x);
+        if (std::abs(area) < 1e-8f)
+            return;
+        glm::vec3 b = area > 0.0f ? b_in : c_in;
+        glm::vec3 c = area > 0.0f ? c_in : b_in;
+        area = std::abs(area);
+
+        int min_x = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+        int min_y = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+        int max_x = std::min(static_cast<int>(mWidth) - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+        int max_y = std::min(static_cast<int>(mHeight) - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+        if (min_x > max_x || min_y > max_y)
+            return;
+        mStats.rasterizedTriangles++;
+
+        // Edge functions E = A*x + B*y + C, each one is the barycentric weight of the opposite vertex
+        auto edge = [](const glm::vec3& from, const glm::vec3& to) {
+            float step_x = -(to.y - from.y);
+            float step_y = to.x - from.x;
+            return glm::vec3(step_x, step_y, -(step_x * from.x + step_y * from.y));
+        };
+        glm::vec3 edge_a = edge(b, c);
+        glm::vec3 edge_b = edge(c, a);
+        glm::vec3 edge_c = edge(a, b);
+        // Depth is affine in screen space, folded into one plane equation
+        glm::vec3 depth_plane = (edge_a * a.z + edge_b * b.z + edge_c * c.z) / area;
+
+        std::vector<float>& depth = mLevels[0].depth;
+        int start_x = min_x & ~3;
+        for (int y = min_y; y <= max_y; y++) {
+            float pixel_y = y + 0.5f;
+            float row_a = edge_a.y * pixel_y + edge_a.z;
+            float row_b = edge_b.y * pixel_y + edge_b.z;
+            float row_c = edge_c.y * pixel_y + edge_c.z;
+            float row_depth = depth_plane.y * pixel_y + depth_plane.z;
+            float* row = &depth[y * mWidth];
+#if defined(OGLR_RASTER_SSE)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            for (int x = start_x; x <= max_x; x += 4) {
+                __m128 pixel_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                __m128 weight_a = _mm_add_ps(_mm_mul_ps(pixel_x, _mm_set1_ps(edge_a.x)), _mm_set1_ps(row_a));
+                __m128 weight_b = _mm_add_ps(_mm_mul_ps(pixel_x, _mm_set1_ps(edge_b.x)), _mm_set1_ps(row_b));
+                __m128 weight_c = _mm_add_ps(_mm_mul_ps(pixel_x, _mm_set1_ps(edge_c.x)), _mm_set1_ps(row_c));
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(weight_a, zero), _mm_cmpge_ps(weight_b, zero)), _mm_cmpge_ps(weight_c, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 pixel_depth = _mm_add_ps(_mm_mul_ps(pixel_x, _mm_set1_ps(depth_plane.x)), _mm_set1_ps(row_depth));
+                __m128 current = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(current, pixel_depth);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (int x = start_x; x <= max_x; x++) {
+                float pixel_x = x + 0.5f;
+                if (edge_a.x * pixel_x + row_a < 0.0f || edge_b.x * pixel_x + row_b < 0.0f || edge_c.x * pixel_x + row_c < 0.0f)
+                    continue;
+                row[x] = std::min(row[x], depth_plane.x * pixel_x + row_depth);
+            }
+#endif
+        }
+    }
+
+}
@@ -0,0 +1,141 @@
+#include <Renderer/program_cache.h>
+#include <Renderer/shader.h>
+#include <hash.h>
+#include <mapped_file.h>
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace OGLR {
+
+    namespace {
+
+        // Written verbatim, so only fixed size types
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t key;
+            uint32_t binaryFormat;
+            uint32_t binarySize;
+            double compileMs;
+        };
+
+        uint64_t hashStage(const std::optional<std::string>& source, uint64_t seed) {
+            // The presence flag keeps a vertex-only and a fragment-only program with the same text apart
+            uint8_t present = source.has_value();
+            uint64_t hash = HashBytes(&present, sizeof(present), seed);
+            return source ? HashString(*source, hash) : hash;
+        }
+
+        std::string_view glString(uint32_t name) {
+            const char* string = reinterpret_cast<const char*>(glGetString(name));
+            return string ? string : "";
+        }
+
+    }
+
+    std::string ProgramCache::GetCachePath(const std::string& shader_path, uint64_t variant) {
+        if (variant == 0)
+            return shader_path + ".oglrprog";
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), ".%016llx", static_cast<unsigned long long>(variant));
+        return shader_path + suffix + ".oglrprog";
+    }
+
+    bool ProgramCache::IsSupported() {
+        int format_count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        return format_count > 0;
+    }
+
+    uint64_t ProgramCache::GetKey(const ShaderSource& source) {
+        uint64_t key = hashStage(source.vertex, FNV_OFFSET_BASIS);
+        key = hashStage(source.fragment, key);
+        key = hashStage(source.geometry, key);
+        key = hashStage(source.compute, key);
+        // Binaries only load into the exact driver build that produced them
+        for (uint32_t name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+            key = HashString(glString(name), HashString("\n", key));
+        return key;
+    }
+
+    bool ProgramCache::Load(const std::string& cache_path, uint64_t key, uint32_t program, double& compile_ms) {
+        MappedFile file(cache_path);
+        if (!file.IsOpen() || file.GetSize() < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, file.GetData(), sizeof(FileHeader));
+        if (header.magic != MAGIC || header.version != VERSION || header.key != key)
+            return false;
+        if (file.GetSize() != sizeof(FileHeader) + header.binarySize) {
+            std::cerr << "ERROR::PROGRAM_CACHE:: corrupt cache file " << cache_path << '\n';
+            return false;
+        }
+
+        glProgramBinary(program, header.binaryFormat, file.GetData() + sizeof(FileHeader), static_cast<int>(header.binarySize));
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            // Drivers may refuse their own binaries, e.g. after an update that kept the version string
+            std::cout << "Program binary " << cache_path << " was rejected by the driver, compiling from source\n";
+            return false;
+        }
+        compile_ms = header.compileMs;
+        return true;
+    }
+
+    bool ProgramCache::Store(const std::string& cache_path, uint64_t key, uint32_t program, double compile_ms) {
+        int size = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+        if (size <= 0)
+            return false;
+
+        std::vector<uint8_t> binary(static_cast<size_t>(size));
+        int length = 0;
+        uint32_t format = 0;
+        glGetProgramBinary(program, size, &length, &format, binary.data());
+        if (length <= 0)
+            return false;
+
+        FileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.key = key;
+        header.binaryFormat = format;
+        header.binarySize = static_cast<uint32_t>(length);
+        header.compileMs = compile_ms;
+
+        // Write next to the destination and rename, so a crash never leaves a half written binary behind
+        std::string temp_path = cache_path + ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::cerr << "ERROR::PROGRAM_CACHE:: couldn't open " << temp_path << " for writing\n";
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+            out.write(reinterpret_cast<const char*>(binary.data()), length);
+            if (!out) {
+                std::cerr << "ERROR::PROGRAM_CACHE:: failed writing " << temp_path << '\n';
+                out.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        std::remove(cache_path.c_str());
+        if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+            std::cerr << "ERROR::PROGRAM_CACHE:: couldn't move " << temp_path << " to " << cache_path << '\n';
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+}
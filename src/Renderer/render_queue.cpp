@@ -0,0 +1,224 @@
+#include <Renderer/render_queue.h>
+#include <Renderer/stream_buffer.h>
+#include <profiler.h>
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <array>
+
+namespace OGLR {
+
+    uint64_t RenderQueue::MakeKey(RenderPass pass, uint32_t shader, uint32_t material, uint32_t vertex_array, IndexType index_type, uint16_t depth) {
+        return (static_cast<uint64_t>(pass & 0xF) << 60) |
+               (static_cast<uint64_t>(shader & 0xFFF) << 48) |
+               (static_cast<uint64_t>(material & 0xFFFF) << 32) |
+               (static_cast<uint64_t>(vertex_array & 0x7FFF) << 17) |
+               (static_cast<uint64_t>(index_type == IndexType::UINT32) << 16) |
+               static_cast<uint64_t>(depth);
+    }
+
+    void DrawList::Submit(RenderPass pass, const DrawCommand& command, float view_depth) {
+        uint16_t depth = static_cast<uint16_t>(std::clamp(view_depth * mDepthScale, 0.0f, 65535.0f));
+        mKeys.push_back(RenderQueue::MakeKey(pass, command.shader->GetID(), command.material->GetID(), command.vertexArray->GetID(),
+                                             command.indexType, depth));
+        mCommands.push_back(command);
+    }
+
+    void DrawList::clear(float depth_scale) {
+        mCommands.clear();
+        mKeys.clear();
+        mDepthScale = depth_scale;
+    }
+
+    void RenderQueue::Begin(float far_plane) {
+        mDepthScale = far_plane > 0.0f ? 65535.0f / far_plane : 0.0f;
+        mListCount = 0;
+        AddDrawLists(1);
+
+        mLastStats = mStats;
+        mStats = {};
+    }
+
+    void RenderQueue::Submit(RenderPass pass, const DrawCommand& command, float view_depth) {
+        mLists[0].Submit(pass, command, view_depth);
+        mPrepared = false;
+    }
+
+    uint32_t RenderQueue::AddDrawLists(uint32_t count) {
+        uint32_t first = mListCount;
+        mListCount += count;
+        if (mLists.size() < mListCount)
+            mLists.resize(mListCount);
+        for (uint32_t i = first; i < mListCount; i++)
+            mLists[i].clear(mDepthScale);
+        mPrepared = false;
+        return first;
+    }
+
+    uint32_t RenderQueue::GetCommandCount() const {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < mListCount; i++)
+            count += mLists[i].GetCommandCount();
+        return count;
+    }
+
+    void RenderQueue::Prepare(ThreadPool* pool) {
+        OGLR_PROFILE_ZONE("RenderQueue::Prepare");
+        // Not worth waking the workers for
+        if (GetCommandCount() < PARALLEL_GRAIN)
+            pool = nullptr;
+        merge(pool);
+        sort();
+        uploadIndirect(pool);
+        buildRuns();
+        mPrepared = true;
+    }
+
+    void RenderQueue::Execute(RenderPass pass) {
+        OGLR_PROFILE_ZONE("RenderQueue::Execute");
+        if (!mPrepared)
+            Prepare();
+
+        // Runs are in pass order like the sorted draws they cover
+        auto pass_begin = std::lower_bound(mRuns.begin(), mRuns.end(), pass, [](const DrawRun& run, RenderPass pass) { return run.pass < pass; });
+        auto pass_end = std::upper_bound(pass_begin, mRuns.end(), pass, [](RenderPass pass, const DrawRun& run) { return pass < run.pass; });
+        if (pass_begin == pass_end)
+            return;
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBufferID);
+
+        // Nothing is assumed to be bound when a pass starts, the caller may have touched any state in between
+        Shader* current_shader = nullptr;
+        Material* current_material = nullptr;
+        const VertexArray* current_vertex_array = nullptr;
+        for (auto run = pass_begin; run != pass_end; run++) {
+            uint32_t texture_count = static_cast<uint32_t>(run->material->GetTextures().size());
+            // Every draw after the first in a run reuses all of its state
+            mStats.bindsElided += (run->count - 1) * (2 + texture_count);
+
+            bool shader_changed = run->shader != current_shader;
+            if (shader_changed) {
+                run->shader->Bind();
+                current_shader = run->shader;
+                mStats.programSwitches++;
+            } else {
+                mStats.bindsElided++;
+            }
+
+            // Sampler uniforms live in the program, so a new program needs the material set again
+            if (shader_changed || run->material != current_material) {
+                run->material->Bind(run->shader);
+                current_material = run->material;
+                mStats.materialBinds++;
+            } else {
+                mStats.bindsElided += texture_count;
+            }
+
+            if (run->vertexArray != current_vertex_array) {
+                run->vertexArray->Bind();
+                current_vertex_array = run->vertexArray;
+                mStats.vertexArrayBinds++;
+            } else {
+                mStats.bindsElided++;
+            }
+
+            const void* offset = reinterpret_cast<const void*>(mIndirectOffset + static_cast<size_t>(run->first) * sizeof(DrawElementsIndirectCommand));
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GetGLIndexType(run->indexType), offset, static_cast<GLsizei>(run->count), 0);
+            mStats.draws += run->count;
+            mStats.multiDraws++;
+        }
+
+        // The program and vertex array stay bound, GLState drops rebinding them in the next pass
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    void RenderQueue::merge(ThreadPool* pool) {
+        // Every list knows where it lands, so they can all be copied in at once
+        std::vector<uint32_t> offsets(mListCount + 1, 0);
+        for (uint32_t i = 0; i < mListCount; i++)
+            offsets[i + 1] = offsets[i] + mLists[i].GetCommandCount();
+        mCommands.resize(offsets[mListCount]);
+        mEntries.resize(offsets[mListCount]);
+
+        auto copy_lists = [this, &offsets](uint32_t, uint32_t begin, uint32_t end) {
+            for (uint32_t list = begin; list < end; list++) {
+                const DrawList& draws = mLists[list];
+                uint32_t offset = offsets[list];
+                std::copy(draws.mCommands.begin(), draws.mCommands.end(), mCommands.begin() + offset);
+                for (uint32_t i = 0; i < draws.mKeys.size(); i++)
+                    mEntries[offset + i] = { draws.mKeys[i], offset + i };
+            }
+        };
+        if (pool)
+            pool->ParallelFor(mListCount, 1, copy_lists);
+        else
+            copy_lists(0, 0, mListCount);
+    }
+
+    void RenderQueue::uploadIndirect(ThreadPool* pool) {
+        // Straight into mapped memory, the GPU reads the commands from where they were written
+        StreamAllocation allocation = StreamBuffer::Get().Allocate<DrawElementsIndirectCommand>(static_cast<uint32_t>(mEntries.size()));
+        auto* indirect = static_cast<DrawElementsIndirectCommand*>(allocation.data);
+        auto write_commands = [this, indirect](uint32_t, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                const DrawCommand& command = mCommands[mEntries[i].command];
+                indirect[i] = { command.indexCount, 1, command.firstIndex, static_cast<int32_t>(command.baseVertex), command.object };
+            }
+        };
+        if (pool)
+            pool->ParallelFor(static_cast<uint32_t>(mEntries.size()), PARALLEL_GRAIN, write_commands);
+        else
+            write_commands(0, 0, static_cast<uint32_t>(mEntries.size()));
+        mIndirectBufferID = allocation.buffer;
+        mIndirectOffset = allocation.offset;
+    }
+
+    void RenderQueue::buildRuns() {
+        mRuns.clear();
+        for (uint32_t i = 0; i < mEntries.size(); i++) {
+            const DrawCommand& command = mCommands[mEntries[i].command];
+            RenderPass pass = static_cast<RenderPass>(mEntries[i].key >> 60);
+            // A run ends at the first draw needing different state, it all goes out as one multi-draw
+            if (!mRuns.empty()) {
+                DrawRun& run = mRuns.back();
+                if (run.pass == pass && run.shader == command.shader && run.material == command.material &&
+                    run.vertexArray == command.vertexArray && run.indexType == command.indexType) {
+                    run.count++;
+                    continue;
+                }
+            }
+            mRuns.push_back({ command.shader, command.material, command.vertexArray, command.indexType, pass, i, 1 });
+        }
+    }
+
+    void RenderQueue::sort() {
+        // LSD radix sort over 8 bit digits, stable so equal keys keep their submission order
+        constexpr uint32_t DIGITS = sizeof(uint64_t);
+        std::array<std::array<uint32_t, 256>, DIGITS> histograms{};
+        for (const SortEntry& entry : mEntries) {
+            for (uint32_t digit = 0; digit < DIGITS; digit++)
+                histograms[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+        }
+
+        mScratch.resize(mEntries.size());
+        for (uint32_t digit = 0; digit < DIGITS; digit++) {
+            std::array<uint32_t, 256>& histogram = histograms[digit];
+
+            // A digit every key shares would only copy the array, mostly the pass and shader bits
+            uint32_t first_key_bucket = mEntries.empty() ? 0 : (mEntries[0].key >> (digit * 8)) & 0xFF;
+            if (histogram[first_key_bucket] == mEntries.size())
+                continue;
+
+            uint32_t offset = 0;
+            for (uint32_t& count : histogram) {
+                uint32_t bucket_count = count;
+                count = offset;
+                offset += bucket_count;
+            }
+            for (const SortEntry& entry : mEntries)
+                mScratch[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+            mEntries.swap(mScratch);
+        }
+    }
+
+}
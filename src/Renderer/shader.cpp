@@ -1,52 +1,146 @@
 #include <Renderer/shader.h>
+#include <Renderer/gl_state.h>
+#include <Renderer/program_cache.h>
+#include <Renderer/uniform_buffer.h>
+#include <hash.h>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <fstream>
-#include <sstream>
+#include <chrono>
 #include <iostream>
 
 namespace OGLR {
 
-    Shader::Shader(const std::string& filepath)
-    :mFilePath(filepath), mRendererID(0) {
-        ShaderSource source = ParseShader();
+    namespace {
+
+        const char* stageName(uint32_t type) {
+            switch (type) {
+                case GL_VERTEX_SHADER: return "VERTEX";
+                case GL_FRAGMENT_SHADER: return "FRAGMENT";
+                case GL_GEOMETRY_SHADER: return "GEOMETRY";
+                case GL_COMPUTE_SHADER: return "COMPUTE";
+                default: return "UNKNOWN";
+            }
+        }
+
+    }
+
+    Shader::Shader(const std::string& filepath, const ShaderDefines& defines)
+    :mRendererID(0), mID(mNextID++), mFilePath(filepath) {
+        mName = defines.empty() ? mFilePath : mFilePath + " [" + ShaderPreprocessor::DescribeDefines(defines) + "]";
+
+        // Block sizes shared with C++ come from uniform_buffer.h instead of being repeated in every file
+        ShaderDefines all_defines = {
+            { "MAX_DIR_LIGHTS", std::to_string(MAX_DIR_LIGHTS) },
+            { "MAX_POINT_LIGHTS", std::to_string(MAX_POINT_LIGHTS) }
+        };
+        all_defines.insert(all_defines.end(), defines.begin(), defines.end());
+
+        ShaderSource source;
+        if (!ShaderPreprocessor::Process(mFilePath, all_defines, source)) {
+            // An empty program, draws with it do nothing until the file is fixed and reloaded
+            mRendererID = glCreateProgram();
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed_ms = [&start]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+        uint64_t key = 0;
+        double compile_ms = 0.0;
+        std::string cache_path = ProgramCache::GetCachePath(mFilePath, ShaderPreprocessor::GetDefinesHash(defines));
+        if (ProgramCache::IsSupported()) {
+            key = ProgramCache::GetKey(source);
+            mRendererID = glCreateProgram();
+            if (ProgramCache::Load(cache_path, key, mRendererID, compile_ms)) {
+                double load_ms = elapsed_ms();
+                std::cout << "Shader " << mName << ": program binary loaded in " << load_ms << " ms, "
+                          << compile_ms - load_ms << " ms saved over compiling\n";
+                ReflectUniforms();
+                return;
+            }
+            // A program that failed to load a binary is left unlinked, start over with a fresh one
+            glDeleteProgram(mRendererID);
+        }
+
+        mRendererID = glCreateProgram();
+        bool linked = LinkFromSource(source, key != 0);
+        compile_ms = elapsed_ms();
+        if (linked && key != 0 && ProgramCache::Store(cache_path, key, mRendererID, compile_ms))
+            std::cout << "Shader " << mName << ": compiled in " << compile_ms << " ms, program binary cached\n";
+        ReflectUniforms();
+    }
+
+    bool Shader::LinkFromSource(const ShaderSource& source, bool retrievable) {
         uint32_t vertexID = 0;
         uint32_t fragmentID = 0;
         uint32_t geometryID = 0;
         uint32_t computeID = 0;
 
-        mRendererID = glCreateProgram();
+        if (retrievable)
+            glProgramParameteri(mRendererID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
         if (source.vertex.has_value())
-            vertexID = CompileAndLinkShader(source.vertex.value(), GL_VERTEX_SHADER);
+            vertexID = CompileAndLinkShader(source.vertex.value(), GL_VERTEX_SHADER, source.files);
         if (source.fragment.has_value())
-            fragmentID = CompileAndLinkShader(source.fragment.value(), GL_FRAGMENT_SHADER);
+            fragmentID = CompileAndLinkShader(source.fragment.value(), GL_FRAGMENT_SHADER, source.files);
         if (source.geometry.has_value())
-            geometryID = CompileAndLinkShader(source.geometry.value(), GL_GEOMETRY_SHADER);
+            geometryID = CompileAndLinkShader(source.geometry.value(), GL_GEOMETRY_SHADER, source.files);
         if (source.compute.has_value())
-            computeID = CompileAndLinkShader(source.compute.value(), GL_COMPUTE_SHADER);
+            computeID = CompileAndLinkShader(source.compute.value(), GL_COMPUTE_SHADER, source.files);
 
         glLinkProgram(mRendererID);
         glValidateProgram(mRendererID);
 
+        int success;
+        glGetProgramiv(mRendererID, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetProgramInfoLog(mRendererID, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED " << mName << "\n" << infoLog << std::endl;
+        }
+
         glDeleteShader(vertexID);
         glDeleteShader(fragmentID);
         glDeleteShader(geometryID);
         glDeleteShader(computeID);
+        return success;
     }
 
     Shader::~Shader() {
-        glUseProgram(0);
+        GLState::UseProgram(0);
         glDeleteProgram(mRendererID);
     }
 
 
     void Shader::Bind() {
-        glUseProgram(mRendererID);
+        GLState::UseProgram(mRendererID);
     }
 
     void Shader::UnBind() {
-        glUseProgram(0);
+        GLState::UseProgram(0);
+    }
+
+    void Shader::SetUniform(UniformHandle<glm::vec4> handle, const glm::vec4& value) {
+        glUniform4f(handle.location, value.x, value.y, value.z, value.w);
+    }
+
+    void Shader::SetUniform(UniformHandle<glm::vec3> handle, const glm::vec3& value) {
+        glUniform3f(handle.location, value.x, value.y, value.z);
+    }
+
+    void Shader::SetUniform(UniformHandle<float> handle, float value) {
+        glUniform1f(handle.location, value);
+    }
+
+    void Shader::SetUniform(UniformHandle<int> handle, int value) {
+        glUniform1i(handle.location, value);
+    }
+
+    void Shader::SetUniform(UniformHandle<glm::mat4> handle, const glm::mat4& value) {
+        glUniformMatrix4fv(handle.location, 1, false, glm::value_ptr(value));
+    }
+
+    void Shader::SetUniform(UniformHandle<glm::mat3> handle, const glm::mat3& value) {
+        glUniformMatrix3fv(handle.location, 1, false, glm::value_ptr(value));
     }
 
     void Shader::SetUniform4f(const std::string& name, const glm::vec4& value) {
@@ -80,60 +174,99 @@ namespace OGLR {
     }
 
     int Shader::GetUniformLocation(const std::string& name) {
-        int location = glGetUniformLocation(mRendererID, name.c_str());
-        return location;
-    }
-
-    const ShaderSource Shader::ParseShader() {
-        std::ifstream input_file(mFilePath);
-        std::string line;
-
-        ShaderType type = ShaderType::UNKNOWN;
-        // The following are used to store the source code of each shader type, it's not pretty but it works.
-        std::stringstream vertexSS;
-        std::stringstream fragmentSS;
-        std::stringstream geometrySS;
-        std::stringstream computeSS;
-
-        while (std::getline(input_file, line)) {
-            // If the line has the '#shader' figure out which stringstream we will write to
-            if (line.find("#shader") != std::string::npos) {
-                if (line.find("vertex") != std::string::npos)
-                    type = ShaderType::VERTEX;
-                else if (line.find("fragment") != std::string::npos)
-                    type = ShaderType::FRAGMENT;
-                else
-                    type = ShaderType::UNKNOWN;
-
-                continue;
-            }
-            // Write to the stringstream of the current shader type source code
-            switch(type) {
-                case ShaderType::VERTEX:
-                    vertexSS << line << "\n";
-                    break;
-                case ShaderType::FRAGMENT:
-                    fragmentSS << line << "\n";
-                    break;
-                default:
-                    std::cout << "We don't support that shader yet" << std::endl;
+        // Every call through the string API means the caller built a std::string for the name
+        mStats.stringAllocations++;
+        return FindUniformLocation(name);
+    }
+
+    int32_t Shader::FindUniformLocation(std::string_view name) const {
+        mStats.locationLookups++;
+        if (mUniformTable.empty())
+            return -1;
+
+        uint64_t hash = HashString(name) | 1;
+        size_t mask = mUniformTable.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const UniformSlot& slot = mUniformTable[i];
+            if (slot.hash == hash)
+                return slot.location;
+            if (slot.hash == 0)
+                return -1;
+        }
+    }
+
+    void Shader::ReflectUniforms() {
+        // Shared blocks go to fixed binding points so one buffer bind serves every program
+        for (const UniformBlockName& block : UNIFORM_BLOCK_NAMES) {
+            uint32_t index = glGetUniformBlockIndex(mRendererID, block.name);
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(mRendererID, index, block.binding);
+        }
+        for (const UniformBlockName& block : STORAGE_BLOCK_NAMES) {
+            uint32_t index = glGetProgramResourceIndex(mRendererID, GL_SHADER_STORAGE_BLOCK, block.name);
+            if (index != GL_INVALID_INDEX)
+                glShaderStorageBlockBinding(mRendererID, index, block.binding);
+        }
+
+        int uniform_count = 0;
+        int max_name_length = 0;
+        glGetProgramiv(mRendererID, GL_ACTIVE_UNIFORMS, &uniform_count);
+        glGetProgramiv(mRendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+        struct Uniform {
+            std::string name;
+            int size;
+        };
+        std::vector<Uniform> uniforms;
+        std::string name(static_cast<size_t>(max_name_length) + 1, '\0');
+        size_t entry_count = 0;
+        for (int i = 0; i < uniform_count; i++) {
+            int length = 0, size = 0;
+            uint32_t type = 0;
+            glGetActiveUniform(mRendererID, static_cast<uint32_t>(i), static_cast<int>(name.size()), &length, &size, &type, name.data());
+            uniforms.push_back({ name.substr(0, static_cast<size_t>(length)), size });
+            entry_count += static_cast<size_t>(size) + 1;
+        }
+
+        // Keep the table at most half full so probe chains stay short
+        size_t capacity = 16;
+        while (capacity < entry_count * 2)
+            capacity *= 2;
+        mUniformTable.assign(capacity, {});
+
+        for (const Uniform& uniform : uniforms) {
+            int32_t location = glGetUniformLocation(mRendererID, uniform.name.c_str());
+            if (location == -1)
+                continue; // Uniform block members have no location
+            InsertUniform(uniform.name, location);
+
+            // Arrays are reported as "name[0]", make "name" and every "name[i]" resolvable too
+            if (uniform.name.ends_with("[0]")) {
+                std::string base = uniform.name.substr(0, uniform.name.size() - 3);
+                InsertUniform(base, location);
+                for (int element = 1; element < uniform.size; element++) {
+                    std::string element_name = base + '[' + std::to_string(element) + ']';
+                    InsertUniform(element_name, glGetUniformLocation(mRendererID, element_name.c_str()));
+                }
             }
         }
-        // If the string of the source code of a type is not empty store it and return it
-        ShaderSource shader_src;
-        if (!vertexSS.str().empty())
-            shader_src.vertex = vertexSS.str();
-        if (!fragmentSS.str().empty())
-            shader_src.fragment = fragmentSS.str();
-        if (!geometrySS.str().empty())
-            shader_src.geometry = geometrySS.str();
-        if (!computeSS.str().empty())
-            shader_src.compute = computeSS.str();
-        return shader_src;
     }
 
+    void Shader::InsertUniform(std::string_view name, int32_t location) {
+        // The low bit is forced on so a real hash is never 0, which marks empty slots
+        uint64_t hash = HashString(name) | 1;
+        size_t mask = mUniformTable.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            UniformSlot& slot = mUniformTable[i];
+            if (slot.hash == 0 || slot.hash == hash) {
+                slot.hash = hash;
+                slot.location = location;
+                return;
+            }
+        }
+    }
 
-    uint32_t Shader::CompileAndLinkShader(const std::string& source, uint32_t type) {
+    uint32_t Shader::CompileAndLinkShader(const std::string& source, uint32_t type, const std::vector<std::string>& files) {
         uint32_t id = glCreateShader(type);
         const char* src = source.c_str();
         glShaderSource(id, 1, &src, nullptr);
@@ -145,17 +278,14 @@ namespace OGLR {
         glGetShaderiv(id, GL_COMPILE_STATUS, &success);
         if (!success) {
             glGetShaderInfoLog(id, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+            std::cout << "ERROR::SHADER::" << stageName(type) << "::COMPILATION_FAILED " << mName << "\n" << infoLog;
+            // Errors read "file:line" with the file as an index, see the #line directives ShaderPreprocessor writes
+            for (size_t i = 0; i < files.size(); i++)
+                std::cout << "  " << i << ": " << files[i] << '\n';
+            std::cout << std::endl;
         }
 
         glAttachShader(mRendererID, id);
-
-        // check for linking errors
-        glGetShaderiv(mRendererID, GL_LINK_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(mRendererID, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        }
         return id;
     }
 }
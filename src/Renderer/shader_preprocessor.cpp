@@ -0,0 +1,177 @@
+#include <Renderer/shader_preprocessor.h>
+#include <hash.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+namespace OGLR {
+
+    namespace {
+
+        struct Stage {
+            std::stringstream text;
+            // Normalized paths already pasted into this stage
+            std::vector<std::string> included;
+            bool versioned = false;
+        };
+
+        std::string_view trimStart(std::string_view line) {
+            size_t start = line.find_first_not_of(" \t");
+            return start == std::string_view::npos ? std::string_view() : line.substr(start);
+        }
+
+        ShaderType parseStage(std::string_view name) {
+            name = trimStart(name);
+            name = name.substr(0, name.find_first_of(" \t\r"));
+            if (name == "vertex")
+                return ShaderType::VERTEX;
+            if (name == "fragment")
+                return ShaderType::FRAGMENT;
+            if (name == "geometry")
+                return ShaderType::GEOMETRY;
+            if (name == "compute")
+                return ShaderType::COMPUTE;
+            return ShaderType::UNKNOWN;
+        }
+
+        uint32_t fileIndex(std::vector<std::string>& files, const std::string& path) {
+            auto it = std::find(files.begin(), files.end(), path);
+            if (it != files.end())
+                return static_cast<uint32_t>(it - files.begin());
+            files.push_back(path);
+            return static_cast<uint32_t>(files.size() - 1);
+        }
+
+        bool appendFile(const std::string& path, uint32_t file_index, std::istream& input, Stage& stage,
+                        const ShaderDefines& defines, std::vector<std::string>& files);
+
+        // Writes one line of a stage to its text, expanding #include and placing the defines after #version
+        bool appendLine(const std::string& line, const std::string& path, uint32_t file_index, uint32_t line_number,
+                        Stage& stage, const ShaderDefines& defines, std::vector<std::string>& files) {
+            std::string_view directive = trimStart(line);
+
+            if (directive.starts_with("#version") && !stage.versioned) {
+                stage.text << line << '\n';
+                for (const ShaderDefine& define : defines)
+                    stage.text << "#define " << define.name << ' ' << define.value << '\n';
+                stage.text << "#line " << line_number + 1 << ' ' << file_index << '\n';
+                stage.versioned = true;
+                return true;
+            }
+
+            if (!directive.starts_with("#include")) {
+                stage.text << line << '\n';
+                return true;
+            }
+
+            size_t open = directive.find('"');
+            size_t close = open == std::string_view::npos ? open : directive.find('"', open + 1);
+            if (close == std::string_view::npos) {
+                std::cerr << "ERROR::SHADER::PREPROCESS:: " << path << ':' << line_number << " expected #include \"path\"\n";
+                return false;
+            }
+            std::string_view name = directive.substr(open + 1, close - open - 1);
+            std::string include_path = (std::filesystem::path(path).parent_path() / name).lexically_normal().generic_string();
+
+            // Once per stage, which also stops include cycles
+            if (std::find(stage.included.begin(), stage.included.end(), include_path) == stage.included.end()) {
+                stage.included.push_back(include_path);
+                std::ifstream include_file(include_path);
+                if (!include_file) {
+                    std::cerr << "ERROR::SHADER::PREPROCESS:: " << path << ':' << line_number << " couldn't open " << include_path << '\n';
+                    return false;
+                }
+                uint32_t include_index = fileIndex(files, include_path);
+                stage.text << "#line 1 " << include_index << '\n';
+                if (!appendFile(include_path, include_index, include_file, stage, defines, files))
+                    return false;
+            }
+            stage.text << "#line " << line_number + 1 << ' ' << file_index << '\n';
+            return true;
+        }
+
+        bool appendFile(const std::string& path, uint32_t file_index, std::istream& input, Stage& stage,
+                        const ShaderDefines& defines, std::vector<std::string>& files) {
+            std::string line;
+            uint32_t line_number = 0;
+            while (std::getline(input, line)) {
+                line_number++;
+                if (trimStart(line).starts_with("#shader")) {
+                    std::cerr << "ERROR::SHADER::PREPROCESS:: " << path << ':' << line_number << " #shader in an included file\n";
+                    return false;
+                }
+                if (!appendLine(line, path, file_index, line_number, stage, defines, files))
+                    return false;
+            }
+            return true;
+        }
+
+    }
+
+    bool ShaderPreprocessor::Process(const std::string& filepath, const ShaderDefines& defines, ShaderSource& source) {
+        source = {};
+        std::ifstream input_file(filepath);
+        if (!input_file) {
+            std::cerr << "ERROR::SHADER::PREPROCESS:: couldn't open " << filepath << '\n';
+            return false;
+        }
+        source.files.push_back(filepath);
+
+        // Indexed by ShaderType - 1
+        Stage stages[4];
+        ShaderType type = ShaderType::UNKNOWN;
+        std::string line;
+        uint32_t line_number = 0;
+        while (std::getline(input_file, line)) {
+            line_number++;
+            std::string_view directive = trimStart(line);
+            if (directive.starts_with("#shader")) {
+                type = parseStage(directive.substr(7));
+                if (type == ShaderType::UNKNOWN) {
+                    std::cerr << "ERROR::SHADER::PREPROCESS:: " << filepath << ':' << line_number << " unknown stage in " << directive << '\n';
+                    return false;
+                }
+                continue;
+            }
+            // Anything before the first #shader belongs to no stage
+            if (type == ShaderType::UNKNOWN)
+                continue;
+            if (!appendLine(line, filepath, 0, line_number, stages[static_cast<int>(type) - 1], defines, source.files))
+                return false;
+        }
+
+        std::optional<std::string>* outputs[] = { &source.vertex, &source.fragment, &source.geometry, &source.compute };
+        for (int stage = 0; stage < 4; stage++) {
+            std::string text = stages[stage].text.str();
+            if (!text.empty())
+                *outputs[stage] = std::move(text);
+        }
+        return true;
+    }
+
+    uint64_t ShaderPreprocessor::GetDefinesHash(const ShaderDefines& defines) {
+        if (defines.empty())
+            return 0;
+        uint64_t hash = FNV_OFFSET_BASIS;
+        for (const ShaderDefine& define : defines)
+            hash = HashString("\n", HashString(define.value, HashString("=", HashString(define.name, hash))));
+        return hash;
+    }
+
+    std::string ShaderPreprocessor::DescribeDefines(const ShaderDefines& defines) {
+        std::string description;
+        for (const ShaderDefine& define : defines) {
+            if (!description.empty())
+                description += ' ';
+            description += define.name;
+            if (!define.value.empty())
+                description += '=' + define.value;
+        }
+        return description;
+    }
+
+}
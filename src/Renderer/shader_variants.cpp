@@ -0,0 +1,12 @@
+#include <Renderer/shader_variants.h>
+
+namespace OGLR {
+
+    Shader* ShaderVariants::Get(const ShaderDefines& defines) {
+        std::unique_ptr<Shader>& variant = mVariants[ShaderPreprocessor::GetDefinesHash(defines)];
+        if (!variant)
+            variant = std::make_unique<Shader>(mFilePath, defines);
+        return variant.get();
+    }
+
+}
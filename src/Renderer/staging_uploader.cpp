@@ -0,0 +1,62 @@
+#include <Renderer/staging_uploader.h>
+#include <Renderer/stream_buffer.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace OGLR {
+
+    void StagingUploader::BeginFrame() {
+        mLastStats = mStats;
+        mStats = {};
+        mRemaining = mFrameBudget;
+    }
+
+    uint32_t StagingUploader::CopyToBuffer(uint32_t buffer, uint32_t offset, const void* data, uint32_t size) {
+        uint32_t copy_size = std::min(size, mRemaining);
+        if (copy_size == 0)
+            return 0;
+
+        StreamAllocation staging = StreamBuffer::Get().Allocate(copy_size);
+        std::memcpy(staging.data, data, copy_size);
+        glCopyNamedBufferSubData(staging.buffer, buffer, staging.offset, offset, copy_size);
+
+        mRemaining -= copy_size;
+        mStats.bytesUploaded += copy_size;
+        mStats.bufferCopies++;
+        return copy_size;
+    }
+
+    uint32_t StagingUploader::UploadTextureRows(const TextureLevelUpload& level, uint32_t first_row) {
+        uint32_t rows = std::min(level.GetRowCount() - first_row, mRemaining / level.rowSize);
+        if (rows == 0) {
+            if (mRemaining < mFrameBudget || first_row == level.GetRowCount())
+                return 0;
+            rows = 1;
+        }
+
+        uint32_t size = rows * level.rowSize;
+        StreamAllocation staging = StreamBuffer::Get().Allocate(size);
+        std::memcpy(staging.data, level.data + static_cast<size_t>(first_row) * level.rowSize, size);
+
+        // With an unpack buffer bound the pointer argument is an offset into it
+        const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(staging.offset));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+        if (level.compressed) {
+            uint32_t y = first_row * 4;
+            uint32_t height = std::min(rows * 4, level.height - y);
+            glCompressedTextureSubImage2D(level.texture, level.level, 0, y, level.width, height, level.format, size, offset);
+        } else {
+            glTextureSubImage2D(level.texture, level.level, 0, first_row, level.width, rows, level.format, level.type, offset);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        mRemaining -= std::min(size, mRemaining);
+        mStats.bytesUploaded += size;
+        mStats.textureCopies++;
+        return rows;
+    }
+
+}
@@ -0,0 +1,116 @@
+#include <Renderer/stream_buffer.h>
+#include <profiler.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace OGLR {
+
+    namespace {
+
+        const GLbitfield STREAM_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    }
+
+    StreamBuffer::StreamBuffer(uint32_t frame_size) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        mUniformAlignment = std::max(alignment, 4);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        mStorageAlignment = std::max(alignment, 4);
+
+        createBuffer(frame_size);
+        mCurrent = this;
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        for (GLsync& fence : mFences) {
+            if (fence)
+                glDeleteSync(fence);
+        }
+        for (RetiredBuffer& retired : mRetired) {
+            glDeleteSync(retired.fence);
+            glDeleteBuffers(1, &retired.buffer);
+        }
+        glDeleteBuffers(1, &mBufferID);
+        if (mCurrent == this)
+            mCurrent = nullptr;
+    }
+
+    void StreamBuffer::BeginFrame() {
+        OGLR_PROFILE_ZONE("StreamBuffer::BeginFrame");
+        mFrame = (mFrame + 1) % FRAMES;
+        mCursor = 0;
+        if (mFences[mFrame] && waitFence(mFences[mFrame]))
+            mStats.fenceStalls++;
+
+        // Retired in order, so the first one still in use ends the scan
+        auto done = std::find_if(mRetired.begin(), mRetired.end(), [](const RetiredBuffer& retired) {
+            return glClientWaitSync(retired.fence, 0, 0) == GL_TIMEOUT_EXPIRED;
+        });
+        for (auto it = mRetired.begin(); it != done; it++) {
+            glDeleteSync(it->fence);
+            glDeleteBuffers(1, &it->buffer);
+        }
+        mRetired.erase(mRetired.begin(), done);
+    }
+
+    void StreamBuffer::EndFrame() {
+        mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        uint32_t total_grows = mLastStats.totalGrows + mStats.grows;
+        mLastStats = mStats;
+        mLastStats.totalGrows = total_grows;
+        mLastStats.bufferSize = static_cast<uint64_t>(mFrameSize) * FRAMES;
+        mStats = {};
+    }
+
+    StreamAllocation StreamBuffer::Allocate(uint32_t size, uint32_t alignment) {
+        uint32_t offset = (mCursor + alignment - 1) / alignment * alignment;
+        if (offset + size > mFrameSize) {
+            // Everything streamed so far stays where it is, the old buffer is deleted once the GPU passed this point
+            mRetired.push_back({ mBufferID, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+            for (GLsync& fence : mFences) {
+                if (fence)
+                    glDeleteSync(fence);
+                fence = nullptr;
+            }
+            createBuffer(std::max(mFrameSize * 2, size + alignment));
+            mStats.grows++;
+            offset = 0;
+        }
+        mCursor = offset + size;
+        mStats.bytesStreamed += size;
+        mStats.allocations++;
+
+        uint32_t frame_offset = mFrame * mFrameSize + offset;
+        return { mMapped + frame_offset, mBufferID, frame_offset, size };
+    }
+
+    void StreamBuffer::createBuffer(uint32_t frame_size) {
+        mFrameSize = frame_size;
+        glCreateBuffers(1, &mBufferID);
+        glNamedBufferStorage(mBufferID, static_cast<GLsizeiptr>(mFrameSize) * FRAMES, nullptr, STREAM_FLAGS);
+        mMapped = static_cast<uint8_t*>(glMapNamedBufferRange(mBufferID, 0, static_cast<GLsizeiptr>(mFrameSize) * FRAMES, STREAM_FLAGS));
+        mCursor = 0;
+    }
+
+    bool StreamBuffer::waitFence(GLsync& fence) {
+        bool stalled = false;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            stalled = true;
+            auto start = std::chrono::steady_clock::now();
+            // Flushing once makes sure the fence gets submitted, after that plain waits are enough
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            do {
+                result = glClientWaitSync(fence, flags, 1000000);
+                flags = 0;
+            } while (result == GL_TIMEOUT_EXPIRED);
+            mStats.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+        return stalled;
+    }
+
+}
@@ -0,0 +1,252 @@
+#include <Renderer/texture_cache.h>
+#include <Renderer/staging_uploader.h>
+#include <hash.h>
+#include <profiler.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace OGLR {
+
+    namespace {
+
+        uint32_t formatFromComponents(uint32_t components) {
+            switch (components) {
+                case 1: return GL_RED;
+                case 2: return GL_RG;
+                case 3: return GL_RGB;
+                default: return GL_RGBA;
+            }
+        }
+
+        uint32_t sizedFormatFromComponents(uint32_t components) {
+            switch (components) {
+                case 1: return GL_R8;
+                case 2: return GL_RG8;
+                case 3: return GL_RGB8;
+                default: return GL_RGBA8;
+            }
+        }
+
+        TextureLevelUpload describeLevel(const DecodedImage& image, uint32_t texture, uint32_t level) {
+            TextureLevelUpload upload;
+            upload.texture = texture;
+            upload.level = level;
+            if (image.IsCompressed()) {
+                const CompressedLevel& source = image.compressed.levels[level];
+                upload.width = source.width;
+                upload.height = source.height;
+                upload.format = image.compressed.GetGLFormat();
+                upload.compressed = true;
+                upload.data = image.compressed.data.data() + source.offset;
+                upload.rowSize = static_cast<uint32_t>(source.size / upload.GetRowCount());
+            } else {
+                upload.width = image.width;
+                upload.height = image.height;
+                upload.format = formatFromComponents(image.components);
+                upload.type = GL_UNSIGNED_BYTE;
+                upload.data = image.pixels;
+                upload.rowSize = image.width * image.components;
+            }
+            return upload;
+        }
+
+    }
+
+    TextureCache& TextureCache::Get() {
+        static TextureCache cache;
+        return cache;
+    }
+
+    std::string TextureCache::NormalizePath(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    TextureHandle TextureCache::Acquire(const std::string& path, bool normal_map) {
+        std::string normalized = NormalizePath(path);
+        uint64_t key = HashString(normalized);
+
+        auto it = mEntries.find(key);
+        if (it != mEntries.end()) {
+            if (it->second.path == normalized)
+                return it->second.texture.lock();
+            // Two paths hashing the same is astronomically rare, don't cache the newcomer
+            std::cerr << "ERROR::TEXTURE_CACHE:: hash collision between " << it->second.path << " and " << normalized << '\n';
+            return std::make_shared<Texture2D>(Texture2D::CreatePlaceholder(normalized));
+        }
+
+        Texture2D* texture = new Texture2D(Texture2D::CreatePlaceholder(normalized));
+        TextureHandle handle(texture, Release{ this, key });
+
+        Entry entry;
+        entry.path = normalized;
+        entry.texture = handle;
+        entry.rawTexture = texture;
+        entry.memorySize = texture->GetMemorySize();
+        mMemoryUsage += entry.memorySize;
+        mEntries.emplace(key, std::move(entry));
+
+        // Evicted while still loading, the image in flight goes into the new entry
+        if (isInFlight(key))
+            return handle;
+        if (mCompression == Compression::Unknown)
+            SetCompressionEnabled(Texture2D::SupportsBlockCompression());
+        mRequests.emplace(mLoader.Request(normalized, mCompression == Compression::Enabled, normal_map), key);
+        return handle;
+    }
+
+    void TextureCache::Update() {
+        if (mLoader.GetPendingCount() == 0 && !mUpload)
+            return;
+        OGLR_PROFILE_ZONE("TextureCache::Update");
+        auto start = std::chrono::steady_clock::now();
+
+        // One image at a time, the next one is only taken while the budget has room left
+        while (StagingUploader::GetRemaining() > 0) {
+            if (!mUpload) {
+                uint32_t pending = mLoader.GetPendingCount();
+                mLoader.Poll([this](DecodedImage& image) { return beginUpload(image); }, 1,
+                             [this](const DecodedImage& image) { failUpload(image); });
+                if (mLoader.GetPendingCount() == pending)
+                    break;
+                continue;
+            }
+            if (!continueUpload())
+                break;
+        }
+        mUploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Requests whose image failed to decode are done too, they keep the placeholder
+        if (GetPendingCount() == 0) {
+            mRequests.clear();
+            reportLoadTimes();
+        }
+    }
+
+    bool TextureCache::beginUpload(DecodedImage& image) {
+        auto request = mRequests.find(image.request);
+        if (request == mRequests.end())
+            return false;
+        uint64_t key = request->second;
+        mRequests.erase(request);
+
+        // Every handle may have been dropped while the image was decoding
+        if (mEntries.find(key) == mEntries.end())
+            return false;
+
+        PendingUpload& upload = mUpload.emplace();
+        upload.key = key;
+        upload.image = std::move(image);
+
+        uint32_t internal_format;
+        if (upload.image.IsCompressed()) {
+            upload.levelCount = static_cast<uint32_t>(upload.image.compressed.levels.size());
+            internal_format = upload.image.compressed.GetGLFormat();
+        } else {
+            // Only level 0 is uploaded, the rest is generated once it is complete
+            upload.levelCount = static_cast<uint32_t>(std::bit_width(std::max(upload.image.width, upload.image.height)));
+            internal_format = sizedFormatFromComponents(upload.image.components);
+        }
+        glCreateTextures(GL_TEXTURE_2D, 1, &upload.texture);
+        glTextureStorage2D(upload.texture, upload.levelCount, internal_format, upload.image.width, upload.image.height);
+        glTextureParameteri(upload.texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(upload.texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureParameteri(upload.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(upload.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return true;
+    }
+
+    void TextureCache::failUpload(const DecodedImage& image) {
+        auto request = mRequests.find(image.request);
+        if (request == mRequests.end())
+            return;
+        auto it = mEntries.find(request->second);
+        if (it != mEntries.end())
+            it->second.pending = false;
+        mRequests.erase(request);
+    }
+
+    bool TextureCache::IsPending(const TextureHandle& texture) const {
+        // Placeholders handed out on a hash collision aren't cached and never load
+        const Release* release = std::get_deleter<Release>(texture);
+        if (!release)
+            return false;
+        auto it = mEntries.find(release->key);
+        return it != mEntries.end() && it->second.rawTexture == texture.get() && it->second.pending;
+    }
+
+    bool TextureCache::isInFlight(uint64_t key) const {
+        if (mUpload && mUpload->key == key)
+            return true;
+        return std::any_of(mRequests.begin(), mRequests.end(), [key](const auto& request) { return request.second == key; });
+    }
+
+    bool TextureCache::continueUpload() {
+        PendingUpload& upload = *mUpload;
+        DecodedImage& image = upload.image;
+        auto it = mEntries.find(upload.key);
+        if (it == mEntries.end()) {
+            glDeleteTextures(1, &upload.texture);
+            TextureLoader::FreeImage(image);
+            mUpload.reset();
+            return true;
+        }
+
+        uint32_t level_count = image.IsCompressed() ? upload.levelCount : 1;
+        while (upload.level < level_count) {
+            TextureLevelUpload level = describeLevel(image, upload.texture, upload.level);
+            uint32_t rows = StagingUploader::UploadTextureRows(level, upload.row);
+            if (rows == 0)
+                return false;
+            upload.row += rows;
+            if (upload.row == level.GetRowCount()) {
+                upload.level++;
+                upload.row = 0;
+            }
+        }
+        if (!image.IsCompressed())
+            glGenerateTextureMipmap(upload.texture);
+
+        TextureSpecs specs;
+        specs.path = image.path;
+        specs.width = image.width;
+        specs.height = image.height;
+        specs.format = image.IsCompressed() ? image.compressed.GetGLFormat() : formatFromComponents(image.components);
+
+        Entry& entry = it->second;
+        entry.pending = false;
+        entry.rawTexture->Adopt(upload.texture, specs, image.IsCompressed() ? image.compressed.GetMemorySize() : 0);
+        mMemoryUsage -= entry.memorySize;
+        entry.memorySize = entry.rawTexture->GetMemorySize();
+        mMemoryUsage += entry.memorySize;
+        mUploadedBytes += entry.memorySize;
+
+        TextureLoader::FreeImage(image);
+        mUpload.reset();
+        return true;
+    }
+
+    void TextureCache::release(uint64_t key, Texture2D* texture) {
+        auto it = mEntries.find(key);
+        if (it != mEntries.end() && it->second.rawTexture == texture) {
+            mMemoryUsage -= it->second.memorySize;
+            mEntries.erase(it);
+        }
+        delete texture;
+    }
+
+    void TextureCache::reportLoadTimes() const {
+        const TextureLoadStats& stats = mLoader.GetStats();
+        double speedup = stats.decodeWallMs > 0.0 ? stats.decodeCpuMs / stats.decodeWallMs : 0.0;
+        std::cout << "TextureCache: " << stats.uploaded << "/" << stats.requested << " textures decoded in "
+                  << stats.decodeWallMs << " ms wall (" << stats.decodeCpuMs << " ms cpu on " << stats.workers
+                  << " workers, " << speedup << "x), upload " << mUploadMs << " ms, "
+                  << GetTextureCount() << " textures resident using " << GetMemoryUsage() / (1024.0 * 1024.0) << " MB\n";
+    }
+
+}
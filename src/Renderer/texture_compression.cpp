@@ -0,0 +1,594 @@
+#include <Renderer/texture_compression.h>
+#include <mapped_file.h>
+#include <hash.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// S3TC is an extension everywhere but exposed by every desktop driver
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace OGLR {
+
+    namespace {
+
+        struct Color565 {
+            uint16_t packed;
+            float rgb[3];   // expanded back to 0-255, what the GPU will actually decode
+        };
+
+        Color565 quantize565(const float rgb[3]) {
+            int r = std::clamp(static_cast<int>(std::lround(rgb[0] * 31.0f / 255.0f)), 0, 31);
+            int g = std::clamp(static_cast<int>(std::lround(rgb[1] * 63.0f / 255.0f)), 0, 63);
+            int b = std::clamp(static_cast<int>(std::lround(rgb[2] * 31.0f / 255.0f)), 0, 31);
+            Color565 color;
+            color.packed = static_cast<uint16_t>((r << 11) | (g << 5) | b);
+            color.rgb[0] = static_cast<float>((r << 3) | (r >> 2));
+            color.rgb[1] = static_cast<float>((g << 2) | (g >> 4));
+            color.rgb[2] = static_cast<float>((b << 3) | (b >> 2));
+            return color;
+        }
+
+        void expand565(uint16_t packed, uint8_t rgb[3]) {
+            uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+            rgb[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+            rgb[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+            rgb[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        }
+
+        float distanceSquared(const float a[3], const float b[3]) {
+            float dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+            return dr * dr + dg * dg + db * db;
+        }
+
+        // Picks the nearest of the 4 palette entries for every texel, returns the summed squared error
+        float assignBC1Indices(const float pixels[16][3], const Color565& c0, const Color565& c1, uint32_t& indices) {
+            float palette[4][3];
+            for (int k = 0; k < 3; k++) {
+                palette[0][k] = c0.rgb[k];
+                palette[1][k] = c1.rgb[k];
+                palette[2][k] = (2.0f * c0.rgb[k] + c1.rgb[k]) / 3.0f;
+                palette[3][k] = (c0.rgb[k] + 2.0f * c1.rgb[k]) / 3.0f;
+            }
+
+            float error = 0.0f;
+            indices = 0;
+            for (int i = 0; i < 16; i++) {
+                uint32_t best = 0;
+                float best_distance = distanceSquared(pixels[i], palette[0]);
+                for (uint32_t p = 1; p < 4; p++) {
+                    float distance = distanceSquared(pixels[i], palette[p]);
+                    if (distance < best_distance) {
+                        best_distance = distance;
+                        best = p;
+                    }
+                }
+                indices |= best << (2 * i);
+                error += best_distance;
+            }
+            return error;
+        }
+
+        void writeBC1(uint16_t c0, uint16_t c1, uint32_t indices, uint8_t out[8]) {
+            out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+            out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+            for (int i = 0; i < 4; i++)
+                out[4 + i] = (indices >> (8 * i)) & 0xFF;
+        }
+
+        // Copies the 4x4 block at (bx, by), clamping to the edge for sizes that aren't a multiple of 4
+        void gatherBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t block[64]) {
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = std::min(by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+        }
+
+        // 2x2 box filter, normal maps are renormalized so the mips don't get shorter normals
+        std::vector<uint8_t> downsample(const std::vector<uint8_t>& src, uint32_t width, uint32_t height, bool normal_map) {
+            uint32_t dst_width = std::max(1u, width / 2);
+            uint32_t dst_height = std::max(1u, height / 2);
+            std::vector<uint8_t> dst(static_cast<size_t>(dst_width) * dst_height * 4);
+
+            for (uint32_t y = 0; y < dst_height; y++) {
+                for (uint32_t x = 0; x < dst_width; x++) {
+                    float sum[4] = {};
+                    for (uint32_t dy = 0; dy < 2; dy++) {
+                        for (uint32_t dx = 0; dx < 2; dx++) {
+                            uint32_t sx = std::min(x * 2 + dx, width - 1);
+                            uint32_t sy = std::min(y * 2 + dy, height - 1);
+                            const uint8_t* texel = &src[(static_cast<size_t>(sy) * width + sx) * 4];
+                            for (int c = 0; c < 4; c++)
+                                sum[c] += texel[c];
+                        }
+                    }
+                    uint8_t* out = &dst[(static_cast<size_t>(y) * dst_width + x) * 4];
+
+                    if (normal_map) {
+                        float n[3];
+                        for (int c = 0; c < 3; c++)
+                            n[c] = sum[c] / (4.0f * 127.5f) - 1.0f;
+                        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                        if (length > 1e-6f) {
+                            for (int c = 0; c < 3; c++)
+                                sum[c] = (n[c] / length + 1.0f) * 127.5f * 4.0f;
+                        }
+                    }
+                    for (int c = 0; c < 4; c++)
+                        out[c] = static_cast<uint8_t>(std::clamp(std::lround(sum[c] / 4.0f), 0l, 255l));
+                }
+            }
+            return dst;
+        }
+
+        void decodeBC1(const uint8_t* block, uint8_t rgba[64], bool force_four_colors) {
+            uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+            uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+            uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+            uint8_t palette[4][4];
+            expand565(c0, palette[0]);
+            expand565(c1, palette[1]);
+            palette[0][3] = palette[1][3] = 255;
+            for (int k = 0; k < 3; k++) {
+                if (c0 > c1 || force_four_colors) {
+                    palette[2][k] = static_cast<uint8_t>((2 * palette[0][k] + palette[1][k]) / 3);
+                    palette[3][k] = static_cast<uint8_t>((palette[0][k] + 2 * palette[1][k]) / 3);
+                } else {
+                    palette[2][k] = static_cast<uint8_t>((palette[0][k] + palette[1][k]) / 2);
+                    palette[3][k] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = (c0 > c1 || force_four_colors) ? 255 : 0;
+
+            for (int i = 0; i < 16; i++)
+                std::memcpy(rgba + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+        }
+
+        void decodeBC4(const uint8_t* block, uint8_t rgba[64], uint32_t channel) {
+            uint32_t a0 = block[0], a1 = block[1];
+            uint32_t palette[8] = { a0, a1 };
+            if (a0 > a1) {
+                for (uint32_t i = 2; i < 8; i++)
+                    palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+            } else {
+                for (uint32_t i = 2; i < 6; i++)
+                    palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+
+            uint64_t indices = 0;
+            for (int i = 0; i < 6; i++)
+                indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+            for (int i = 0; i < 16; i++)
+                rgba[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+        }
+
+    }
+
+    uint32_t CompressedTexture::GetGLFormat() const {
+        switch (format) {
+            case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        }
+        return 0;
+    }
+
+    uint32_t BlockCompressor::GetBlockSize(BlockFormat format) {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    BlockFormat BlockCompressor::SelectFormat(const std::string& path, const uint8_t* rgba, uint32_t width, uint32_t height,
+                                              bool normal_map) {
+        if (normal_map)
+            return BlockFormat::BC5;
+        std::string name = std::filesystem::path(path).stem().string();
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (name.ends_with("_ddn") || name.ends_with("_normal") || name.ends_with("_nrm"))
+            return BlockFormat::BC5;
+
+        size_t texels = static_cast<size_t>(width) * height;
+        for (size_t i = 0; i < texels; i++) {
+            if (rgba[i * 4 + 3] != 255)
+                return BlockFormat::BC3;
+        }
+        return BlockFormat::BC1;
+    }
+
+    void BlockCompressor::EncodeBC1Block(const uint8_t rgba[64], uint8_t out[8]) {
+        float pixels[16][3];
+        float mean[3] = {};
+        for (int i = 0; i < 16; i++) {
+            for (int k = 0; k < 3; k++) {
+                pixels[i][k] = rgba[i * 4 + k];
+                mean[k] += pixels[i][k] / 16.0f;
+            }
+        }
+
+        // Principal axis of the block's colors through a few power iterations on the covariance
+        float covariance[6] = {};
+        for (int i = 0; i < 16; i++) {
+            float d[3] = { pixels[i][0] - mean[0], pixels[i][1] - mean[1], pixels[i][2] - mean[2] };
+            covariance[0] += d[0] * d[0]; covariance[1] += d[0] * d[1]; covariance[2] += d[0] * d[2];
+            covariance[3] += d[1] * d[1]; covariance[4] += d[1] * d[2]; covariance[5] += d[2] * d[2];
+        }
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+            };
+            float length = std::max({ std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]) });
+            if (length < 1e-6f)
+                break;
+            for (int k = 0; k < 3; k++)
+                axis[k] = next[k] / length;
+        }
+
+        float min_t = 1e30f, max_t = -1e30f;
+        for (int i = 0; i < 16; i++) {
+            float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+            min_t = std::min(min_t, t);
+            max_t = std::max(max_t, t);
+        }
+        float axis_length_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float endpoints[2][3];
+        for (int k = 0; k < 3; k++) {
+            endpoints[0][k] = std::clamp(mean[k] + axis[k] * max_t / axis_length_sq, 0.0f, 255.0f);
+            endpoints[1][k] = std::clamp(mean[k] + axis[k] * min_t / axis_length_sq, 0.0f, 255.0f);
+        }
+
+        Color565 c0 = quantize565(endpoints[0]);
+        Color565 c1 = quantize565(endpoints[1]);
+        uint32_t indices;
+        float error = assignBC1Indices(pixels, c0, c1, indices);
+
+        // One least squares pass refitting the endpoints to the chosen indices
+        const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+        for (int i = 0; i < 16; i++) {
+            float alpha = weights[(indices >> (2 * i)) & 3];
+            float beta = 1.0f - alpha;
+            aa += alpha * alpha; ab += alpha * beta; bb += beta * beta;
+            for (int k = 0; k < 3; k++) {
+                ax[k] += alpha * pixels[i][k];
+                bx[k] += beta * pixels[i][k];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) > 1e-6f) {
+            float refined[2][3];
+            for (int k = 0; k < 3; k++) {
+                refined[0][k] = std::clamp((ax[k] * bb - bx[k] * ab) / determinant, 0.0f, 255.0f);
+                refined[1][k] = std::clamp((bx[k] * aa - ax[k] * ab) / determinant, 0.0f, 255.0f);
+            }
+            Color565 r0 = quantize565(refined[0]);
+            Color565 r1 = quantize565(refined[1]);
+            uint32_t refined_indices;
+            float refined_error = assignBC1Indices(pixels, r0, r1, refined_indices);
+            if (refined_error < error) {
+                c0 = r0;
+                c1 = r1;
+                indices = refined_indices;
+            }
+        }
+
+        // Four color mode needs c0 > c1, swapping the endpoints swaps 0<->1 and 2<->3
+        if (c0.packed < c1.packed) {
+            std::swap(c0, c1);
+            indices ^= 0x55555555;
+        } else if (c0.packed == c1.packed) {
+            indices = 0;
+        }
+        writeBC1(c0.packed, c1.packed, indices, out);
+    }
+
+    void BlockCompressor::EncodeBC4Block(const uint8_t rgba[64], uint32_t channel, uint8_t out[8]) {
+        uint32_t min_value = 255, max_value = 0;
+        for (int i = 0; i < 16; i++) {
+            min_value = std::min<uint32_t>(min_value, rgba[i * 4 + channel]);
+            max_value = std::max<uint32_t>(max_value, rgba[i * 4 + channel]);
+        }
+
+        out[0] = static_cast<uint8_t>(max_value);
+        out[1] = static_cast<uint8_t>(min_value);
+        uint64_t indices = 0;
+        if (max_value != min_value) {
+            // Eight value mode: a0 > a1
+            uint32_t palette[8] = { max_value, min_value };
+            for (uint32_t i = 2; i < 8; i++)
+                palette[i] = ((8 - i) * max_value + (i - 1) * min_value) / 7;
+
+            for (int i = 0; i < 16; i++) {
+                int value = rgba[i * 4 + channel];
+                uint64_t best = 0;
+                int best_distance = 256;
+                for (uint32_t p = 0; p < 8; p++) {
+                    int distance = std::abs(value - static_cast<int>(palette[p]));
+                    if (distance < best_distance) {
+                        best_distance = distance;
+                        best = p;
+                    }
+                }
+                indices |= best << (3 * i);
+            }
+        }
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+
+    void BlockCompressor::EncodeBC3Block(const uint8_t rgba[64], uint8_t out[16]) {
+        EncodeBC4Block(rgba, 3, out);
+        EncodeBC1Block(rgba, out + 8);
+    }
+
+    void BlockCompressor::EncodeBC5Block(const uint8_t rgba[64], uint8_t out[16]) {
+        EncodeBC4Block(rgba, 0, out);
+        EncodeBC4Block(rgba, 1, out + 8);
+    }
+
+    void BlockCompressor::DecodeBlock(BlockFormat format, const uint8_t* block, uint8_t rgba[64]) {
+        switch (format) {
+            case BlockFormat::BC1:
+                decodeBC1(block, rgba, false);
+                break;
+            case BlockFormat::BC3:
+                decodeBC1(block + 8, rgba, true);
+                decodeBC4(block, rgba, 3);
+                break;
+            case BlockFormat::BC5:
+                decodeBC4(block, rgba, 0);
+                decodeBC4(block + 8, rgba, 1);
+                for (int i = 0; i < 16; i++) {
+                    rgba[i * 4 + 2] = 0;
+                    rgba[i * 4 + 3] = 255;
+                }
+                break;
+        }
+    }
+
+    CompressedTexture BlockCompressor::Compress(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format, bool generate_mips) {
+        CompressedTexture texture;
+        texture.format = format;
+        texture.width = width;
+        texture.height = height;
+
+        uint32_t block_size = GetBlockSize(format);
+        std::vector<uint8_t> level_pixels(rgba, rgba + static_cast<size_t>(width) * height * 4);
+        uint32_t level_width = width, level_height = height;
+        while (true) {
+            uint32_t blocks_x = (level_width + 3) / 4;
+            uint32_t blocks_y = (level_height + 3) / 4;
+
+            CompressedLevel level;
+            level.width = level_width;
+            level.height = level_height;
+            level.offset = texture.data.size();
+            level.size = static_cast<uint64_t>(blocks_x) * blocks_y * block_size;
+            texture.data.resize(texture.data.size() + level.size);
+
+            uint8_t* out = texture.data.data() + level.offset;
+            uint8_t block[64];
+            for (uint32_t by = 0; by < blocks_y; by++) {
+                for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                    gatherBlock(level_pixels.data(), level_width, level_height, bx, by, block);
+                    switch (format) {
+                        case BlockFormat::BC1: EncodeBC1Block(block, out); break;
+                        case BlockFormat::BC3: EncodeBC3Block(block, out); break;
+                        case BlockFormat::BC5: EncodeBC5Block(block, out); break;
+                    }
+                    out += block_size;
+                }
+            }
+            texture.levels.push_back(level);
+
+            if (!generate_mips || (level_width == 1 && level_height == 1))
+                break;
+            level_pixels = downsample(level_pixels, level_width, level_height, format == BlockFormat::BC5);
+            level_width = std::max(1u, level_width / 2);
+            level_height = std::max(1u, level_height / 2);
+        }
+        return texture;
+    }
+
+    std::vector<uint8_t> BlockCompressor::Decompress(const CompressedTexture& texture, uint32_t level_index) {
+        const CompressedLevel& level = texture.levels[level_index];
+        std::vector<uint8_t> rgba(static_cast<size_t>(level.width) * level.height * 4);
+
+        uint32_t block_size = GetBlockSize(texture.format);
+        uint32_t blocks_x = (level.width + 3) / 4;
+        uint32_t blocks_y = (level.height + 3) / 4;
+        const uint8_t* block = texture.data.data() + level.offset;
+        uint8_t decoded[64];
+        for (uint32_t by = 0; by < blocks_y; by++) {
+            for (uint32_t bx = 0; bx < blocks_x; bx++, block += block_size) {
+                DecodeBlock(texture.format, block, decoded);
+                for (uint32_t y = 0; y < 4 && by * 4 + y < level.height; y++) {
+                    for (uint32_t x = 0; x < 4 && bx * 4 + x < level.width; x++) {
+                        size_t dst = (static_cast<size_t>(by * 4 + y) * level.width + bx * 4 + x) * 4;
+                        std::memcpy(&rgba[dst], decoded + (y * 4 + x) * 4, 4);
+                    }
+                }
+            }
+        }
+        return rgba;
+    }
+
+    double BlockCompressor::ComputePSNR(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height, uint32_t channels) {
+        double squared_error = 0.0;
+        size_t texels = static_cast<size_t>(width) * height;
+        for (size_t i = 0; i < texels; i++) {
+            for (uint32_t c = 0; c < channels; c++) {
+                double difference = static_cast<double>(a[i * 4 + c]) - b[i * 4 + c];
+                squared_error += difference * difference;
+            }
+        }
+        double mse = squared_error / (static_cast<double>(texels) * channels);
+        if (mse <= 0.0)
+            return INFINITY;
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    std::vector<uint8_t> BlockCompressor::ToRGBA(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t components) {
+        size_t texels = static_cast<size_t>(width) * height;
+        std::vector<uint8_t> rgba(texels * 4);
+        for (size_t i = 0; i < texels; i++) {
+            const uint8_t* src = pixels + i * components;
+            uint8_t* dst = &rgba[i * 4];
+            switch (components) {
+                case 1: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 255; break;
+                case 2: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = src[1]; break;
+                case 3: std::memcpy(dst, src, 3); dst[3] = 255; break;
+                default: std::memcpy(dst, src, 4); break;
+            }
+        }
+        return rgba;
+    }
+
+    namespace {
+
+        const uint8_t FILE_IDENTIFIER[12] = { 0xAB, 'O', 'G', 'L', 'R', 'T', 'E', 'X', 0xBB, '\r', '\n', 0x1A };
+        const uint64_t LEVEL_ALIGNMENT = 16;
+
+        struct FileHeader {
+            uint8_t identifier[12];
+            uint32_t version;
+            uint32_t glInternalFormat;
+            uint32_t blockFormat;
+            uint32_t width, height;
+            uint32_t levelCount;
+            uint32_t normalMap;
+            uint64_t sourceKey;
+        };
+
+        struct LevelIndex {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint32_t width, height;
+        };
+
+    }
+
+    uint64_t CompressedTextureFile::GetSourceKey(const std::string& source_path) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(source_path, error);
+        if (error)
+            return 0;
+        auto modified = std::filesystem::last_write_time(source_path, error);
+        if (error)
+            return 0;
+        int64_t ticks = modified.time_since_epoch().count();
+        uint64_t key = HashBytes(&size, sizeof(size));
+        return HashBytes(&ticks, sizeof(ticks), key);
+    }
+
+    bool CompressedTextureFile::Read(const std::string& path, uint64_t source_key, bool normal_map, CompressedTexture& texture) {
+        MappedFile file(path);
+        if (!file.IsOpen() || file.GetSize() < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, file.GetData(), sizeof(FileHeader));
+        if (std::memcmp(header.identifier, FILE_IDENTIFIER, sizeof(FILE_IDENTIFIER)) != 0 ||
+            header.version != VERSION || header.sourceKey != source_key || header.normalMap != normal_map)
+            return false;
+        if (header.blockFormat < static_cast<uint32_t>(BlockFormat::BC1) || header.blockFormat > static_cast<uint32_t>(BlockFormat::BC5) ||
+            header.levelCount == 0 || header.levelCount > 32 ||
+            file.GetSize() < sizeof(FileHeader) + header.levelCount * sizeof(LevelIndex)) {
+            std::cerr << "ERROR::COMPRESSED_TEXTURE:: corrupt file " << path << '\n';
+            return false;
+        }
+
+        texture.format = static_cast<BlockFormat>(header.blockFormat);
+        texture.width = header.width;
+        texture.height = header.height;
+        texture.levels.clear();
+        texture.data.clear();
+
+        const uint8_t* base = file.GetData();
+        for (uint32_t i = 0; i < header.levelCount; i++) {
+            LevelIndex index;
+            std::memcpy(&index, base + sizeof(FileHeader) + i * sizeof(LevelIndex), sizeof(LevelIndex));
+            if (index.byteOffset > file.GetSize() || index.byteLength > file.GetSize() - index.byteOffset) {
+                std::cerr << "ERROR::COMPRESSED_TEXTURE:: corrupt level index in " << path << '\n';
+                return false;
+            }
+            texture.levels.push_back({ index.width, index.height, texture.data.size(), index.byteLength });
+            texture.data.insert(texture.data.end(), base + index.byteOffset, base + index.byteOffset + index.byteLength);
+        }
+        return true;
+    }
+
+    bool CompressedTextureFile::Write(const std::string& path, uint64_t source_key, bool normal_map, const CompressedTexture& texture) {
+        FileHeader header{};
+        std::memcpy(header.identifier, FILE_IDENTIFIER, sizeof(FILE_IDENTIFIER));
+        header.version = VERSION;
+        header.glInternalFormat = texture.GetGLFormat();
+        header.blockFormat = static_cast<uint32_t>(texture.format);
+        header.width = texture.width;
+        header.height = texture.height;
+        header.levelCount = static_cast<uint32_t>(texture.levels.size());
+        header.normalMap = normal_map;
+        header.sourceKey = source_key;
+
+        // Like KTX2 the index lists level 0 first while the data runs from the smallest mip up
+        std::vector<LevelIndex> indices(texture.levels.size());
+        uint64_t offset = sizeof(FileHeader) + indices.size() * sizeof(LevelIndex);
+        for (size_t i = texture.levels.size(); i-- > 0;) {
+            offset = (offset + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+            indices[i] = { offset, texture.levels[i].size, texture.levels[i].width, texture.levels[i].height };
+            offset += texture.levels[i].size;
+        }
+
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::cerr << "ERROR::COMPRESSED_TEXTURE:: couldn't open " << temp_path << " for writing\n";
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+            out.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(LevelIndex)));
+            for (size_t i = texture.levels.size(); i-- > 0;) {
+                static const char zeros[LEVEL_ALIGNMENT] = {};
+                uint64_t position = static_cast<uint64_t>(out.tellp());
+                out.write(zeros, static_cast<std::streamsize>(indices[i].byteOffset - position));
+                out.write(reinterpret_cast<const char*>(texture.data.data() + texture.levels[i].offset),
+                          static_cast<std::streamsize>(texture.levels[i].size));
+            }
+            if (!out) {
+                std::cerr << "ERROR::COMPRESSED_TEXTURE:: failed writing " << temp_path << '\n';
+                out.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        std::remove(path.c_str());
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,140 @@
+#include <Renderer/texture_loader.h>
+#include <thread_pool.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <iostream>
+
+namespace OGLR {
+
+    TextureLoader::TextureLoader()
+        :mState(std::make_shared<SharedState>()) {
+        mStats.workers = ThreadPool::Get().GetThreadCount();
+    }
+
+    TextureLoader::~TextureLoader() {
+        if (!mState)
+            return;
+        // Whatever already finished decoding is never going to be uploaded, jobs still running see closed
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        for (DecodedImage& image : mState->finished)
+            FreeImage(image);
+        mState->finished.clear();
+        mState->closed = true;
+    }
+
+    uint32_t TextureLoader::Request(const std::string& path, bool compress, bool normal_map) {
+        if (mStats.requested == 0)
+            mFirstRequest = Clock::now();
+
+        uint32_t request = mNextRequest++;
+        mPending++;
+        mStats.requested++;
+
+        std::shared_ptr<SharedState> state = mState;
+        Clock::time_point epoch = mFirstRequest;
+        ThreadPool::Get().Submit([state, request, path, compress, normal_map, epoch]() {
+            Clock::time_point start = Clock::now();
+
+            DecodedImage image{ request, path, nullptr, 0, 0, 0, {} };
+            if (compress && LoadCompressed(path, image.compressed, nullptr, normal_map)) {
+                image.width = image.compressed.width;
+                image.height = image.compressed.height;
+            } else {
+                int width = 0, height = 0, components = 0;
+                image.pixels = stbi_load(path.c_str(), &width, &height, &components, 0);
+                image.width = static_cast<uint32_t>(width);
+                image.height = static_cast<uint32_t>(height);
+                image.components = static_cast<uint32_t>(components);
+            }
+
+            Clock::time_point end = Clock::now();
+            state->decodeCpuNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            int64_t end_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - epoch).count();
+            int64_t last = state->lastDecodeEndNs.load();
+            while (end_ns > last && !state->lastDecodeEndNs.compare_exchange_weak(last, end_ns));
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->closed)
+                FreeImage(image);
+            else
+                state->finished.push_back(std::move(image));
+        });
+        return request;
+    }
+
+    void TextureLoader::Poll(const std::function<bool(DecodedImage& image)>& on_ready, uint32_t max_uploads,
+                             const std::function<void(const DecodedImage& image)>& on_failed) {
+        for (uint32_t uploads = 0; uploads < max_uploads; uploads++) {
+            DecodedImage image;
+            {
+                std::lock_guard<std::mutex> lock(mState->mutex);
+                if (mState->finished.empty())
+                    break;
+                image = std::move(mState->finished.front());
+                mState->finished.pop_front();
+            }
+            mPending--;
+
+            if (!image.pixels && !image.IsCompressed()) {
+                std::cout << "Texture failed to load at path: " << image.path << '\n';
+                mStats.failed++;
+                if (on_failed)
+                    on_failed(image);
+                continue;
+            }
+
+            Clock::time_point start = Clock::now();
+            if (!on_ready(image))
+                FreeImage(image);
+            mStats.uploadMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            mStats.uploaded++;
+        }
+
+        mStats.decodeCpuMs = mState->decodeCpuNs.load() / 1e6;
+        mStats.decodeWallMs = mState->lastDecodeEndNs.load() / 1e6;
+    }
+
+    void TextureLoader::FreeImage(DecodedImage& image) {
+        if (image.pixels)
+            stbi_image_free(image.pixels);
+        image.pixels = nullptr;
+        image.compressed = {};
+    }
+
+    bool TextureLoader::LoadCompressed(const std::string& path, CompressedTexture& texture, double* psnr, bool normal_map) {
+        uint64_t source_key = CompressedTextureFile::GetSourceKey(path);
+        if (source_key == 0)
+            return false;
+        std::string container_path = CompressedTextureFile::GetPath(path);
+        if (CompressedTextureFile::Read(container_path, source_key, normal_map, texture))
+            return true;
+
+        if (!Compress(path, texture, psnr, normal_map))
+            return false;
+        CompressedTextureFile::Write(container_path, source_key, normal_map, texture);
+        return true;
+    }
+
+    bool TextureLoader::Compress(const std::string& path, CompressedTexture& texture, double* psnr, bool normal_map) {
+        int width = 0, height = 0, components = 0;
+        uint8_t* pixels = stbi_load(path.c_str(), &width, &height, &components, 0);
+        if (!pixels)
+            return false;
+
+        uint32_t w = static_cast<uint32_t>(width), h = static_cast<uint32_t>(height);
+        std::vector<uint8_t> rgba = BlockCompressor::ToRGBA(pixels, w, h, static_cast<uint32_t>(components));
+        stbi_image_free(pixels);
+
+        BlockFormat format = BlockCompressor::SelectFormat(path, rgba.data(), w, h, normal_map);
+        texture = BlockCompressor::Compress(rgba.data(), w, h, format);
+        if (psnr) {
+            std::vector<uint8_t> decoded = BlockCompressor::Decompress(texture);
+            uint32_t channels = format == BlockFormat::BC5 ? 2 : (format == BlockFormat::BC3 ? 4 : 3);
+            *psnr = BlockCompressor::ComputePSNR(rgba.data(), decoded.data(), w, h, channels);
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,146 @@
+#include <Renderer/uniform_buffer.h>
+#include <Renderer/stream_buffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace OGLR {
+
+    UniformBuffer::UniformBuffer(uint32_t size, uint32_t target)
+        :mTarget(target), mShadow(size, 0) {
+        glGenBuffers(1, &mRendererID);
+        glBindBuffer(mTarget, mRendererID);
+        glBufferData(mTarget, size, mShadow.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(mTarget, 0);
+    }
+
+    UniformBuffer::~UniformBuffer() {
+        glDeleteBuffers(1, &mRendererID);
+    }
+
+    void UniformBuffer::Write(uint32_t offset, const void* data, uint32_t size) {
+        if (std::memcmp(mShadow.data() + offset, data, size) == 0)
+            return;
+        std::memcpy(mShadow.data() + offset, data, size);
+        mDirtyBegin = std::min(mDirtyBegin, offset);
+        mDirtyEnd = std::max(mDirtyEnd, offset + size);
+    }
+
+    void UniformBuffer::Resize(uint32_t size) {
+        mShadow.resize(size, 0);
+        glBindBuffer(mTarget, mRendererID);
+        glBufferData(mTarget, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(mTarget, 0);
+        mDirtyBegin = 0;
+        mDirtyEnd = size;
+    }
+
+    void UniformBuffer::Flush() {
+        if (mDirtyBegin >= mDirtyEnd)
+            return;
+        glBindBuffer(mTarget, mRendererID);
+        glBufferSubData(mTarget, mDirtyBegin, mDirtyEnd - mDirtyBegin, mShadow.data() + mDirtyBegin);
+        glBindBuffer(mTarget, 0);
+        mUploadedBytes += mDirtyEnd - mDirtyBegin;
+        mDirtyBegin = UINT32_MAX;
+        mDirtyEnd = 0;
+    }
+
+    void UniformBuffer::BindBase(uint32_t binding) const {
+        glBindBufferBase(mTarget, binding, mRendererID);
+    }
+
+    void UniformBuffer::BindRange(uint32_t binding, uint32_t offset, uint32_t size) const {
+        glBindBufferRange(mTarget, binding, mRendererID, offset, size);
+    }
+
+    namespace {
+
+        const uint32_t INITIAL_OBJECT_CAPACITY = 256;
+
+    }
+
+    UniformBlocks::UniformBlocks()
+        :mLights(sizeof(LightUniforms)),
+         mObjects(sizeof(ObjectUniforms) * INITIAL_OBJECT_CAPACITY, GL_SHADER_STORAGE_BUFFER) {
+        mCurrent = this;
+    }
+
+    UniformBlocks::~UniformBlocks() {
+        if (mCurrent == this)
+            mCurrent = nullptr;
+    }
+
+    void UniformBlocks::SetFrame(const glm::mat4& view, const glm::mat4& proj) {
+        mFrame.view = view;
+        mFrame.proj = proj;
+        mFrame.viewProj = proj * view;
+    }
+
+    void UniformBlocks::SetLights(const std::vector<DirectionalLight>& directional_lights, const std::vector<PointLight>& point_lights, const glm::mat4& view) {
+        uint32_t dir_count = std::min<uint32_t>(static_cast<uint32_t>(directional_lights.size()), MAX_DIR_LIGHTS);
+        uint32_t point_count = std::min<uint32_t>(static_cast<uint32_t>(point_lights.size()), MAX_POINT_LIGHTS);
+
+        glm::ivec4 counts{ static_cast<int>(dir_count), static_cast<int>(point_count), 0, 0 };
+        mLights.Write(offsetof(LightUniforms, counts), counts);
+
+        glm::mat3 view_rotation = glm::mat3(view);
+        for (uint32_t i = 0; i < dir_count; i++) {
+            GPUDirectionalLight light{};
+            light.direction = glm::normalize(view_rotation * glm::normalize(directional_lights[i].direction));
+            light.color = directional_lights[i].color;
+            light.intensity = directional_lights[i].intensity;
+            mLights.Write(static_cast<uint32_t>(offsetof(LightUniforms, dirLights) + i * sizeof(GPUDirectionalLight)), light);
+        }
+        for (uint32_t i = 0; i < point_count; i++) {
+            GPUPointLight light{};
+            light.position = glm::vec3(view * glm::vec4(point_lights[i].position, 1.0f));
+            light.color = point_lights[i].color;
+            light.intensity = point_lights[i].intensity;
+            mLights.Write(static_cast<uint32_t>(offsetof(LightUniforms, pointLights) + i * sizeof(GPUPointLight)), light);
+        }
+    }
+
+    uint32_t UniformBlocks::AllocateObject() {
+        if (!mFreeObjects.empty()) {
+            uint32_t slot = mFreeObjects.back();
+            mFreeObjects.pop_back();
+            return slot;
+        }
+        uint32_t slot = mObjectCount++;
+        if (mObjectCount * sizeof(ObjectUniforms) > mObjects.GetSize())
+            mObjects.Resize(mObjects.GetSize() * 2);
+        SetObject(slot, glm::mat4(1.0f));
+        return slot;
+    }
+
+    void UniformBlocks::FreeObject(uint32_t slot) {
+        mFreeObjects.push_back(slot);
+    }
+
+    void UniformBlocks::SetObject(uint32_t slot, const glm::mat4& model, const VertexDequantization& dequantization) {
+        ObjectUniforms object;
+        object.model = model;
+        object.normalMatrix = glm::transpose(glm::inverse(model));
+        object.positionScale = glm::vec4(dequantization.positionScale, dequantization.octahedralNormals ? 1.0f : 0.0f);
+        object.positionOffset = glm::vec4(dequantization.positionOffset, 0.0f);
+        mObjects.Write(static_cast<uint32_t>(slot * sizeof(ObjectUniforms)), object);
+    }
+
+    void UniformBlocks::Flush() {
+        StreamAllocation frame = StreamBuffer::Get().Allocate(sizeof(FrameUniforms), StreamBuffer::Get().GetUniformAlignment());
+        std::memcpy(frame.data, &mFrame, sizeof(FrameUniforms));
+        mStreamedBytes += sizeof(FrameUniforms);
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BINDING, frame.buffer, frame.offset, frame.size);
+
+        mLights.Flush();
+        mObjects.Flush();
+        mLights.BindBase(LIGHT_BINDING);
+        mObjects.BindBase(OBJECT_BINDING);
+    }
+
+    uint64_t UniformBlocks::GetUploadedBytes() const {
+        return mStreamedBytes + mLights.GetUploadedBytes() + mObjects.GetUploadedBytes();
+    }
+
+}
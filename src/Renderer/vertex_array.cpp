@@ -1,4 +1,5 @@
 #include <Renderer/vertex_array.h>
+#include <Renderer/gl_state.h>
 
 #include <iostream>
 
@@ -17,6 +18,54 @@ namespace OGLR
                 mByteOffset += n * sizeof(float);
         }
 
+        template <>
+        void VertexLayout::Push<Half>(uint32_t n, bool normalized)
+        {
+                mElements.push_back({GL_HALF_FLOAT, static_cast<uint32_t>(n * sizeof(Half)), n, normalized });
+                mByteOffset += n * sizeof(Half);
+        }
+
+        // The integer types are read as floats, normalized maps them to [0, 1] or [-1, 1]
+        template <>
+        void VertexLayout::Push<int8_t>(uint32_t n, bool normalized)
+        {
+                mElements.push_back({GL_BYTE, static_cast<uint32_t>(n * sizeof(int8_t)), n, normalized });
+                mByteOffset += n * sizeof(int8_t);
+        }
+
+        template <>
+        void VertexLayout::Push<uint8_t>(uint32_t n, bool normalized)
+        {
+                mElements.push_back({GL_UNSIGNED_BYTE, static_cast<uint32_t>(n * sizeof(uint8_t)), n, normalized });
+                mByteOffset += n * sizeof(uint8_t);
+        }
+
+        template <>
+        void VertexLayout::Push<int16_t>(uint32_t n, bool normalized)
+        {
+                mElements.push_back({GL_SHORT, static_cast<uint32_t>(n * sizeof(int16_t)), n, normalized });
+                mByteOffset += n * sizeof(int16_t);
+        }
+
+        template <>
+        void VertexLayout::Push<uint16_t>(uint32_t n, bool normalized)
+        {
+                mElements.push_back({GL_UNSIGNED_SHORT, static_cast<uint32_t>(n * sizeof(uint16_t)), n, normalized });
+                mByteOffset += n * sizeof(uint16_t);
+        }
+
+        // n counts packed values, each one is a whole 4 component attribute
+        template <>
+        void VertexLayout::Push<Packed1010102>(uint32_t n, bool normalized)
+        {
+                if (n != 1) {
+                        std::cerr << "Packed1010102 attributes hold exactly one value\n";
+                        return;
+                }
+                mElements.push_back({GL_INT_2_10_10_10_REV, static_cast<uint32_t>(sizeof(Packed1010102)), 4, normalized });
+                mByteOffset += sizeof(Packed1010102);
+        }
+
         VertexArray::VertexArray()
         {
                 glGenVertexArrays(1, &mRendererID);
@@ -24,17 +73,18 @@ namespace OGLR
 
         VertexArray::~VertexArray()
         {
+                GLState::ForgetVertexArray(mRendererID);
                 glDeleteVertexArrays(1, &mRendererID);
         }
 
         void VertexArray::Bind() const
         {
-                glBindVertexArray(mRendererID);
+                GLState::BindVertexArray(mRendererID);
         }
 
         void VertexArray::UnBind() const
         {
-                glBindVertexArray(0);
+                GLState::BindVertexArray(0);
         }
 
 
@@ -3,10 +3,14 @@
 
 namespace OGLR {
 
-    VertexBuffer::VertexBuffer(const std::vector<Vertex>& buffer_data) {
+    VertexBuffer::VertexBuffer(const std::vector<Vertex>& buffer_data)
+    :VertexBuffer(buffer_data.data(), static_cast<uint32_t>(buffer_data.size())) {
+    }
+
+    VertexBuffer::VertexBuffer(const Vertex* data, uint32_t count) {
         glGenBuffers(1, &mRendererID);
         glBindBuffer(GL_ARRAY_BUFFER, mRendererID);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex)*buffer_data.size(), buffer_data.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex)*count, data, GL_STATIC_DRAW);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
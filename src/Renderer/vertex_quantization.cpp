@@ -0,0 +1,213 @@
+#include <Renderer/vertex_quantization.h>
+#include <Renderer/bounds.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace OGLR {
+
+    namespace {
+
+        int16_t toSnorm16(float value) {
+            return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        float fromSnorm16(int16_t value) {
+            return std::max(value / 32767.0f, -1.0f);
+        }
+
+        float signNotZero(float value) {
+            return value >= 0.0f ? 1.0f : -1.0f;
+        }
+
+    }
+
+    bool QuantizationError::IsWithinBounds() const {
+        return position <= positionBound &&
+               normalDegrees <= VertexQuantizer::NORMAL_ERROR_BOUND_DEGREES &&
+               texCoord <= VertexQuantizer::TEX_COORD_ERROR_BOUND;
+    }
+
+    // Round to nearest even, out of range values become infinity and tiny ones subnormals or zero
+    Half FloatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t exponent = (bits >> 23) & 0xFF;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if (exponent == 0xFF)
+            return { static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0)) };
+        int32_t half_exponent = static_cast<int32_t>(exponent) - 127 + 15;
+        if (half_exponent >= 31)
+            return { static_cast<uint16_t>(sign | 0x7C00) };
+        if (half_exponent <= 0) {
+            if (half_exponent < -10)
+                return { static_cast<uint16_t>(sign) };
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - half_exponent);
+            uint32_t half_mantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+                half_mantissa++;
+            return { static_cast<uint16_t>(sign | half_mantissa) };
+        }
+
+        // A carry out of the mantissa correctly bumps the exponent, up to infinity
+        uint32_t half = sign | (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            half++;
+        return { static_cast<uint16_t>(half) };
+    }
+
+    float HalfToFloat(Half value) {
+        uint32_t sign = static_cast<uint32_t>(value.bits & 0x8000) << 16;
+        uint32_t exponent = (value.bits >> 10) & 0x1F;
+        uint32_t mantissa = value.bits & 0x3FF;
+        if (exponent == 0) {
+            float subnormal = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign ? -subnormal : subnormal;
+        }
+
+        uint32_t bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13)
+                                       : sign | ((exponent + 112) << 23) | (mantissa << 13);
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    glm::vec2 OctahedralEncode(const glm::vec3& normal) {
+        float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (sum == 0.0f)
+            return glm::vec2(0.0f);
+        glm::vec2 encoded(normal.x / sum, normal.y / sum);
+        if (normal.z < 0.0f) {
+            encoded = glm::vec2((1.0f - std::abs(encoded.y)) * signNotZero(encoded.x),
+                                (1.0f - std::abs(encoded.x)) * signNotZero(encoded.y));
+        }
+        return encoded;
+    }
+
+    glm::vec3 OctahedralDecode(const glm::vec2& encoded) {
+        glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+        float fold = std::max(-normal.z, 0.0f);
+        normal.x += normal.x >= 0.0f ? -fold : fold;
+        normal.y += normal.y >= 0.0f ? -fold : fold;
+        return glm::normalize(normal);
+    }
+
+    Packed1010102 PackSnorm1010102(const glm::vec4& value) {
+        auto pack = [](float component, float max, uint32_t mask) {
+            return static_cast<uint32_t>(static_cast<int32_t>(std::lround(std::clamp(component, -1.0f, 1.0f) * max))) & mask;
+        };
+        return { pack(value.x, 511.0f, 0x3FF) | (pack(value.y, 511.0f, 0x3FF) << 10) |
+                 (pack(value.z, 511.0f, 0x3FF) << 20) | (pack(value.w, 1.0f, 0x3) << 30) };
+    }
+
+    glm::vec4 UnpackSnorm1010102(Packed1010102 value) {
+        // Shifting the field to the top and back sign extends it
+        auto unpack = [&value](uint32_t shift, uint32_t bits, float max) {
+            int32_t field = static_cast<int32_t>(value.bits << (32 - shift - bits)) >> (32 - bits);
+            return std::max(field / max, -1.0f);
+        };
+        return glm::vec4(unpack(0, 10, 511.0f), unpack(10, 10, 511.0f), unpack(20, 10, 511.0f), unpack(30, 2, 1.0f));
+    }
+
+    VertexDequantization VertexQuantizer::Quantize(std::span<const Vertex> vertices, std::vector<QuantizedVertex>& quantized) {
+        AABB bounds = ComputeAABB(vertices);
+        VertexDequantization dequantization;
+        dequantization.octahedralNormals = true;
+        dequantization.positionOffset = bounds.IsValid() ? bounds.min : glm::vec3(0.0f);
+        dequantization.positionScale = bounds.IsValid() ? bounds.max - bounds.min : glm::vec3(0.0f);
+
+        quantized.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vertex& vertex = vertices[i];
+            QuantizedVertex& result = quantized[i];
+            for (int axis = 0; axis < 3; axis++) {
+                float scale = dequantization.positionScale[axis];
+                float steps = scale > 0.0f ? (vertex.position[axis] - dequantization.positionOffset[axis]) / scale * 65535.0f : 0.0f;
+                result.position[axis] = static_cast<uint16_t>(std::lround(std::clamp(steps, 0.0f, 65535.0f)));
+            }
+            result.position[3] = 0;
+
+            // Rounding each component on its own can be a step off, keep whichever neighbour decodes closest
+            glm::vec2 encoded = OctahedralEncode(vertex.normal);
+            glm::vec2 base(std::floor(encoded.x * 32767.0f), std::floor(encoded.y * 32767.0f));
+            glm::vec3 normal = glm::length(vertex.normal) > 0.0f ? glm::normalize(vertex.normal) : vertex.normal;
+            float best = FLT_MAX;
+            for (int corner = 0; corner < 4; corner++) {
+                int16_t x = toSnorm16((base.x + (corner & 1)) / 32767.0f);
+                int16_t y = toSnorm16((base.y + (corner >> 1)) / 32767.0f);
+                glm::vec3 difference = OctahedralDecode(glm::vec2(fromSnorm16(x), fromSnorm16(y))) - normal;
+                float distance = glm::dot(difference, difference);
+                if (distance < best) {
+                    best = distance;
+                    result.normal[0] = x;
+                    result.normal[1] = y;
+                }
+            }
+
+            result.tex_coords[0] = FloatToHalf(vertex.tex_coords.x);
+            result.tex_coords[1] = FloatToHalf(vertex.tex_coords.y);
+        }
+        return dequantization;
+    }
+
+    Vertex VertexQuantizer::Dequantize(const QuantizedVertex& vertex, const VertexDequantization& dequantization) {
+        Vertex result;
+        result.position = glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]) / 65535.0f *
+                          dequantization.positionScale + dequantization.positionOffset;
+        result.normal = OctahedralDecode(glm::vec2(fromSnorm16(vertex.normal[0]), fromSnorm16(vertex.normal[1])));
+        result.tex_coords = glm::vec2(HalfToFloat(vertex.tex_coords[0]), HalfToFloat(vertex.tex_coords[1]));
+        return result;
+    }
+
+    QuantizationError VertexQuantizer::MeasureError(std::span<const Vertex> vertices, std::span<const QuantizedVertex> quantized,
+                                                    const VertexDequantization& dequantization) {
+        QuantizationError error;
+        // Half a step, plus the float rounding of the decode
+        float magnitude = glm::length(glm::abs(dequantization.positionOffset) + dequantization.positionScale);
+        error.positionBound = 0.5f * glm::length(dequantization.positionScale / 65535.0f) + 4.0f * FLT_EPSILON * magnitude;
+
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vertex& original = vertices[i];
+            Vertex decoded = Dequantize(quantized[i], dequantization);
+            error.position = std::max(error.position, glm::length(decoded.position - original.position));
+
+            float normal_length = glm::length(original.normal);
+            if (normal_length > 0.0f) {
+                // acos loses too much precision this close to 1
+                glm::vec3 normal = original.normal / normal_length;
+                float angle = std::atan2(glm::length(glm::cross(decoded.normal, normal)), glm::dot(decoded.normal, normal));
+                error.normalDegrees = std::max(error.normalDegrees, glm::degrees(angle));
+            }
+
+            for (int axis = 0; axis < 2; axis++) {
+                // Relative above the smallest normal half, absolute below where halves go subnormal
+                float magnitude = std::max(std::abs(original.tex_coords[axis]), 1.0f / 16384.0f);
+                error.texCoord = std::max(error.texCoord, std::abs(decoded.tex_coords[axis] - original.tex_coords[axis]) / magnitude);
+            }
+        }
+        return error;
+    }
+
+    VertexLayout VertexQuantizer::GetLayout(VertexFormat format) {
+        VertexLayout layout;
+        if (format == VertexFormat::QUANTIZED) {
+            layout.Push<uint16_t>(4, true);
+            layout.Push<int16_t>(2, true);
+            layout.Push<Half>(2, false);
+        } else {
+            layout.Push<float>(3, false);
+            layout.Push<float>(3, false);
+            layout.Push<float>(2, false);
+        }
+        return layout;
+    }
+
+}
@@ -0,0 +1,243 @@
+#include <frame_stats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace OGLR {
+
+    namespace {
+
+        void writeTimes(std::ostream& json, const char* name, const FrameTimes& times) {
+            json << "  \"" << name << "\": { \"min\": " << times.min << ", \"avg\": " << times.avg << ", \"p50\": " << times.p50
+                 << ", \"p95\": " << times.p95 << ", \"p99\": " << times.p99 << ", \"max\": " << times.max << " },\n";
+        }
+
+    }
+
+    void FrameStats::Start(float budget_ms, bool keep_all_frames) {
+        mBudgetMs = budget_ms;
+        mKeepAll = keep_all_frames;
+        mGpuTimer = std::make_unique<GpuTimer>();
+        mGpuResolved = mFrame;
+        Reset();
+    }
+
+    void FrameStats::Finish() {
+        if (!mGpuTimer)
+            return;
+        mGpuTimer->Flush();
+        for (double ms : mGpuTimer->GetResults())
+            resolveGPU(mGpuResolved++, static_cast<float>(ms));
+        mGpuTimer.reset();
+    }
+
+    void FrameStats::Reset() {
+        mFirstFrame.store(mFrame, std::memory_order_relaxed);
+        mAllSamples.clear();
+        mHitches.clear();
+        mHitchCount = 0;
+    }
+
+    void FrameStats::BeginFrame() {
+        mFrameStart = Profiler::Now();
+        mZones[mFrame % (GpuTimer::LATENCY + 1)].clear();
+        if (mGpuTimer)
+            mGpuTimer->Begin();
+    }
+
+    void FrameStats::EndFrame(uint32_t draws, uint64_t triangles, uint64_t bytes_uploaded) {
+        if (mGpuTimer)
+            mGpuTimer->End();
+
+        FrameSample sample;
+        sample.frame = mFrame;
+        sample.cpuMs = (Profiler::Now() - mFrameStart) / 1e6f;
+        sample.draws = draws;
+        sample.triangles = triangles;
+        sample.bytesUploaded = bytes_uploaded;
+        write(sample);
+        if (mKeepAll)
+            mAllSamples.push_back(sample);
+        mWritten.store(mFrame + 1, std::memory_order_release);
+
+        // Without a timer the CPU time alone decides
+        if (mGpuTimer) {
+            for (double ms : mGpuTimer->GetResults())
+                resolveGPU(mGpuResolved++, static_cast<float>(ms));
+            mGpuTimer->ClearResults();
+        } else {
+            resolveGPU(mFrame, -1.0f);
+        }
+        mFrame++;
+    }
+
+    void FrameStats::AddZoneTime(const char* name, float ms) {
+        std::vector<FrameZoneTime>& zones = mZones[mFrame % (GpuTimer::LATENCY + 1)];
+        for (FrameZoneTime& zone : zones) {
+            if (zone.name == name) {
+                zone.ms += ms;
+                return;
+            }
+        }
+        zones.push_back({ name, ms });
+    }
+
+    uint32_t FrameStats::GetRecent(FrameSample* samples, uint32_t count) {
+        uint64_t written = mWritten.load(std::memory_order_acquire);
+        uint64_t first = std::max(mFirstFrame.load(std::memory_order_relaxed), written - std::min<uint64_t>({ written, count, HISTORY }));
+        uint32_t copied = 0;
+        for (uint64_t frame = first; frame < written; frame++) {
+            const Slot& slot = mRing[frame % HISTORY];
+            FrameSample sample;
+            uint32_t before, after;
+            do {
+                before = slot.sequence.load(std::memory_order_acquire);
+                sample = slot.sample;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = slot.sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) || before != after);
+            // Overwritten by a newer frame while we got here
+            if (sample.frame == frame)
+                samples[copied++] = sample;
+        }
+        return copied;
+    }
+
+    FrameSummary FrameStats::GetSummary() {
+        std::vector<FrameSample> samples = collect();
+        FrameSummary summary;
+        summary.frames = samples.size();
+        summary.hitches = mHitchCount;
+        if (samples.empty())
+            return summary;
+
+        std::vector<float> cpu, gpu;
+        for (const FrameSample& sample : samples) {
+            cpu.push_back(sample.cpuMs);
+            if (sample.gpuMs >= 0.0f)
+                gpu.push_back(sample.gpuMs);
+            summary.avgDraws += sample.draws;
+            summary.avgTriangles += static_cast<double>(sample.triangles);
+            summary.avgBytesUploaded += static_cast<double>(sample.bytesUploaded);
+        }
+        summary.cpu = computeTimes(cpu);
+        summary.gpu = computeTimes(gpu);
+        summary.avgDraws /= samples.size();
+        summary.avgTriangles /= samples.size();
+        summary.avgBytesUploaded /= samples.size();
+        return summary;
+    }
+
+    bool FrameStats::WriteCSV(const std::string& path) {
+        std::ofstream csv(path);
+        if (!csv) {
+            std::cerr << "ERROR::FRAME_STATS::COULDN'T_WRITE " << path << '\n';
+            return false;
+        }
+        uint64_t first = mFirstFrame.load(std::memory_order_relaxed);
+        csv << "frame,cpu_ms,gpu_ms,draws,triangles,bytes_uploaded,over_budget\n";
+        for (const FrameSample& sample : collect()) {
+            csv << sample.frame - first << ',' << sample.cpuMs << ',';
+            if (sample.gpuMs >= 0.0f)
+                csv << sample.gpuMs;
+            bool over_budget = sample.cpuMs > mBudgetMs || sample.gpuMs > mBudgetMs;
+            csv << ',' << sample.draws << ',' << sample.triangles << ',' << sample.bytesUploaded << ',' << over_budget << '\n';
+        }
+        return static_cast<bool>(csv);
+    }
+
+    bool FrameStats::WriteJSON(const std::string& path) {
+        std::ofstream json(path);
+        if (!json) {
+            std::cerr << "ERROR::FRAME_STATS::COULDN'T_WRITE " << path << '\n';
+            return false;
+        }
+        FrameSummary summary = GetSummary();
+        uint64_t first = mFirstFrame.load(std::memory_order_relaxed);
+        json << "{\n  \"budgetMs\": " << mBudgetMs << ",\n  \"frames\": " << summary.frames << ",\n  \"hitches\": " << summary.hitches << ",\n";
+        writeTimes(json, "cpuMs", summary.cpu);
+        writeTimes(json, "gpuMs", summary.gpu);
+        json << "  \"avgDraws\": " << summary.avgDraws << ",\n  \"avgTriangles\": " << summary.avgTriangles
+             << ",\n  \"avgBytesUploaded\": " << summary.avgBytesUploaded << ",\n  \"hitchFrames\": [";
+        for (size_t i = 0; i < mHitches.size(); i++) {
+            const Hitch& hitch = mHitches[i];
+            json << (i ? ",\n" : "\n") << "    { \"frame\": " << hitch.frame - first << ", \"cpuMs\": " << hitch.cpuMs
+                 << ", \"gpuMs\": " << hitch.gpuMs << ", \"zones\": {";
+            for (uint32_t zone = 0; zone < std::size(hitch.zones) && hitch.zones[zone].name; zone++)
+                json << (zone ? ", " : " ") << '"' << hitch.zones[zone].name << "\": " << hitch.zones[zone].ms;
+            json << " } }";
+        }
+        json << (mHitches.empty() ? "]\n}\n" : "\n  ]\n}\n");
+        return static_cast<bool>(json);
+    }
+
+    void FrameStats::write(const FrameSample& sample) {
+        Slot& slot = mRing[sample.frame % HISTORY];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.sample = sample;
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void FrameStats::resolveGPU(uint64_t frame, float ms) {
+        uint64_t first = mFirstFrame.load(std::memory_order_relaxed);
+        if (frame < first)
+            return;
+
+        Slot& slot = mRing[frame % HISTORY];
+        if (slot.sample.frame != frame)
+            return;
+        FrameSample sample = slot.sample;
+        sample.gpuMs = ms;
+        write(sample);
+        if (mKeepAll)
+            mAllSamples[frame - first].gpuMs = ms;
+
+        if (sample.cpuMs <= mBudgetMs && ms <= mBudgetMs)
+            return;
+        mHitchCount++;
+        Hitch hitch;
+        hitch.frame = frame;
+        hitch.cpuMs = sample.cpuMs;
+        hitch.gpuMs = ms;
+        std::vector<FrameZoneTime> zones = mZones[frame % (GpuTimer::LATENCY + 1)];
+        std::sort(zones.begin(), zones.end(), [](const FrameZoneTime& a, const FrameZoneTime& b) { return a.ms > b.ms; });
+        std::copy_n(zones.begin(), std::min(zones.size(), std::size(hitch.zones)), hitch.zones);
+
+        // The latest MAX_HITCHES are kept, the count covers all of them
+        if (mHitches.size() == MAX_HITCHES)
+            mHitches.erase(mHitches.begin());
+        mHitches.push_back(hitch);
+    }
+
+    std::vector<FrameSample> FrameStats::collect() {
+        if (mKeepAll)
+            return mAllSamples;
+        std::vector<FrameSample> samples(HISTORY);
+        samples.resize(GetRecent(samples.data(), HISTORY));
+        return samples;
+    }
+
+    FrameTimes FrameStats::computeTimes(std::vector<float>& ms) {
+        FrameTimes times;
+        if (ms.empty())
+            return times;
+        std::sort(ms.begin(), ms.end());
+        // Nearest rank
+        auto percentile = [&ms](float p) { return ms[std::max<size_t>(1, static_cast<size_t>(std::ceil(p * ms.size()))) - 1]; };
+        double total = 0.0;
+        for (float time : ms)
+            total += time;
+        times.min = ms.front();
+        times.max = ms.back();
+        times.avg = static_cast<float>(total / ms.size());
+        times.p50 = percentile(0.50f);
+        times.p95 = percentile(0.95f);
+        times.p99 = percentile(0.99f);
+        return times;
+    }
+
+}
@@ -1,6 +1,11 @@
 #include <glfw_window.h>
+#include <Renderer/gl_state.h>
+#include <Renderer/null_gl.h>
 #include <cassert>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <glad/glad.h>
 
@@ -9,6 +14,20 @@ namespace OGLR {
     Window::Window(const WindowSpecs& specs)
         :mGLFWwindow(nullptr), mSpecs(specs) {
 
+        if (mSpecs.backend == GLBackend::NULL_GL) {
+            // Every GL call would go through a null pointer, nothing can run without it
+            if (!NullGL::Load()) {
+                std::cerr << "ERROR::WINDOW:: failed to load NullGL\n";
+                std::exit(EXIT_FAILURE);
+            }
+            GLState::Viewport(0, 0, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+            return;
+        }
+        if (mSpecs.backend == GLBackend::OFFSCREEN) {
+            createOffscreen();
+            return;
+        }
+
         if (!glfwInit())
             assert("Couldn't initialise glfw");
 
@@ -37,7 +56,7 @@ namespace OGLR {
             mSpecs.height = mode->height;
         }
 
-        glViewport(0, 0, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+        GLState::Viewport(0, 0, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
         Input::SetCurrentWindow(mGLFWwindow);
 
         glfwSetWindowUserPointer(mGLFWwindow, this);
@@ -51,10 +70,96 @@ namespace OGLR {
     }
 
     Window::~Window() {
+        if (mSpecs.backend == GLBackend::OFFSCREEN)
+            deleteFramebuffer();
+        // The EGL context goes first, GLFW only has the hidden window of an offscreen run to clean up
+        mOffscreenContext.reset();
+        if (!mGLFWwindow)
+            return;
         glfwDestroyWindow(mGLFWwindow);
         glfwTerminate();
     }
 
+    void Window::createOffscreen() {
+        mOffscreenContext = std::make_unique<OffscreenContext>();
+        if (!mOffscreenContext->Create(4, 6)) {
+            mOffscreenContext.reset();
+            std::cout << "Falling back to a hidden window\n";
+            if (!glfwInit()) {
+                std::cerr << "ERROR::WINDOW:: couldn't initialise glfw\n";
+                std::exit(EXIT_FAILURE);
+            }
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            mGLFWwindow = glfwCreateWindow(static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height), mSpecs.title.c_str(), nullptr, nullptr);
+            if (!mGLFWwindow) {
+                glfwTerminate();
+                std::cerr << "ERROR::WINDOW:: couldn't create the hidden window\n";
+                std::exit(EXIT_FAILURE);
+            }
+            glfwMakeContextCurrent(mGLFWwindow);
+            if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+                std::cerr << "ERROR::WINDOW:: failed to initialize GLAD\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+
+        // Input stays without a window, a benchmark has nothing to react to
+        createFramebuffer();
+        GLState::Viewport(0, 0, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(Window::DebugLogOGL, nullptr);
+    }
+
+    void Window::createFramebuffer() {
+        glGenFramebuffers(1, &mFramebuffer);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+
+        glGenRenderbuffers(1, &mColorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, mColorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorBuffer);
+
+        glGenRenderbuffers(1, &mDepthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::WINDOW::OFFSCREEN_FRAMEBUFFER_INCOMPLETE\n";
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    }
+
+    void Window::deleteFramebuffer() {
+        GLState::ForgetFramebuffer(mFramebuffer);
+        glDeleteFramebuffers(1, &mFramebuffer);
+        glDeleteRenderbuffers(1, &mColorBuffer);
+        glDeleteRenderbuffers(1, &mDepthBuffer);
+        mFramebuffer = mColorBuffer = mDepthBuffer = 0;
+    }
+
+    bool Window::WriteImage(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "ERROR::WINDOW::COULDN'T_WRITE " << path << '\n';
+            return false;
+        }
+
+        uint32_t width = mSpecs.width, height = mSpecs.height;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+        GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, static_cast<int>(width), static_cast<int>(height), GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        // GL's rows start at the bottom
+        file << "P6\n" << width << ' ' << height << "\n255\n";
+        for (uint32_t y = 0; y < height; y++)
+            file.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(height - 1 - y) * width * 3]), width * 3);
+        return static_cast<bool>(file);
+    }
+
    void Window::DebugLogOGL(uint32_t source, uint32_t type, uint32_t id,
                                                     uint32_t severity, int32_t length,
                                                     const char* msg, const void* data) {
@@ -153,7 +258,9 @@ namespace OGLR {
    }
 
     void Window::Close() const {
-        glfwSetWindowShouldClose(mGLFWwindow, true);
+        mClosed = true;
+        if (mGLFWwindow)
+            glfwSetWindowShouldClose(mGLFWwindow, true);
     }
 
     void Window::SetWidth(int width) {
@@ -167,11 +274,21 @@ namespace OGLR {
     void Window::Resize(int width, int height) {
         mSpecs.width = width;
         mSpecs.height = height;
-        glfwSetWindowSize(mGLFWwindow, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
-        glViewport(0, 0, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+        if (mSpecs.backend == GLBackend::OFFSCREEN) {
+            deleteFramebuffer();
+            createFramebuffer();
+        } else if (mGLFWwindow) {
+            glfwSetWindowSize(mGLFWwindow, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
+        }
+        GLState::Viewport(0, 0, static_cast<int>(mSpecs.width), static_cast<int>(mSpecs.height));
     }
 
     void Window::OnUpdate() const {
+        if (mSpecs.backend == GLBackend::NULL_GL)
+            NullGL::EndFrame();
+        // Nothing to present headless, finished frames stay in the framebuffer
+        if (IsHeadless())
+            return;
         glfwSwapBuffers(mGLFWwindow);
         Input::OnUpdate();
     }
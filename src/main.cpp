@@ -7,33 +7,572 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <Renderer/frustum_culler.h>
+#include <Renderer/geometry_arena.h>
+#include <Renderer/gl_state.h>
+#include <Renderer/null_gl.h>
+#include <Renderer/occlusion_buffer.h>
+#include <Renderer/render_queue.h>
 #include <Renderer/shader.h>
+#include <Renderer/shader_variants.h>
+#include <Renderer/staging_uploader.h>
+#include <Renderer/stream_buffer.h>
+#include <Renderer/texture_cache.h>
+#include <Renderer/texture_loader.h>
+#include <Renderer/uniform_buffer.h>
+#include <Renderer/vertex_quantization.h>
+#include <frame_stats.h>
+#include <profiler.h>
 #include <scene.h>
-
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_set>
+
+// Images the models under directory use as normal maps, the offline passes encode them like the model loader does
+static std::unordered_set<std::string> FindNormalMaps(const std::string& directory) {
+    std::unordered_set<std::string> normal_maps;
+    Assimp::Importer importer;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file() || !importer.IsExtensionSupported(entry.path().extension().string()))
+            continue;
+
+        std::string path = entry.path().generic_string();
+        OGLR::ModelData data;
+        if (!OGLR::Model::LoadData(path, data))
+            continue;
+        std::string model_directory = path.substr(0, path.find_last_of('/'));
+        for (const OGLR::MaterialData& material : data.materials) {
+            for (const OGLR::MaterialTextureRef& texture : material.textures) {
+                if (texture.type == "texture_normal")
+                    normal_maps.insert(OGLR::TextureCache::NormalizePath(model_directory + '/' + texture.path));
+            }
+        }
+    }
+    return normal_maps;
+}
+
+// Offline pass building the .oglrtex container of every image under directory
+static int CompressTextures(const std::string& directory) {
+    std::unordered_set<std::string> normal_maps = FindNormalMaps(directory);
+    std::mutex print_mutex;
+    uint64_t source_bytes = 0, compressed_bytes = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+        std::string extension = entry.path().extension().string();
+        if (extension != ".tga" && extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".bmp")
+            continue;
+
+        std::string path = entry.path().generic_string();
+        bool normal_map = normal_maps.contains(OGLR::TextureCache::NormalizePath(path));
+        OGLR::ThreadPool::Get().Submit([path, normal_map, &print_mutex, &source_bytes, &compressed_bytes]() {
+            OGLR::CompressedTexture texture;
+            double psnr = 0.0;
+            bool built = OGLR::TextureLoader::LoadCompressed(path, texture, &psnr, normal_map);
+
+            std::lock_guard<std::mutex> lock(print_mutex);
+            if (!built) {
+                std::cerr << "Couldn't compress " << path << '\n';
+                return;
+            }
+            // Raw size as the uncompressed upload path would store it, RGBA8 plus a full mip chain
+            uint64_t raw = static_cast<uint64_t>(texture.width) * texture.height * 4 * 4 / 3;
+            source_bytes += raw;
+            compressed_bytes += texture.GetMemorySize();
+            std::cout << path << ": BC" << (texture.format == OGLR::BlockFormat::BC1 ? 1 : texture.format == OGLR::BlockFormat::BC3 ? 3 : 5)
+                      << ", " << texture.levels.size() << " levels, " << static_cast<double>(raw) / texture.GetMemorySize() << "x smaller";
+            if (psnr > 0.0)
+                std::cout << ", PSNR " << psnr << " dB";
+            std::cout << '\n';
+        });
+    }
+    OGLR::ThreadPool::Get().Wait();
+    std::cout << "Total: " << source_bytes / (1024.0 * 1024.0) << " MB -> " << compressed_bytes / (1024.0 * 1024.0) << " MB\n";
+    return 0;
+}
+
+// CPU only, encodes every image under directory in memory and fails when one decodes back worse than min_psnr
+static int TestTexturePSNR(const std::string& directory, double min_psnr) {
+    std::unordered_set<std::string> normal_maps = FindNormalMaps(directory);
+    std::mutex print_mutex;
+    uint32_t tested = 0, failures = 0;
+    double worst = INFINITY;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+        std::string extension = entry.path().extension().string();
+        if (extension != ".tga" && extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".bmp")
+            continue;
+
+        std::string path = entry.path().generic_string();
+        bool normal_map = normal_maps.contains(OGLR::TextureCache::NormalizePath(path));
+        OGLR::ThreadPool::Get().Submit([path, normal_map, min_psnr, &print_mutex, &tested, &failures, &worst]() {
+            OGLR::CompressedTexture texture;
+            double psnr = 0.0;
+            bool built = OGLR::TextureLoader::Compress(path, texture, &psnr, normal_map);
+
+            std::lock_guard<std::mutex> lock(print_mutex);
+            if (!built) {
+                std::cerr << "Couldn't compress " << path << '\n';
+                return;
+            }
+            bool passed = psnr >= min_psnr;
+            tested++;
+            failures += !passed;
+            worst = std::min(worst, psnr);
+            std::cout << (passed ? "PASS " : "FAIL ") << path << ": BC"
+                      << (texture.format == OGLR::BlockFormat::BC1 ? 1 : texture.format == OGLR::BlockFormat::BC3 ? 3 : 5)
+                      << ", PSNR " << psnr << " dB\n";
+        });
+    }
+    OGLR::ThreadPool::Get().Wait();
+    std::cout << failures << " of " << tested << " images under " << min_psnr << " dB, worst " << worst << " dB\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// CPU only, random boxes scattered around a camera looking down -Z
+static int BenchmarkCulling() {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 1000.0f);
+    OGLR::Frustum frustum = OGLR::Frustum::FromMatrix(proj * view);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.5f, 20.0f);
+
+    std::cout << "Frustum culling, " << OGLR::FrustumCuller::GetInstructionSet() << " build\n";
+    for (uint32_t count : { 10000u, 100000u, 1000000u }) {
+        OGLR::CullingBounds bounds;
+        bounds.Resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            OGLR::AABB box;
+            glm::vec3 center(position(rng), position(rng), position(rng));
+            glm::vec3 extents(size(rng), size(rng), size(rng));
+            box.Expand(center - extents);
+            box.Expand(center + extents);
+            bounds.Set(i, box, { center, glm::length(extents) });
+        }
+
+        // Repeats until each path ran for a measurable time
+        auto measure = [&](auto cull, std::vector<uint32_t>& visible) {
+            using Clock = std::chrono::steady_clock;
+            uint64_t culled = 0;
+            Clock::time_point start = Clock::now();
+            double seconds = 0.0;
+            while (seconds < 0.25) {
+                cull(frustum, bounds, visible);
+                culled += count;
+                seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            }
+            return culled / seconds;
+        };
+        std::vector<uint32_t> simd_visible, scalar_visible;
+        double simd_rate = measure(OGLR::FrustumCuller::Cull, simd_visible);
+        double scalar_rate = measure(OGLR::FrustumCuller::CullScalar, scalar_visible);
+
+        std::cout << count << " objects, " << simd_visible.size() << " visible: "
+                  << simd_rate / 1e6 << " M objects/s, scalar " << scalar_rate / 1e6 << " M objects/s ("
+                  << simd_rate / scalar_rate << "x)";
+        if (simd_visible != scalar_visible)
+            std::cout << ", RESULTS DIFFER";
+        std::cout << '\n';
+    }
+    return 0;
+}
+
+// CPU only through NullGL, random meshes around a camera looking down -Z behind a wall. Times what a frame
+// does before its first GL call: BVH culling, occlusion tests and draw list building per range of visible
+// meshes, then merging, sorting and writing the indirect commands, on 1 up to max_threads threads.
+static int BenchmarkSubmission(uint32_t max_threads) {
+    if (!OGLR::NullGL::Load())
+        return -1;
+    OGLR::StreamBuffer stream_buffer;
+    OGLR::GeometryArena geometry_arena;
+    std::unique_ptr<OGLR::Shader> shaders[] = { std::make_unique<OGLR::Shader>("res/shaders/default.glsl"),
+                                                std::make_unique<OGLR::Shader>("res/shaders/light.glsl") };
+    std::vector<std::shared_ptr<OGLR::Material>> materials;
+    for (uint32_t i = 0; i < 64; i++)
+        materials.push_back(std::make_shared<OGLR::Material>(std::vector<OGLR::MeshTexture>()));
+
+    const float far_plane = 1000.0f;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, far_plane);
+    OGLR::Frustum frustum = OGLR::Frustum::FromMatrix(proj * view);
+
+    OGLR::OccluderMesh wall;
+    wall.positions = { { -40.0f, -40.0f, 0.0f }, { 40.0f, -40.0f, 0.0f }, { 40.0f, 40.0f, 0.0f }, { -40.0f, 40.0f, 0.0f } };
+    wall.indices = { 0, 1, 2, 2, 3, 0 };
+    OGLR::OcclusionBuffer occlusion;
+    occlusion.Begin(proj * view);
+    occlusion.RasterizeOccluder(wall, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -100.0f)));
+    occlusion.End();
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.5f, 20.0f);
+    std::uniform_int_distribution<uint32_t> material(0, 63);
+
+    // Powers of two up to max_threads
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    std::cout << "Draw submission, " << max_threads << " threads at most\n";
+    for (uint32_t count : { 100000u, 1000000u }) {
+        std::vector<OGLR::AABB> bounds(count);
+        std::vector<OGLR::DrawCommand> commands(count);
+        for (uint32_t i = 0; i < count; i++) {
+            glm::vec3 center(position(rng), position(rng), position(rng));
+            glm::vec3 extents(size(rng), size(rng), size(rng));
+            bounds[i].Expand(center - extents);
+            bounds[i].Expand(center + extents);
+
+            OGLR::DrawCommand& command = commands[i];
+            command.shader = shaders[i % 8 == 0].get();
+            command.material = materials[material(rng)].get();
+            command.vertexArray = &geometry_arena.GetVertexArray();
+            command.indexType = i % 4 == 0 ? OGLR::IndexType::UINT32 : OGLR::IndexType::UINT16;
+            command.indexCount = 36;
+            command.object = i;
+        }
+        OGLR::BVH bvh;
+        bvh.Build(bounds);
+
+        OGLR::RenderQueue render_queue;
+        std::vector<uint32_t> visible;
+        const uint32_t grain = 1024;
+        auto build_frame = [&](OGLR::ThreadPool* pool) {
+            stream_buffer.BeginFrame();
+            render_queue.Begin(far_plane);
+            bvh.CullFrustum(frustum, visible);
+            uint32_t visible_count = static_cast<uint32_t>(visible.size());
+            uint32_t range_count = (visible_count + grain - 1) / grain;
+            uint32_t first_list = render_queue.AddDrawLists(range_count);
+            auto submit_range = [&](uint32_t range, uint32_t begin, uint32_t end) {
+                OGLR::DrawList& list = render_queue.GetDrawList(first_list + range);
+                OGLR::OcclusionStats stats;
+                for (uint32_t i = begin; i < end; i++) {
+                    uint32_t item = visible[i];
+                    if (!occlusion.IsVisible(bounds[item], stats))
+                        continue;
+                    float view_depth = -(view * glm::vec4(bounds[item].GetCenter(), 1.0f)).z;
+                    list.Submit(OGLR::MAIN_PASS, commands[item], view_depth);
+                }
+            };
+            if (pool) {
+                pool->ParallelFor(visible_count, grain, submit_range);
+            } else {
+                for (uint32_t range = 0; range < range_count; range++)
+                    submit_range(range, range * grain, std::min(visible_count, (range + 1) * grain));
+            }
+            render_queue.Prepare(pool);
+            stream_buffer.EndFrame();
+        };
+
+        // Repeats until each thread count ran for a measurable time
+        double single_ms = 0.0;
+        for (uint32_t threads : thread_counts) {
+            // The calling thread takes ranges too
+            std::unique_ptr<OGLR::ThreadPool> pool = threads > 1 ? std::make_unique<OGLR::ThreadPool>(threads - 1) : nullptr;
+            using Clock = std::chrono::steady_clock;
+            uint32_t frames = 0;
+            Clock::time_point start = Clock::now();
+            double seconds = 0.0;
+            while (seconds < 0.25) {
+                build_frame(pool.get());
+                frames++;
+                seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            }
+            double frame_ms = seconds * 1000.0 / frames;
+            if (threads == 1)
+                single_ms = frame_ms;
+            std::cout << count << " meshes, " << visible.size() << " in the frustum, " << render_queue.GetCommandCount() << " drawn, "
+                      << threads << (threads == 1 ? " thread: " : " threads: ") << frame_ms << " ms per frame ("
+                      << single_ms / frame_ms << "x)\n";
+        }
+    }
+    return 0;
+}
+
+// CPU only, a wall in front of the camera with boxes around it, writes the depth buffer to image_path
+static int TestOcclusion(const std::string& image_path) {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+
+    OGLR::OccluderMesh wall;
+    wall.positions = { { -4.0f, -4.0f, 0.0f }, { 4.0f, -4.0f, 0.0f }, { 4.0f, 4.0f, 0.0f }, { -4.0f, 4.0f, 0.0f } };
+    wall.indices = { 0, 1, 2, 2, 3, 0 };
+
+    OGLR::OcclusionBuffer occlusion;
+    occlusion.Begin(proj * view);
+    occlusion.RasterizeOccluder(wall, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)));
+    occlusion.End();
+
+    auto box = [](const glm::vec3& center, float half_size) {
+        OGLR::AABB bounds;
+        bounds.Expand(center - glm::vec3(half_size));
+        bounds.Expand(center + glm::vec3(half_size));
+        return bounds;
+    };
+    struct Case {
+        const char* name;
+        OGLR::AABB bounds;
+        bool visible;
+    };
+    const Case cases[] = {
+        { "behind the wall", box({ 0.0f, 0.0f, -20.0f }, 1.0f), false },
+        { "behind a wall corner", box({ -2.0f, 2.0f, -30.0f }, 2.0f), false },
+        { "in front of the wall", box({ 0.0f, 0.0f, -5.0f }, 1.0f), true },
+        { "beside the wall", box({ 12.0f, 0.0f, -20.0f }, 1.0f), true },
+        { "sticking out behind the wall", box({ 4.0f, 0.0f, -20.0f }, 2.0f), true },
+        { "through the wall", box({ 0.0f, 0.0f, -10.0f }, 1.0f), true },
+        { "crossing the near plane", box({ 0.0f, 0.0f, 0.0f }, 1.0f), true },
+    };
+
+    uint32_t failures = 0;
+    for (const Case& test : cases) {
+        bool visible = occlusion.IsVisible(test.bounds);
+        std::cout << (visible == test.visible ? "PASS " : "FAIL ") << test.name << ": "
+                  << (visible ? "visible" : "occluded") << '\n';
+        failures += visible != test.visible;
+    }
+    const OGLR::OcclusionStats& stats = occlusion.GetStats();
+    std::cout << stats.rasterizedTriangles << " of " << stats.occluderTriangles << " occluder triangles rasterized, "
+              << stats.occluded << " of " << stats.tested << " boxes occluded\n";
+
+    if (!occlusion.WriteDebugImage(image_path))
+        return -1;
+    std::cout << "Wrote " << occlusion.GetWidth() << "x" << occlusion.GetHeight() << " depth to " << image_path << '\n';
+    return failures == 0 ? 0 : 1;
+}
+
+// CPU only, quantizes every mesh of model_path, or a generated sphere without one, and checks the
+// errors against what the format promises. Also prints how much vertex memory the format saves.
+static int TestQuantization(const char* model_path) {
+    uint32_t failures = 0;
+    auto check = [&failures](bool passed, const std::string& name) {
+        std::cout << (passed ? "PASS " : "FAIL ") << name << '\n';
+        failures += !passed;
+    };
+
+    // Every finite half has to survive a trip through float unchanged
+    bool halves_round_trip = true;
+    for (uint32_t bits = 0; bits < 0x10000; bits++) {
+        bool nan = (bits & 0x7C00) == 0x7C00 && (bits & 0x3FF) != 0;
+        if (!nan && OGLR::FloatToHalf(OGLR::HalfToFloat({ static_cast<uint16_t>(bits) })).bits != bits)
+            halves_round_trip = false;
+    }
+    check(halves_round_trip, "half float round trip");
+
+    bool packed_round_trip = true;
+    for (float value : { -1.0f, -0.5f, 0.0f, 0.25f, 1.0f }) {
+        glm::vec4 unpacked = OGLR::UnpackSnorm1010102(OGLR::PackSnorm1010102(glm::vec4(value, -value, value * 0.5f, value < 0.0f ? -1.0f : 1.0f)));
+        packed_round_trip &= std::abs(unpacked.x - value) <= 0.5f / 511.0f && std::abs(unpacked.y + value) <= 0.5f / 511.0f &&
+                             std::abs(unpacked.z - value * 0.5f) <= 0.5f / 511.0f && unpacked.w == (value < 0.0f ? -1.0f : 1.0f);
+    }
+    check(packed_round_trip, "10_10_10_2 round trip");
+
+    OGLR::ModelData data;
+    if (model_path) {
+        if (!OGLR::Model::LoadData(model_path, data))
+            return -1;
+    } else {
+        // Far from the origin and with tiling UVs, the cases quantization has the hardest time with
+        const uint32_t rings = 64, segments = 128;
+        for (uint32_t ring = 0; ring <= rings; ring++) {
+            for (uint32_t segment = 0; segment <= segments; segment++) {
+                float theta = glm::radians(180.0f) * ring / rings;
+                float phi = glm::radians(360.0f) * segment / segments;
+                glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                data.importedVertices.push_back({ glm::vec3(1000.0f, -250.0f, 40.0f) + normal * 3.0f, normal,
+                                                  glm::vec2(8.0f * segment / segments, 4.0f * ring / rings) });
+            }
+        }
+        data.meshes.push_back({ 0, static_cast<uint32_t>(data.importedVertices.size()), 0, 0, 0, 0, 0 });
+        data.vertices = data.importedVertices;
+    }
+
+    OGLR::QuantizationError worst;
+    bool within_bounds = true;
+    std::vector<OGLR::QuantizedVertex> quantized;
+    for (const OGLR::MeshData& mesh : data.meshes) {
+        std::span<const OGLR::Vertex> vertices = data.vertices.subspan(mesh.vertexOffset, mesh.vertexCount);
+        OGLR::VertexDequantization dequantization = OGLR::VertexQuantizer::Quantize(vertices, quantized);
+        OGLR::QuantizationError error = OGLR::VertexQuantizer::MeasureError(vertices, quantized, dequantization);
+        within_bounds &= error.IsWithinBounds();
+        worst.position = std::max(worst.position, error.position);
+        worst.positionBound = std::max(worst.positionBound, error.positionBound);
+        worst.normalDegrees = std::max(worst.normalDegrees, error.normalDegrees);
+        worst.texCoord = std::max(worst.texCoord, error.texCoord);
+    }
+    std::cout << "Position error up to " << worst.position << " (largest bound " << worst.positionBound << "), normals "
+              << worst.normalDegrees << " degrees (bound " << OGLR::VertexQuantizer::NORMAL_ERROR_BOUND_DEGREES << "), UVs "
+              << worst.texCoord << " relative (bound " << OGLR::VertexQuantizer::TEX_COORD_ERROR_BOUND << ")\n";
+    check(within_bounds, "every mesh within its error bounds");
+
+    double float_bytes = static_cast<double>(data.vertices.size()) * sizeof(OGLR::Vertex);
+    double quantized_bytes = static_cast<double>(data.vertices.size()) * sizeof(OGLR::QuantizedVertex);
+    double index_bytes = static_cast<double>(data.indices.size_bytes());
+    std::cout << data.meshes.size() << " meshes, " << data.vertices.size() << " vertices: "
+              << float_bytes / (1024.0 * 1024.0) << " MB -> " << quantized_bytes / (1024.0 * 1024.0) << " MB of vertices, "
+              << (float_bytes + index_bytes) / (1024.0 * 1024.0) << " MB -> " << (quantized_bytes + index_bytes) / (1024.0 * 1024.0)
+              << " MB with indices\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// Per-frame statistics of a trace written by a --null-gl --record run, as JSON to json_path or stdout
+static int ReplayTrace(const char* trace_path, const char* json_path) {
+    if (!json_path)
+        return OGLR::NullGL::ReplayTrace(trace_path, std::cout) ? 0 : 1;
+    std::ofstream json(json_path);
+    if (!json || !OGLR::NullGL::ReplayTrace(trace_path, json))
+        return 1;
+    std::cout << "Wrote " << json_path << '\n';
+    return 0;
+}
+
+// Frame 0 holds the loading, every later frame is one pass through the draw loop
+static void PrintNullGLSummary(const OGLR::FrameSummary& summary) {
+    const std::vector<OGLR::NullGLFrame>& frames = OGLR::NullGL::GetFrames();
+    if (frames.size() < 2)
+        return;
+    OGLR::NullGLFrame total;
+    for (size_t i = 1; i < frames.size(); i++) {
+        total.calls += frames[i].calls;
+        total.draws += frames[i].draws;
+        total.drawCommands += frames[i].drawCommands;
+        total.stateChanges += frames[i].stateChanges;
+        total.queries += frames[i].queries;
+        total.bytesUploaded += frames[i].bytesUploaded;
+    }
+    double count = static_cast<double>(frames.size() - 1);
+    std::cout << "Loading: " << frames[0].calls << " GL calls, " << frames[0].bytesUploaded / (1024.0 * 1024.0) << " MB uploaded\n";
+    std::cout << "Per frame over " << count << " frames: " << summary.cpu.avg << " ms CPU, "
+              << total.calls / count << " GL calls, " << total.draws / count << " draw calls, "
+              << total.drawCommands / count << " draw commands, " << total.stateChanges / count << " state changes, "
+              << total.queries / count << " queries, " << total.bytesUploaded / count << " bytes uploaded\n";
+}
+
+static void PrintFrameTimes(const char* name, const OGLR::FrameTimes& times) {
+    std::cout << name << " ms: min " << times.min << ", avg " << times.avg << ", p50 " << times.p50
+              << ", p95 " << times.p95 << ", p99 " << times.p99 << ", max " << times.max << '\n';
+}
 
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cerr << "Program expected 1 argument, received " << argc << '\n';
+    if (argc == 3 && std::string(argv[1]) == "--compress-textures")
+        return CompressTextures(argv[2]);
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--texture-psnr")
+        return TestTexturePSNR(argv[2], argc == 4 ? std::atof(argv[3]) : 30.0);
+    if (argc == 2 && std::string(argv[1]) == "--bench-culling")
+        return BenchmarkCulling();
+    if ((argc == 2 || argc == 3) && std::string(argv[1]) == "--bench-submit")
+        return BenchmarkSubmission(argc == 3 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2])))
+                                             : std::max(1u, std::thread::hardware_concurrency()));
+    if (argc == 3 && std::string(argv[1]) == "--occlusion-test")
+        return TestOcclusion(argv[2]);
+
+    if (argc >= 2 && std::string(argv[1]) == "--quantization-test")
+        return TestQuantization(argc >= 3 ? argv[2] : nullptr);
+
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--replay")
+        return ReplayTrace(argv[2], argc == 4 ? argv[3] : nullptr);
+
+    if (argc < 2) {
+        std::cerr << "Program expected a model path\n";
+        return -1;
+    }
+    bool quantize = false;
+    uint32_t headless_frames = 0;
+    bool benchmark = false;
+    const char* trace_path = nullptr;
+    const char* image_path = nullptr;
+    const char* csv_path = nullptr;
+    const char* json_path = nullptr;
+    float budget_ms = 1000.0f / 60.0f;
+    uint32_t upload_budget = OGLR::StagingUploader::GetFrameBudget();
+    uint32_t profile_frames = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quantize") {
+            quantize = true;
+        } else if (arg == "--null-gl" && i + 1 < argc) {
+            headless_frames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--benchmark" && i + 1 < argc) {
+            headless_frames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+            benchmark = true;
+        } else if (arg == "--record" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile_frames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--image" && i + 1 < argc) {
+            image_path = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (arg == "--budget" && i + 1 < argc) {
+            budget_ms = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--upload-budget" && i + 1 < argc) {
+            upload_budget = static_cast<uint32_t>(std::max(0.0625, std::atof(argv[++i])) * 1024 * 1024);
+        } else {
+            std::cerr << "Unknown argument " << arg << '\n';
+            return -1;
+        }
+    }
+    bool headless = headless_frames > 0;
+    if (trace_path && (!headless || benchmark)) {
+        std::cerr << "--record needs --null-gl\n";
+        return -1;
+    }
+    if (image_path && !benchmark) {
+        std::cerr << "--image needs --benchmark\n";
         return -1;
     }
 
     OGLR::WindowSpecs window_specs{};
     window_specs.vsync = true;
+    window_specs.backend = benchmark ? OGLR::GLBackend::OFFSCREEN : headless ? OGLR::GLBackend::NULL_GL : OGLR::GLBackend::NATIVE;
     OGLR::Window window(window_specs);
+    OGLR::Profiler::SetThreadName("Main");
+    if (trace_path)
+        OGLR::NullGL::StartRecording();
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glEnable(GL_DEPTH_TEST);
+    OGLR::GLState::SetEnabled(GL_DEPTH_TEST, true);
     //glEnable(GL_CULL_FACE);
     //glCullFace(GL_BACK);
 
-    std::unique_ptr<OGLR::Shader> default_shader = std::make_unique<OGLR::Shader>("res/shaders/default.glsl");
+    // Must outlive every model, each mesh owns a slot of its per-object block and a range of the arena.
+    // Streamed model and texture data is staged in the stream buffer too.
+    OGLR::StagingUploader::SetFrameBudget(upload_budget);
+    OGLR::StreamBuffer stream_buffer((4 << 20) + upload_budget);
+    OGLR::UniformBlocks uniform_blocks;
+    OGLR::GeometryArena geometry_arena(quantize ? OGLR::VertexFormat::QUANTIZED : OGLR::VertexFormat::FLOAT32);
+
+    // Compiled per light count, specular and normal map on first use
+    OGLR::ShaderVariants default_shaders("res/shaders/default.glsl");
     std::unique_ptr<OGLR::Shader> plane_shader = std::make_unique<OGLR::Shader>("res/shaders/bad_reflection.glsl");
-    OGLR::Model model(argv[1]);
+    OGLR::Scene scene;
+    OGLR::Model& model = scene.models.emplace_back(argv[1]);
+
+    // Resolved again whenever the shaders get reloaded
+    OGLR::UniformHandle<int> plane_texture_uniform;
+    auto resolve_uniforms = [&]() {
+        plane_texture_uniform = plane_shader->GetUniform<int>("renTexture");
+    };
+    resolve_uniforms();
 
     model.Rotate(-90, glm::vec3(1.0f, 0.0f, 0.0f));
     model.Scale(glm::vec3(0.01f));
+    scene.BuildBVH();
 
     OGLR::PointLight point_light;
     point_light.position = glm::vec3(0);
@@ -42,11 +581,13 @@ int main(int argc, char** argv) {
 
     bool point_mode = false;
     bool line_mode = false;
+    bool lod_enabled = true;
     float point_size = 1.0f;
 
+    const float far_plane = 1000.0f;
     glm::mat4 proj = glm::perspective(glm::radians(60.0f),
         static_cast<float>(window.GetWidth()) / static_cast<float>(window.GetHeight()),
-        0.01f, 1000.0f);
+        0.01f, far_plane);
     glm::mat4 view = glm::mat4(1.0f);
 
     OGLR::DirectionalLight dir_light;
@@ -76,7 +617,7 @@ int main(int argc, char** argv) {
         -0.5f,  0.5f, 0.0f, 0.0f, 1.0f
     };
 
-    std::vector<uint32_t> planeIndices {
+    std::vector<uint16_t> planeIndices {
         0, 1, 2,
         2, 3, 0
     };
@@ -94,14 +635,18 @@ int main(int argc, char** argv) {
     planeModel = glm::translate(planeModel, glm::vec3(0.0f, -10.0f, 0.0f));
     planeModel = glm::rotate(planeModel, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     planeModel = glm::scale(planeModel, glm::vec3(30.0f));
+    OGLR::ObjectSlot planeObject;
+    planeObject.Set(planeModel);
+
+    OGLR::RenderQueue render_queue;
 
     uint32_t fbo;
     glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    OGLR::GLState::BindFramebuffer(GL_FRAMEBUFFER, fbo);
 
     uint32_t renderTexture;
     glGenTextures(1, &renderTexture);
-    glBindTexture(GL_TEXTURE_2D, renderTexture);
+    OGLR::GLState::BindTexture(0, renderTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1920, 1080, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -119,25 +664,133 @@ int main(int argc, char** argv) {
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         return -5;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    int32_t orgFB;
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &orgFB);
+    OGLR::GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    uint32_t orgFB = window.GetFramebuffer();
+
+    // Headless runs step a fixed 60 Hz clock and turn the camera a full circle over all frames.
+    // Benchmarks render a few untimed frames first, drivers compile and allocate lazily on first use
+    // and llvmpipe's very first timer query reads back garbage.
+    const uint32_t warmup_frames = benchmark ? 10 : 0;
+    uint32_t frame_index = 0;
+    if (headless) {
+        // Every run should time the same scene, not however far loading got, benchmarks wait for the textures too
+        while (model.IsStreaming() || (benchmark && OGLR::TextureCache::Get().GetPendingCount() > 0)) {
+            stream_buffer.BeginFrame();
+            OGLR::StagingUploader::BeginFrame();
+            scene.Update();
+            OGLR::TextureCache::Get().Update();
+            stream_buffer.EndFrame();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // A benchmark reports on every frame it timed, the viewer on the last FrameStats::HISTORY
+    OGLR::FrameStats::Start(budget_ms, benchmark);
+    if (headless)
+        window.OnUpdate();
+    if (profile_frames > 0)
+        OGLR::Profiler::Capture(profile_frames, "profile.json");
 
     while (!window.ShouldClose()) {
-        float current_time = static_cast<float>(glfwGetTime());
+        OGLR::Profiler::BeginFrame();
+        if (benchmark && frame_index == warmup_frames)
+            OGLR::FrameStats::Reset();
+        OGLR::FrameStats::BeginFrame();
+        OGLR_PROFILE_ZONE("Frame");
+        float current_time = headless ? frame_index / 60.0f : static_cast<float>(glfwGetTime());
         delta_time = current_time - last_time;
         last_time = current_time;
+        stream_buffer.BeginFrame();
+        OGLR::StagingUploader::BeginFrame();
+
+        if (OGLR::Input::KeyPressed(GLFW_KEY_I)) {
+            const OGLR::UniformStats& stats = OGLR::Shader::GetStats();
+            std::cout << "Last frame: " << stats.locationLookups << " uniform location lookups, "
+                      << stats.stringAllocations << " uniform name strings\n";
+            const OGLR::RenderQueueStats& queue_stats = render_queue.GetStats();
+            std::cout << "Last frame: " << queue_stats.draws << " draws in " << queue_stats.multiDraws << " multi-draws, "
+                      << queue_stats.programSwitches << " program switches, "
+                      << queue_stats.materialBinds << " material binds, " << queue_stats.vertexArrayBinds << " vertex array binds, "
+                      << queue_stats.bindsElided << " binds elided\n";
+            const OGLR::CullingStats& culling_stats = OGLR::FrustumCuller::GetStats();
+            std::cout << "Last frame: " << culling_stats.visible << " of " << culling_stats.tested << " meshes inside the frustum, "
+                      << culling_stats.nodesVisited << " BVH nodes visited\n";
+            const OGLR::OcclusionStats& occlusion_stats = scene.occlusion.GetStats();
+            std::cout << "Last frame: " << occlusion_stats.occluded << " of " << occlusion_stats.tested << " meshes occluded, "
+                      << occlusion_stats.rasterizedTriangles << " of " << occlusion_stats.occluderTriangles << " occluder triangles rasterized\n";
+            const OGLR::LODStats& lod_stats = OGLR::Mesh::GetLODStats();
+            std::cout << "Last frame: " << lod_stats.trianglesDrawn << " triangles drawn, " << lod_stats.trianglesFullDetail
+                      << " at full detail, meshes per LOD:";
+            for (uint32_t count : lod_stats.meshesPerLevel)
+                std::cout << ' ' << count;
+            std::cout << '\n';
+            const OGLR::StreamStats& stream_stats = stream_buffer.GetStats();
+            const OGLR::GLStateStats& state_stats = OGLR::GLState::GetStats();
+            std::cout << "Last frame: " << state_stats.issued << " GL state calls issued, " << state_stats.elided << " elided\n";
+            std::cout << default_shaders.GetCount() << " variants of the default shader compiled\n";
+            std::cout << "Last frame: " << stream_stats.bytesStreamed << " bytes streamed in " << stream_stats.allocations
+                      << " allocations, " << stream_stats.fenceStalls << " fence stalls (" << stream_stats.stallMs << " ms), buffer "
+                      << stream_stats.bufferSize / (1024.0 * 1024.0) << " MB after " << stream_stats.totalGrows << " grows\n";
+            const OGLR::GeometryArenaStats& arena_stats = geometry_arena.GetStats();
+            std::cout << "Geometry arena: " << geometry_arena.GetUsedVertices() << " of " << geometry_arena.GetVertexCapacity() << " vertices after "
+                      << arena_stats.vertexGrows << " grows, " << geometry_arena.GetUsedIndexSlots() << " of "
+                      << geometry_arena.GetIndexSlotCapacity() << " index slots after " << arena_stats.indexGrows << " grows\n";
+            const OGLR::StagingStats& staging_stats = OGLR::StagingUploader::GetStats();
+            std::cout << "Last frame: " << staging_stats.bytesUploaded << " bytes of loading data staged in " << staging_stats.bufferCopies
+                      << " buffer and " << staging_stats.textureCopies << " texture copies, budget "
+                      << OGLR::StagingUploader::GetFrameBudget() << " bytes\n";
+            OGLR::FrameSummary frame_summary = OGLR::FrameStats::GetSummary();
+            std::cout << "Last " << frame_summary.frames << " frames: " << frame_summary.hitches << " over the "
+                      << OGLR::FrameStats::GetBudget() << " ms budget\n";
+            PrintFrameTimes("CPU", frame_summary.cpu);
+            PrintFrameTimes("GPU", frame_summary.gpu);
+        }
+        OGLR::Shader::ResetStats();
+        OGLR::FrustumCuller::ResetStats();
+        scene.occlusion.ResetStats();
+        OGLR::Mesh::ResetLODStats();
+        OGLR::GLState::ResetStats();
+
+        if (OGLR::Input::KeyPressed(GLFW_KEY_T))
+            OGLR::Profiler::Capture(120, "profile.json");
+        if (OGLR::Input::KeyPressed(GLFW_KEY_C)) {
+            scene.occlusion_culling = !scene.occlusion_culling;
+            std::cout << "Occlusion culling " << (scene.occlusion_culling ? "on" : "off") << '\n';
+        }
+        if (OGLR::Input::KeyPressed(GLFW_KEY_L)) {
+            lod_enabled = !lod_enabled;
+            std::cout << "LOD selection " << (lod_enabled ? "on" : "off") << '\n';
+        }
+        if (OGLR::Input::KeyPressed(GLFW_KEY_O) && scene.occlusion.WriteDebugImage("occlusion.pgm"))
+            std::cout << "Wrote occlusion.pgm\n";
 
         if (OGLR::Input::KeyPressed(GLFW_KEY_P))
             OGLR::Input::UnLockMouse();
         if (OGLR::Input::KeyPressed(GLFW_KEY_U))
             OGLR::Input::LockMouse();
 
+        // Clicking with a free cursor picks the mesh under it
+        if (!OGLR::Input::IsMouseLocked() && OGLR::Input::MouseButtonPressed(GLFW_MOUSE_BUTTON_LEFT)) {
+            auto [mouse_x, mouse_y] = OGLR::Input::GetMousePosition();
+            float ndc_x = 2.0f * mouse_x / window.GetWidth() - 1.0f;
+            float ndc_y = 1.0f - 2.0f * mouse_y / window.GetHeight();
+            glm::mat4 inverse_view_proj = glm::inverse(proj * view);
+            glm::vec4 near_point = inverse_view_proj * glm::vec4(ndc_x, ndc_y, -1.0f, 1.0f);
+            glm::vec4 far_point = inverse_view_proj * glm::vec4(ndc_x, ndc_y, 1.0f, 1.0f);
+
+            OGLR::Ray ray;
+            ray.origin = glm::vec3(near_point) / near_point.w;
+            ray.direction = glm::normalize(glm::vec3(far_point) / far_point.w - ray.origin);
+            OGLR::SceneItem picked;
+            float distance = 0.0f;
+            if (scene.Pick(ray, picked, distance))
+                std::cout << "Picked mesh " << picked.mesh << " of " << scene.models[picked.model].GetPath() << " at " << distance << '\n';
+        }
+
         if (OGLR::Input::KeyPressed(GLFW_KEY_K))
-            glPointSize(++point_size);
+            point_size++;
         else if (OGLR::Input::KeyPressed(GLFW_KEY_J))
-            glPointSize(--point_size);
+            point_size--;
 
         if (OGLR::Input::KeyPressed(GLFW_KEY_F))
             point_mode = !point_mode;
@@ -158,8 +811,9 @@ int main(int argc, char** argv) {
             cam_pos.y -= 12 * delta_time;
 
         if (OGLR::Input::KeyPressed(GLFW_KEY_H)) {
-            default_shader.reset(new OGLR::Shader("res/shaders/default.glsl"));
+            default_shaders.Reload();
             plane_shader.reset(new OGLR::Shader("res/shaders/bad_reflection.glsl"));
+            resolve_uniforms();
         }
 
         if (OGLR::Input::KeyHeld(GLFW_KEY_UP))
@@ -189,56 +843,129 @@ int main(int argc, char** argv) {
             cam_front = glm::normalize(cam_dir);
             cam_right = glm::cross(cam_front, glm::vec3(0.0f, 1.0f, 0.0f));
         }
+        if (headless) {
+            uint32_t path_frame = frame_index > warmup_frames ? frame_index - warmup_frames : 0;
+            yaw = -90.0f + 360.0f * path_frame / headless_frames;
+            cam_dir = glm::vec3(cos(glm::radians(yaw)), 0.0f, sin(glm::radians(yaw)));
+            cam_front = glm::normalize(cam_dir);
+            cam_right = glm::cross(cam_front, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
 
-        if (point_mode)
-            glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
-        else
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-        if (line_mode && !point_mode)
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        else if (!point_mode)
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        OGLR::GLState::PolygonMode(point_mode ? GL_POINT : line_mode ? GL_LINE : GL_FILL);
+        OGLR::GLState::PointSize(point_size);
         view = glm::lookAt(cam_pos, cam_pos + cam_front, glm::vec3(0.0, 1.0, 0.0));  
+        {
+            // Meshes get the upload budget first, a model is usable long before its textures are
+            OGLR_FRAME_ZONE("Update");
+            scene.Update();
+            OGLR::TextureCache::Get().Update();
+        }
+
+        {
+            OGLR_FRAME_ZONE("Submit");
+            // Both passes share one camera, so frame and light data go up once per frame
+            uniform_blocks.SetFrame(view, proj);
+            std::vector<OGLR::DirectionalLight> dir_lights = { dir_light };
+            std::vector<OGLR::PointLight> point_lights;
+            uniform_blocks.SetLights(dir_lights, point_lights, view);
+            uniform_blocks.Flush();
+
+            render_queue.Begin(far_plane);
+            // Both passes look through the same camera today, each one still culls against its own frustum
+            // LODs are picked per pass, the offscreen target has its own resolution
+            OGLR::LODSelection offscreen_lod, main_lod;
+            if (lod_enabled) {
+                offscreen_lod = OGLR::LODSelection::FromProjection(proj, 1080.0f);
+                main_lod = OGLR::LODSelection::FromProjection(proj, static_cast<float>(window.GetHeight()));
+            }
+            // Culling and draw lists are built on the workers, the passes below only bind and draw
+            OGLR::ThreadPool& pool = OGLR::ThreadPool::Get();
+            // The lighting loops are specialized on this frame's light counts, workers only pick per material
+            uint32_t dir_count = std::min<uint32_t>(static_cast<uint32_t>(dir_lights.size()), OGLR::MAX_DIR_LIGHTS);
+            uint32_t point_count = std::min<uint32_t>(static_cast<uint32_t>(point_lights.size()), OGLR::MAX_POINT_LIGHTS);
+            OGLR::ShaderDefines light_defines = {
+                { "DIR_LIGHT_COUNT", std::to_string(dir_count) },
+                { "POINT_LIGHT_COUNT", std::to_string(point_count) }
+            };
+            OGLR::MaterialShaders default_shader;
+            default_shader.specularMapped = default_shaders.Get(light_defines);
+            light_defines.push_back({ "NORMAL_MAP", "1" });
+            default_shader.normalSpecularMapped = default_shaders.Get(light_defines);
+            light_defines.back() = { "SPECULAR_MAP", "0" };
+            default_shader.unmapped = default_shaders.Get(light_defines);
+            light_defines.push_back({ "NORMAL_MAP", "1" });
+            default_shader.normalMapped = default_shaders.Get(light_defines);
+            scene.Submit(render_queue, OGLR::OFFSCREEN_PASS, default_shader, view, proj, offscreen_lod, &pool);
+            scene.Submit(render_queue, OGLR::MAIN_PASS, default_shader, view, proj, main_lod, &pool);
+            render_queue.Prepare(&pool);
+        }
 
-        default_shader->Bind();
-        default_shader->SetUniform3f("dir_lights[0].direction", glm::normalize(glm::mat3(view) * glm::normalize(dir_light.direction)));
-        default_shader->SetUniform3f("dir_lights[0].color", dir_light.color);
-        default_shader->SetUniform1f("dir_lights[0].intensity", dir_light.intensity);
-        default_shader->SetUniform1i("dir_lights_count", 1);
-
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
-        glViewport(0, 0, 1920, 1080);
-        glClearColor(1, 1, 1, 1);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        model.Draw(default_shader.get(), view, proj);
-        glGenerateTextureMipmap(renderTexture);
-
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, orgFB);
-        glViewport(0, 0, window.GetWidth(), window.GetHeight());
-        glClearColor(35.0f/255, 35.0f/255, 35.0f/255, 1);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        model.Draw(default_shader.get(), view, proj);
-
-        glm::mat4 mvp = proj * view * planeModel;
-        glm::mat4 mv = view * planeModel;
-        glm::mat4 mv_norm = glm::transpose(glm::inverse(mv));
-
-        plane_shader->Bind();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, renderTexture);
-        plane_shader->SetUniformMatrix4("mvMatrix", mv);
-        plane_shader->SetUniformMatrix4("normalMatrix", mv_norm);
-        plane_shader->SetUniformMatrix4("mvp", mvp);
-        plane_shader->SetUniform1i("renTexture", 0);
-
-        planeVA.Bind();
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-        planeVA.UnBind();
-        glBindTexture(GL_TEXTURE_2D, 0);
+        {
+            OGLR_FRAME_ZONE("Reflection pass");
+            OGLR_PROFILE_GPU_ZONE("Reflection pass");
+            OGLR::GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+            OGLR::GLState::Viewport(0, 0, 1920, 1080);
+            OGLR::GLState::ClearColor(glm::vec4(1.0f));
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            render_queue.Execute(OGLR::OFFSCREEN_PASS);
+            glGenerateTextureMipmap(renderTexture);
+        }
 
-        window.OnUpdate();
+        {
+            OGLR_FRAME_ZONE("Main pass");
+            OGLR_PROFILE_GPU_ZONE("Main pass");
+            OGLR::GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, orgFB);
+            OGLR::GLState::Viewport(0, 0, window.GetWidth(), window.GetHeight());
+            OGLR::GLState::ClearColor(glm::vec4(35.0f/255, 35.0f/255, 35.0f/255, 1));
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            render_queue.Execute(OGLR::MAIN_PASS);
+        }
+
+        {
+            OGLR_FRAME_ZONE("Plane pass");
+            OGLR_PROFILE_GPU_ZONE("Plane pass");
+            plane_shader->Bind();
+            OGLR::GLState::BindTexture(0, renderTexture);
+            plane_shader->SetUniform(plane_texture_uniform, 0);
+
+            // The base instance selects the plane's ObjectData entry, same as the queued draws
+            planeVA.Bind();
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, planeIB.GetCount(), OGLR::GetGLIndexType(planeIB.GetType()), nullptr, 1, planeObject.Get());
+        }
+
+        stream_buffer.EndFrame();
+        // Streamed meshes and textures are staged through the stream buffer as well
+        uint64_t bytes_uploaded = stream_buffer.GetStats().bytesStreamed;
+        // The plane is drawn outside the queue
+        OGLR::FrameStats::EndFrame(render_queue.GetCurrentStats().draws + 1, OGLR::Mesh::GetLODStats().trianglesDrawn + planeIB.GetCount() / 3,
+                                   bytes_uploaded);
+        {
+            OGLR_PROFILE_ZONE("Present");
+            window.OnUpdate();
+        }
+
+        if (headless && ++frame_index == headless_frames + warmup_frames)
+            window.Close();
     }
 
+    OGLR::Profiler::Flush();
+    OGLR::FrameStats::Finish();
+    OGLR::FrameSummary frame_summary = OGLR::FrameStats::GetSummary();
+    if (benchmark) {
+        std::cout << frame_summary.frames << " frames at " << window.GetWidth() << 'x' << window.GetHeight() << ", "
+                  << frame_summary.hitches << " over the " << budget_ms << " ms budget\n";
+        PrintFrameTimes("CPU", frame_summary.cpu);
+        PrintFrameTimes("GPU", frame_summary.gpu);
+        if (image_path && window.WriteImage(image_path))
+            std::cout << "Wrote " << image_path << '\n';
+    } else if (headless) {
+        PrintNullGLSummary(frame_summary);
+        if (trace_path && OGLR::NullGL::WriteTrace(trace_path))
+            std::cout << "Wrote " << trace_path << '\n';
+    }
+    if (csv_path && OGLR::FrameStats::WriteCSV(csv_path))
+        std::cout << "Wrote " << csv_path << '\n';
+    if (json_path && OGLR::FrameStats::WriteJSON(json_path))
+        std::cout << "Wrote " << json_path << '\n';
     return 0;
 }
@@ -0,0 +1,112 @@
+#include <mapped_file.h>
+
+#include <utility>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace OGLR {
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path) {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return;
+        }
+
+        mFileHandle = file;
+        mMappingHandle = mapping;
+        mData = static_cast<const uint8_t*>(data);
+        mSize = static_cast<size_t>(size.QuadPart);
+    }
+
+    void MappedFile::unmap() {
+        if (mData)
+            UnmapViewOfFile(mData);
+        if (mMappingHandle)
+            CloseHandle(mMappingHandle);
+        if (mFileHandle)
+            CloseHandle(mFileHandle);
+        mData = nullptr;
+        mSize = 0;
+        mFileHandle = nullptr;
+        mMappingHandle = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file
+        close(fd);
+        if (data == MAP_FAILED)
+            return;
+
+        mData = static_cast<const uint8_t*>(data);
+        mSize = static_cast<size_t>(info.st_size);
+    }
+
+    void MappedFile::unmap() {
+        if (mData)
+            munmap(const_cast<uint8_t*>(mData), mSize);
+        mData = nullptr;
+        mSize = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile() {
+        unmap();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            std::swap(mData, other.mData);
+            std::swap(mSize, other.mSize);
+#ifdef _WIN32
+            std::swap(mFileHandle, other.mFileHandle);
+            std::swap(mMappingHandle, other.mMappingHandle);
+#endif
+        }
+        return *this;
+    }
+
+}
@@ -0,0 +1,132 @@
+#include <offscreen_context.h>
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+#ifdef OGLR_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#endif
+
+namespace OGLR {
+
+#ifdef OGLR_EGL
+
+    namespace {
+
+        bool hasExtension(const char* extensions, const char* name) {
+            if (!extensions)
+                return false;
+            size_t length = std::strlen(name);
+            for (const char* found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+                bool starts = found == extensions || found[-1] == ' ';
+                bool ends = found[length] == ' ' || found[length] == '\0';
+                if (starts && ends)
+                    return true;
+            }
+            return false;
+        }
+
+        // The surfaceless platform needs neither a display server nor a GPU, fall back to the default display
+        EGLDisplay getDisplay() {
+            const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+            if (hasExtension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+                auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+                if (get_platform_display) {
+                    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                    if (display != EGL_NO_DISPLAY)
+                        return display;
+                }
+            }
+            return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+    }
+
+    OffscreenContext::~OffscreenContext() {
+        if (!mDisplay)
+            return;
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (mContext)
+            eglDestroyContext(mDisplay, mContext);
+        if (mSurface)
+            eglDestroySurface(mDisplay, mSurface);
+        eglTerminate(mDisplay);
+    }
+
+    bool OffscreenContext::Create(uint32_t major, uint32_t minor) {
+        EGLDisplay display = getDisplay();
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            std::cerr << "ERROR::EGL::NO_DISPLAY\n";
+            return false;
+        }
+        mDisplay = display;
+
+        const EGLint config_attributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+            std::cerr << "ERROR::EGL::NO_CONFIG\n";
+            return false;
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "ERROR::EGL::NO_OPENGL_API\n";
+            return false;
+        }
+        const EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, static_cast<EGLint>(major),
+            EGL_CONTEXT_MINOR_VERSION, static_cast<EGLint>(minor),
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        mContext = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+        if (mContext == EGL_NO_CONTEXT) {
+            mContext = nullptr;
+            std::cerr << "ERROR::EGL::NO_CONTEXT " << major << '.' << minor << '\n';
+            return false;
+        }
+
+        if (!hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+            const EGLint surface_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            mSurface = eglCreatePbufferSurface(display, config, surface_attributes);
+            if (mSurface == EGL_NO_SURFACE) {
+                mSurface = nullptr;
+                std::cerr << "ERROR::EGL::NO_SURFACE\n";
+                return false;
+            }
+        }
+        EGLSurface surface = mSurface ? mSurface : EGL_NO_SURFACE;
+        if (!eglMakeCurrent(display, surface, surface, mContext)) {
+            std::cerr << "ERROR::EGL::MAKE_CURRENT\n";
+            return false;
+        }
+
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+            std::cerr << "ERROR::EGL::GLAD\n";
+            return false;
+        }
+        std::cout << "Offscreen context: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << '\n';
+        return true;
+    }
+
+#else
+
+    OffscreenContext::~OffscreenContext() = default;
+
+    bool OffscreenContext::Create(uint32_t, uint32_t) {
+        std::cerr << "Built without EGL, configure with -DOGLR_ENABLE_EGL=ON for windowless contexts\n";
+        return false;
+    }
+
+#endif
+
+}
@@ -0,0 +1,205 @@
+#include <profiler.h>
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace OGLR {
+
+    namespace {
+
+        void writeString(std::ostream& json, const std::string& text) {
+            json << '"';
+            for (char c : text) {
+                if (c == '"' || c == '\\')
+                    json << '\\';
+                json << c;
+            }
+            json << '"';
+        }
+
+        // Chrome traces count in microseconds
+        void writeEvent(std::ostream& json, const ProfileEvent& event, uint32_t pid, uint32_t tid, int64_t origin) {
+            json << ",\n{\"name\":";
+            writeString(json, event.name);
+            json << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+                 << ",\"ts\":" << (event.start - origin) / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << '}';
+        }
+
+        void writeName(std::ostream& json, const char* kind, uint32_t pid, uint32_t tid, const std::string& name) {
+            json << ",\n{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"name\":";
+            writeString(json, name);
+            json << "}}";
+        }
+
+    }
+
+    void Profiler::Capture(uint32_t frame_count, const std::string& path) {
+        if (IsCapturing())
+            return;
+        {
+            // A zone ending right now may still publish into the old capture, its events are filtered by capture
+            std::lock_guard<std::mutex> lock(mThreadsMutex);
+            for (std::unique_ptr<ThreadBuffer>& buffer : mThreads)
+                buffer->count.store(0, std::memory_order_relaxed);
+        }
+        mGpuEvents.clear();
+        mGpuDropped = 0;
+        if (mGpuQueries.empty()) {
+            mGpuQueries.resize(GPU_LATENCY * MAX_GPU_ZONES * 2);
+            glGenQueries(static_cast<GLsizei>(mGpuQueries.size()), mGpuQueries.data());
+        }
+
+        // Both clocks read back to back, good to well under a microsecond on the trace
+        GLint64 gpu_now = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+        mCaptureStart = Now();
+        mGpuClockOffset = mCaptureStart - gpu_now;
+
+        mFramesLeft = frame_count;
+        mPath = path;
+        mCapture.fetch_add(1, std::memory_order_relaxed);
+        mCapturing.store(true, std::memory_order_release);
+        std::cout << "Profiling " << frame_count << " frames\n";
+    }
+
+    void Profiler::BeginFrame() {
+        mGpuSlot = (mGpuSlot + 1) % GPU_LATENCY;
+        if (!mGpuZones[mGpuSlot].empty())
+            collectGPU(mGpuSlot, false);
+        if (IsCapturing() && mFramesLeft-- == 0)
+            finish();
+    }
+
+    void Profiler::Flush() {
+        if (IsCapturing())
+            finish();
+    }
+
+    void Profiler::SetThreadName(const std::string& name) {
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        buffer.name = name;
+    }
+
+    int64_t Profiler::Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Profiler::RecordCPU(const char* name, int64_t start, int64_t end) {
+        ThreadBuffer& buffer = threadBuffer();
+        uint32_t index = buffer.count.load(std::memory_order_relaxed);
+        if (index >= EVENTS_PER_THREAD)
+            return;
+        if (buffer.events.empty())
+            buffer.events.resize(EVENTS_PER_THREAD);
+        buffer.events[index] = { name, start, end - start, mCapture.load(std::memory_order_relaxed) };
+        buffer.count.store(index + 1, std::memory_order_release);
+    }
+
+    uint32_t Profiler::BeginGPU(const char* name) {
+        std::vector<const char*>& zones = mGpuZones[mGpuSlot];
+        if (zones.size() == MAX_GPU_ZONES) {
+            mGpuDropped++;
+            return UINT32_MAX;
+        }
+        uint32_t zone = mGpuSlot * MAX_GPU_ZONES + static_cast<uint32_t>(zones.size());
+        zones.push_back(name);
+        glQueryCounter(mGpuQueries[zone * 2], GL_TIMESTAMP);
+        return zone;
+    }
+
+    void Profiler::EndGPU(uint32_t zone) {
+        glQueryCounter(mGpuQueries[zone * 2 + 1], GL_TIMESTAMP);
+    }
+
+    Profiler::ThreadBuffer& Profiler::threadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(mThreadsMutex);
+            std::unique_ptr<ThreadBuffer>& created = mThreads.emplace_back(std::make_unique<ThreadBuffer>());
+            created->id = static_cast<uint32_t>(mThreads.size());
+            created->name = "Thread " + std::to_string(created->id);
+            buffer = created.get();
+        }
+        return *buffer;
+    }
+
+    void Profiler::collectGPU(uint32_t slot, bool wait) {
+        std::vector<const char*>& zones = mGpuZones[slot];
+        uint32_t first = slot * MAX_GPU_ZONES;
+        // Nested zones end after the zones inside them, so the last zone's end query isn't the newest one.
+        // Every query of the frame is checked, stopping at the first that isn't back yet.
+        GLint available = GL_TRUE;
+        if (!wait) {
+            uint32_t last_query = (first + static_cast<uint32_t>(zones.size())) * 2;
+            for (uint32_t query = first * 2; query < last_query && available; query++)
+                glGetQueryObjectiv(mGpuQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (!available) {
+            mGpuDropped += static_cast<uint32_t>(zones.size());
+            zones.clear();
+            return;
+        }
+
+        uint32_t capture = mCapture.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < zones.size(); i++) {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(mGpuQueries[(first + i) * 2], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(mGpuQueries[(first + i) * 2 + 1], GL_QUERY_RESULT, &end);
+            mGpuEvents.push_back({ zones[i], static_cast<int64_t>(begin) + mGpuClockOffset, static_cast<int64_t>(end - begin), capture });
+        }
+        zones.clear();
+    }
+
+    void Profiler::finish() {
+        mCapturing.store(false, std::memory_order_relaxed);
+        // One stall when the capture ends, the last frames' queries aren't back yet
+        for (uint32_t slot = 0; slot < GPU_LATENCY; slot++) {
+            if (!mGpuZones[slot].empty())
+                collectGPU(slot, true);
+        }
+        if (writeTrace(mPath))
+            std::cout << "Wrote " << mPath << '\n';
+    }
+
+    bool Profiler::writeTrace(const std::string& path) {
+        std::ofstream json(path);
+        if (!json) {
+            std::cerr << "ERROR::PROFILER::COULDN'T_WRITE " << path << '\n';
+            return false;
+        }
+
+        uint32_t capture = mCapture.load(std::memory_order_relaxed);
+        uint32_t dropped = mGpuDropped;
+        json << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        json << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}}";
+        writeName(json, "process_name", 2, 0, "GPU");
+        writeName(json, "thread_name", 2, 0, "GL");
+        {
+            std::lock_guard<std::mutex> lock(mThreadsMutex);
+            for (const std::unique_ptr<ThreadBuffer>& buffer : mThreads) {
+                uint32_t count = buffer->count.load(std::memory_order_acquire);
+                if (count == 0)
+                    continue;
+                writeName(json, "thread_name", 1, buffer->id, buffer->name);
+                dropped += count == EVENTS_PER_THREAD;
+                for (uint32_t i = 0; i < count; i++) {
+                    if (buffer->events[i].capture == capture)
+                        writeEvent(json, buffer->events[i], 1, buffer->id, mCaptureStart);
+                }
+            }
+        }
+        for (const ProfileEvent& event : mGpuEvents)
+            writeEvent(json, event, 2, 0, mCaptureStart);
+        json << "\n]}\n";
+
+        if (dropped > 0)
+            std::cout << "Profiler dropped events, " << mGpuDropped << " GPU zones and " << dropped - mGpuDropped << " full thread buffers\n";
+        return static_cast<bool>(json);
+    }
+
+}
@@ -0,0 +1,124 @@
+#include <scene.h>
+#include <profiler.h>
+#include <thread_pool.h>
+
+namespace OGLR {
+
+    void Scene::BuildBVH() {
+        bvh_items.clear();
+        mModelFirstItem.clear();
+        mModelVersions.clear();
+        mModelMeshCounts.clear();
+        std::vector<AABB> bounds;
+        for (uint32_t model = 0; model < models.size(); model++) {
+            mModelFirstItem.push_back(static_cast<uint32_t>(bvh_items.size()));
+            mModelVersions.push_back(models[model].GetTransformVersion());
+            mModelMeshCounts.push_back(models[model].GetMeshCount());
+            for (uint32_t mesh = 0; mesh < models[model].GetMeshCount(); mesh++) {
+                bvh_items.push_back({ model, mesh });
+                bounds.push_back(models[model].GetMeshBounds(mesh));
+            }
+        }
+        bvh.Build(bounds);
+        mOcclusionValid = false;
+        mFramesSinceBuild = 0;
+    }
+
+    void Scene::Update() {
+        OGLR_PROFILE_ZONE("Scene::Update");
+        bool rebuild = false;
+        bool grown = false;
+        for (uint32_t model = 0; model < models.size(); model++) {
+            models[model].Update();
+            if (model >= mModelVersions.size()) {
+                rebuild = true;
+                continue;
+            }
+            // The rebuild picks up the new meshes, until then the ones already in the BVH are refit below
+            if (models[model].GetMeshCount() != mModelMeshCounts[model]) {
+                grown = true;
+                rebuild |= !models[model].IsStreaming();
+            }
+            if (models[model].GetTransformVersion() == mModelVersions[model])
+                continue;
+
+            mModelVersions[model] = models[model].GetTransformVersion();
+            mOcclusionValid = false;
+            for (uint32_t mesh = 0; mesh < mModelMeshCounts[model]; mesh++)
+                bvh.Update(mModelFirstItem[model] + mesh, models[model].GetMeshBounds(mesh));
+        }
+        mFramesSinceBuild++;
+        if (rebuild || (grown && mFramesSinceBuild >= STREAMING_REBUILD_FRAMES))
+            BuildBVH();
+    }
+
+    void Scene::Submit(RenderQueue& queue, RenderPass pass, const MaterialShaders& shaders, const glm::mat4& view, const glm::mat4& proj,
+                       const LODSelection& lod, ThreadPool* pool) {
+        OGLR_PROFILE_ZONE("Scene::Submit");
+        glm::mat4 view_proj = proj * view;
+        bvh.CullFrustum(Frustum::FromMatrix(view_proj), mVisible);
+        if (occlusion_culling)
+            updateOcclusion(view_proj);
+
+        uint32_t visible_count = static_cast<uint32_t>(mVisible.size());
+        uint32_t range_count = (visible_count + SUBMIT_GRAIN - 1) / SUBMIT_GRAIN;
+        uint32_t first_list = queue.AddDrawLists(range_count);
+        mRangeStats.assign(range_count, {});
+        auto submit_range = [&](uint32_t range, uint32_t begin, uint32_t end) {
+            OGLR_PROFILE_ZONE("Scene::Submit range");
+            DrawList& list = queue.GetDrawList(first_list + range);
+            RangeStats& stats = mRangeStats[range];
+            for (uint32_t i = begin; i < end; i++) {
+                uint32_t item = mVisible[i];
+                if (occlusion_culling && !occlusion.IsVisible(bvh.GetItemBounds(item), stats.occlusion))
+                    continue;
+                models[bvh_items[item].model].SubmitMesh(bvh_items[item].mesh, list, pass, shaders, view, lod, stats.lod);
+            }
+        };
+        if (pool) {
+            pool->ParallelFor(visible_count, SUBMIT_GRAIN, submit_range);
+        } else {
+            for (uint32_t range = 0; range < range_count; range++)
+                submit_range(range, range * SUBMIT_GRAIN, std::min(visible_count, (range + 1) * SUBMIT_GRAIN));
+        }
+
+        for (const RangeStats& stats : mRangeStats) {
+            occlusion.AddStats(stats.occlusion);
+            Mesh::AddLODStats(stats.lod);
+        }
+    }
+
+    void Scene::updateOcclusion(const glm::mat4& view_proj) {
+        // Passes sharing a camera reuse the buffer
+        if (mOcclusionValid && view_proj == mOcclusionViewProj)
+            return;
+
+        OGLR_PROFILE_ZONE("Scene::updateOcclusion");
+        occlusion.Begin(view_proj);
+        for (const Model& model : models) {
+            for (const OccluderMesh& occluder : model.GetOccluders())
+                occlusion.RasterizeOccluder(occluder, model.GetModelMatrix());
+        }
+        occlusion.End();
+        mOcclusionViewProj = view_proj;
+        mOcclusionValid = true;
+    }
+
+    bool Scene::Pick(const Ray& ray, SceneItem& item, float& distance) const {
+        RayHit hit;
+        if (!bvh.Raycast(ray, hit))
+            return false;
+        item = bvh_items[hit.item];
+        distance = hit.distance;
+        return true;
+    }
+
+    void Scene::GetMeshesInSphere(const glm::vec3& center, float radius, std::vector<SceneItem>& items) const {
+        std::vector<uint32_t> overlapping;
+        bvh.OverlapSphere(center, radius, overlapping);
+        items.clear();
+        for (uint32_t item : overlapping)
+            items.push_back(bvh_items[item]);
+    }
+
+}
@@ -0,0 +1,122 @@
+#include <thread_pool.h>
+#include <profiler.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace OGLR {
+
+    ThreadPool::ThreadPool(uint32_t thread_count) {
+        if (thread_count == 0) {
+            // hardware_concurrency() may report 0 when it can't tell
+            uint32_t core_count = std::max(1u, std::thread::hardware_concurrency());
+            thread_count = std::max(1u, core_count - 1);
+        }
+
+        mThreads.reserve(thread_count);
+        for (uint32_t i = 0; i < thread_count; i++)
+            mThreads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mJobAvailable.notify_all();
+        for (std::thread& thread : mThreads)
+            thread.join();
+    }
+
+    void ThreadPool::Submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back(std::move(job));
+        }
+        mJobAvailable.notify_one();
+    }
+
+    void ThreadPool::Wait() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobsDone.wait(lock, [this]() { return mJobs.empty() && mActiveJobs == 0; });
+    }
+
+    void ThreadPool::ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t, uint32_t)>& body) {
+        grain = std::max(grain, 1u);
+        // Rounded up without forming count + grain, which overflows for counts near UINT32_MAX
+        uint32_t range_count = count / grain + (count % grain != 0);
+        if (range_count == 0)
+            return;
+
+        // Shared with the helper jobs, one that starts after the caller returned must still find the counter
+        struct Ranges {
+            std::function<void(uint32_t, uint32_t, uint32_t)> body;
+            uint32_t count;
+            uint32_t grain;
+            uint32_t rangeCount;
+            std::atomic<uint32_t> next = 0;
+            std::atomic<uint32_t> done = 0;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto ranges = std::make_shared<Ranges>();
+        ranges->body = body;
+        ranges->count = count;
+        ranges->grain = grain;
+        ranges->rangeCount = range_count;
+
+        auto run = [](Ranges& ranges) {
+            uint32_t range;
+            while ((range = ranges.next.fetch_add(1, std::memory_order_relaxed)) < ranges.rangeCount) {
+                uint32_t begin = range * ranges.grain;
+                ranges.body(range, begin, begin + std::min(ranges.grain, ranges.count - begin));
+                if (ranges.done.fetch_add(1, std::memory_order_acq_rel) + 1 == ranges.rangeCount) {
+                    std::lock_guard<std::mutex> lock(ranges.mutex);
+                    ranges.finished.notify_all();
+                }
+            }
+        };
+
+        uint32_t helpers = std::min(GetThreadCount(), range_count - 1);
+        for (uint32_t i = 0; i < helpers; i++)
+            Submit([ranges, run]() { run(*ranges); });
+        run(*ranges);
+
+        std::unique_lock<std::mutex> lock(ranges->mutex);
+        ranges->finished.wait(lock, [&ranges]() { return ranges->done.load(std::memory_order_acquire) == ranges->rangeCount; });
+    }
+
+    ThreadPool& ThreadPool::Get() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::workerLoop(uint32_t index) {
+        Profiler::SetThreadName("Worker " + std::to_string(index));
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobAvailable.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+                if (mStopping && mJobs.empty())
+                    return;
+                job = std::move(mJobs.front());
+                mJobs.pop_front();
+                mActiveJobs++;
+            }
+
+            {
+                OGLR_PROFILE_ZONE("Job");
+                job();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mActiveJobs--;
+                if (mJobs.empty() && mActiveJobs == 0)
+                    mJobsDone.notify_all();
+            }
+        }
+    }
+
+}